@@ -0,0 +1,85 @@
+/*
+ * AllocationCounter.h - Heap allocation counter for the DMR core task of ESP32 MMDVM Hotspot
+ *
+ * Counts heap allocations (malloc, String growth, new) made by one task, so the
+ * status page can show that dispatching a DMRD frame allocates nothing: the core
+ * task reads the count before and after each frame and records the difference.
+ * Frames that start or end a call, or identify it (late entry, talker alias),
+ * log a line and may look up the station, so they are counted separately from
+ * the steady frames of a running call.
+ *
+ * The count comes from the ESP-IDF heap hooks (esp_heap_trace_alloc_hook), which
+ * are only called when the ESP32 core was built with CONFIG_HEAP_USE_HOOKS
+ * (ESP-IDF 5.1+). Without them the counter reports itself unavailable. The hooks
+ * are defined once, in the sketch, since the heap links exactly one of each.
+ */
+
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <Arduino.h>
+
+#if defined(CONFIG_HEAP_USE_HOOKS) && CONFIG_HEAP_USE_HOOKS
+#define ALLOCATION_COUNTER_HOOKS 1
+#else
+#define ALLOCATION_COUNTER_HOOKS 0
+#endif
+
+// Written by the heap hook, which may run with the flash cache disabled: plain DRAM globals
+inline volatile TaskHandle_t allocationCounterTask = NULL;
+inline volatile uint32_t allocationCounterCount = 0;
+
+// Per-frame allocation statistics (copied out for the web interface)
+struct AllocationStats {
+  bool available;            // Heap hooks compiled in (CONFIG_HEAP_USE_HOOKS)
+  uint32_t frames;           // Steady DMRD frames measured
+  uint32_t allocFrames;      // ... during which the task allocated
+  uint32_t allocs;           // Allocations during steady frames
+  uint32_t eventFrames;      // Frames that started, ended or identified a call
+  uint32_t eventAllocs;      // Allocations during those frames
+};
+
+class AllocationCounter {
+private:
+  AllocationStats stats;
+  portMUX_TYPE mux;
+
+public:
+  AllocationCounter() : mux(portMUX_INITIALIZER_UNLOCKED) {
+    memset(&stats, 0, sizeof(stats));
+    stats.available = ALLOCATION_COUNTER_HOOKS;
+  }
+
+  // Count the allocations of this task (the DMR core task)
+  void watch(TaskHandle_t task) {
+    allocationCounterTask = task;
+  }
+
+  // Allocations by the watched task so far
+  uint32_t count() const {
+    return allocationCounterCount;
+  }
+
+  // One dispatched frame and the allocations made while handling it
+  void recordFrame(bool callEvent, uint32_t allocs) {
+    portENTER_CRITICAL(&mux);
+    if (callEvent) {
+      stats.eventFrames++;
+      stats.eventAllocs += allocs;
+    } else {
+      stats.frames++;
+      stats.allocs += allocs;
+      if (allocs > 0) stats.allocFrames++;
+    }
+    portEXIT_CRITICAL(&mux);
+  }
+
+  AllocationStats getStats() {
+    portENTER_CRITICAL(&mux);
+    AllocationStats copy = stats;
+    portEXIT_CRITICAL(&mux);
+    return copy;
+  }
+};
+
+#endif // ALLOCATION_COUNTER_H
@@ -0,0 +1,160 @@
+/*
+ * DMRDefines.h - DMR / Homebrew DMRD constants shared by the DMR components
+ * of the ESP32 MMDVM Hotspot (jitter buffer, uplink encoder, DMRD view)
+ */
+
+#ifndef DMR_DEFINES_H
+#define DMR_DEFINES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define DMR_PAYLOAD_LENGTH 33  // One burst: 2 x 108 payload bits around 48 sync / EMB bits (+ slot type)
+#define DMR_FRAME_MS 60        // One burst per slot per TDMA frame
+
+// Homebrew DMRD packet (55 bytes)
+#define DMRD_PACKET_LENGTH 55
+#define DMRD_SEQ_OFFSET 4
+#define DMRD_SRC_OFFSET 5
+#define DMRD_DST_OFFSET 8
+#define DMRD_REPEATER_OFFSET 11
+#define DMRD_FLAGS_OFFSET 15
+#define DMRD_STREAM_OFFSET 16
+#define DMRD_PAYLOAD_OFFSET 20
+#define DMRD_BER_OFFSET 53
+#define DMRD_RSSI_OFFSET 54
+
+// Homebrew DMRD flags byte (packet[15])
+#define DMRD_FLAG_SLOT2 0x80
+#define DMRD_FLAG_PRIVATE 0x40
+#define DMRD_FRAME_TYPE_MASK 0x30
+#define DMRD_FRAME_VOICE 0x00
+#define DMRD_FRAME_VOICE_SYNC 0x10
+#define DMRD_FRAME_DATA_SYNC 0x20
+#define DMRD_DTYPE_MASK 0x0F      // Data type, or voice burst position (0 = A .. 5 = F)
+#define DMRD_DTYPE_TERMINATOR 0x02
+
+// Terminator with LC: data sync and data type 2. Voice bursts keep their
+// position (A = 0 .. F = 5) in the same bits, so burst C has the low bits 2 too.
+inline bool dmrdIsTerminator(uint8_t flags) {
+  return (flags & DMRD_FRAME_TYPE_MASK) == DMRD_FRAME_DATA_SYNC && (flags & DMRD_DTYPE_MASK) == DMRD_DTYPE_TERMINATOR;
+}
+
+// Read-only view of a received DMRD packet: the fields are decoded from the
+// buffer on access, nothing is copied. Valid as long as the buffer is.
+struct DmrdView {
+  static constexpr size_t LENGTH = DMRD_PACKET_LENGTH;
+  static constexpr size_t SEQ = DMRD_SEQ_OFFSET;
+  static constexpr size_t SRC = DMRD_SRC_OFFSET;
+  static constexpr size_t DST = DMRD_DST_OFFSET;
+  static constexpr size_t REPEATER = DMRD_REPEATER_OFFSET;
+  static constexpr size_t FLAGS = DMRD_FLAGS_OFFSET;
+  static constexpr size_t STREAM = DMRD_STREAM_OFFSET;
+  static constexpr size_t PAYLOAD = DMRD_PAYLOAD_OFFSET;
+  static constexpr size_t BER = DMRD_BER_OFFSET;
+  static constexpr size_t RSSI = DMRD_RSSI_OFFSET;
+
+  const uint8_t* packet;
+
+  explicit constexpr DmrdView(const uint8_t* data) : packet(data) {}
+
+  // "DMRD" magic and the full 55 bytes
+  static bool valid(const uint8_t* data, size_t length) {
+    return length >= LENGTH && memcmp(data, "DMRD", 4) == 0;
+  }
+
+  constexpr uint8_t seq() const { return packet[SEQ]; }
+  constexpr uint32_t srcId() const { return read24(SRC); }
+  constexpr uint32_t dstId() const { return read24(DST); }
+  constexpr uint32_t repeaterId() const { return read32(REPEATER); }
+  constexpr uint8_t flags() const { return packet[FLAGS]; }
+  constexpr uint8_t slotNo() const { return (packet[FLAGS] & DMRD_FLAG_SLOT2) ? 2 : 1; }
+  constexpr bool isGroup() const { return (packet[FLAGS] & DMRD_FLAG_PRIVATE) == 0; }
+  constexpr bool dataSync() const { return (packet[FLAGS] & DMRD_FRAME_DATA_SYNC) != 0; }
+  constexpr bool voiceSync() const { return (packet[FLAGS] & DMRD_FRAME_VOICE_SYNC) != 0; }
+  constexpr uint8_t dataType() const { return packet[FLAGS] & DMRD_DTYPE_MASK; }  // Or voice burst position
+  constexpr uint32_t streamId() const { return read32(STREAM); }
+  constexpr const uint8_t* payload() const { return &packet[PAYLOAD]; }     // DMR_PAYLOAD_LENGTH bytes
+  constexpr uint8_t ber() const { return packet[BER]; }
+  constexpr uint8_t rssi() const { return packet[RSSI]; }
+
+private:
+  constexpr uint32_t read24(size_t offset) const {
+    return ((uint32_t)packet[offset] << 16) | ((uint32_t)packet[offset + 1] << 8) | packet[offset + 2];
+  }
+  constexpr uint32_t read32(size_t offset) const {
+    return ((uint32_t)packet[offset] << 24) | read24(offset + 1);
+  }
+};
+
+// DMR data types (slot type field)
+#define DMR_DT_VOICE_LC_HEADER 0x01
+#define DMR_DT_TERMINATOR_WITH_LC 0x02
+#define DMR_DT_CSBK 0x03
+#define DMR_DT_DATA_HEADER 0x06
+#define DMR_DT_IDLE 0x09
+
+// Frame type of a DMRD packet as shown on the dashboard (decoded from the flags byte)
+enum class DMR_FRAME_TYPE : uint8_t {
+  PI_HEADER,
+  VOICE_LC_HDR,
+  TERM_LC,
+  CSBK,
+  DATA_HDR,
+  RATE_1_2_DATA,
+  RATE_3_4_DATA,
+  IDLE,
+  RATE_1_DATA,
+  VOICE,        // Voice sync burst (A)
+  VOICE_BURST,  // Voice bursts B-F
+  UNKNOWN
+};
+
+inline DMR_FRAME_TYPE dmrdFrameType(uint8_t flags) {
+  if (!(flags & DMRD_FRAME_DATA_SYNC)) {
+    return (flags & DMRD_FRAME_VOICE_SYNC) ? DMR_FRAME_TYPE::VOICE : DMR_FRAME_TYPE::VOICE_BURST;
+  }
+  switch (flags & DMRD_DTYPE_MASK) {
+    case 0x00: return DMR_FRAME_TYPE::PI_HEADER;
+    case DMR_DT_VOICE_LC_HEADER: return DMR_FRAME_TYPE::VOICE_LC_HDR;
+    case DMR_DT_TERMINATOR_WITH_LC: return DMR_FRAME_TYPE::TERM_LC;
+    case DMR_DT_CSBK: return DMR_FRAME_TYPE::CSBK;
+    case DMR_DT_DATA_HEADER: return DMR_FRAME_TYPE::DATA_HDR;
+    case 0x07: return DMR_FRAME_TYPE::RATE_1_2_DATA;
+    case 0x08: return DMR_FRAME_TYPE::RATE_3_4_DATA;
+    case DMR_DT_IDLE: return DMR_FRAME_TYPE::IDLE;
+    case 0x0A: return DMR_FRAME_TYPE::RATE_1_DATA;
+    default: return DMR_FRAME_TYPE::UNKNOWN;
+  }
+}
+
+inline const char* dmrFrameTypeName(DMR_FRAME_TYPE type) {
+  static const char* const names[] = { "PI_HEADER", "VOICE_LC_HDR", "TERM_LC", "CSBK", "DATA_HDR", "RATE_1/2_DATA",
+                                       "RATE_3/4_DATA", "IDLE", "RATE_1_DATA", "VOICE", "VOICE_BURST", "UNKNOWN" };
+  return names[(uint8_t)type <= (uint8_t)DMR_FRAME_TYPE::UNKNOWN ? (uint8_t)type : (uint8_t)DMR_FRAME_TYPE::UNKNOWN];
+}
+
+// Control byte in front of the burst in MMDVM CMD_DMR_DATA1/2 frames (payload[0])
+#define MMDVM_DMR_SYNC_DATA 0x40   // Data sync burst, low nibble = data type
+#define MMDVM_DMR_SYNC_VOICE 0x20  // Voice sync burst (A); voice bursts B-F carry 1-5
+
+// Full LC (voice LC header / terminator)
+#define DMR_FLCO_GROUP 0x00
+#define DMR_FLCO_USER_USER 0x03
+#define DMR_FLCO_TALKER_ALIAS_HEADER 0x04  // Talker alias in the embedded LC (blocks 1-3 = 0x05-0x07)
+#define DMR_FLCO_TALKER_ALIAS_BLOCK3 0x07
+
+// Talker alias text formats (2 bits in the talker alias header)
+#define DMR_TA_FORMAT_7BIT 0
+#define DMR_TA_FORMAT_ISO8 1
+#define DMR_TA_FORMAT_UTF8 2
+#define DMR_TA_FORMAT_UTF16 3
+
+// EMB link control start / stop: which embedded LC fragment a voice burst carries
+#define DMR_LCSS_SINGLE 0        // Single fragment (RC / null), usually burst F
+#define DMR_LCSS_FIRST 1         // Burst B
+#define DMR_LCSS_LAST 2          // Burst E
+#define DMR_LCSS_CONTINUATION 3  // Bursts C and D
+
+#endif // DMR_DEFINES_H
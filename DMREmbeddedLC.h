@@ -0,0 +1,107 @@
+/*
+ * DMREmbeddedLC.h - Embedded LC assembler for ESP32 MMDVM Hotspot
+ *
+ * Voice bursts B-E of every superframe carry the call's LC in four 32-bit
+ * fragments, marked by the EMB LCSS (first / continuation / continuation / last).
+ * A station that joins a call mid-stream (late entry: no voice LC header seen)
+ * can identify the talker from them within one superframe (360 ms).
+ * One assembler per slot: a fixed state machine over four words, so feeding a
+ * burst never allocates. Any FLCO is returned; callers pick the ones they need.
+ * No Arduino dependencies, so it also builds on a host.
+ */
+
+#ifndef DMR_EMBEDDED_LC_H
+#define DMR_EMBEDDED_LC_H
+
+#include <stdint.h>
+#include <string.h>
+#include "DMRDefines.h"
+#include "DMRFEC.h"
+
+class DMREmbeddedLC {
+private:
+  enum State : uint8_t {
+    WAIT_FIRST,   // Waiting for burst B (LCSS first)
+    WAIT_SECOND,  // Burst B stored, expecting C (continuation)
+    WAIT_THIRD,   // Expecting D (continuation)
+    WAIT_LAST     // Expecting E (LCSS last)
+  };
+
+  uint32_t fragments[4];
+  State state;
+  uint32_t decoded;  // Embedded LCs that passed Hamming, parity and checksum
+  uint32_t failed;   // Complete sets of four fragments that did not
+
+public:
+  DMREmbeddedLC() : state(WAIT_FIRST), decoded(0), failed(0) {
+    memset(fragments, 0, sizeof(fragments));
+  }
+
+  // Start over (new call, header / terminator seen)
+  void reset() {
+    state = WAIT_FIRST;
+  }
+
+  /*
+   * Feed one voice burst B-F (33 bytes; not the voice sync burst A, which has no EMB).
+   * Returns true when this burst completed an embedded LC that decoded cleanly;
+   * lc then holds its 9 bytes (FLCO/FID/options + 6 bytes depending on the FLCO).
+   */
+  bool add(const uint8_t* burst, uint8_t* lc) {
+    uint8_t colorCode;
+    bool pi;
+    uint8_t lcss;
+    if (dmrEmbDecode(burst, colorCode, pi, lcss) < 0) {
+      state = WAIT_FIRST;  // Can't tell which fragment this is
+      return false;
+    }
+
+    uint32_t fragment = dmrEmbeddedFragmentRead(burst);
+    switch (lcss) {
+      case DMR_LCSS_FIRST:
+        fragments[0] = fragment;
+        state = WAIT_SECOND;
+        return false;
+
+      case DMR_LCSS_CONTINUATION:
+        if (state == WAIT_SECOND) {
+          fragments[1] = fragment;
+          state = WAIT_THIRD;
+        } else if (state == WAIT_THIRD) {
+          fragments[2] = fragment;
+          state = WAIT_LAST;
+        } else {
+          state = WAIT_FIRST;
+        }
+        return false;
+
+      case DMR_LCSS_LAST:
+        if (state != WAIT_LAST) {
+          state = WAIT_FIRST;
+          return false;
+        }
+        fragments[3] = fragment;
+        state = WAIT_FIRST;
+        if (dmrEmbeddedLCDecode(fragments, lc)) {
+          decoded++;
+          return true;
+        }
+        failed++;
+        return false;
+
+      default:
+        // Single fragment (reverse channel / null) in burst F: not part of the LC
+        return false;
+    }
+  }
+
+  uint32_t getDecoded() const {
+    return decoded;
+  }
+
+  uint32_t getFailed() const {
+    return failed;
+  }
+};
+
+#endif // DMR_EMBEDDED_LC_H
@@ -0,0 +1,726 @@
+/*
+ * DMRFEC.h - DMR forward error correction for ESP32 MMDVM Hotspot
+ *
+ * The codes ETSI TS 102 361-1 uses around a DMR burst, table driven with the
+ * tables generated at compile time (constexpr, so they live in flash):
+ * - BPTC(196,96): full LC of voice LC headers / terminators (Hamming(15,11,3)
+ *   rows, Hamming(13,9,3) columns, interleave a * 181 mod 196)
+ * - Golay(20,8): slot type (colour code + data type)
+ * - QR(16,7,6): EMB (colour code, PI, LCSS) of voice bursts B-F
+ * - Hamming(16,11,4): embedded LC (16 x 8 matrix with column parity and a
+ *   5-bit checksum, sent as four 32-bit fragments in voice bursts B-E)
+ * - RS(12,9) over GF(2^8): full LC parity, XORed with the data type's CRC mask
+ * - Short LC (CACH): Hamming(17,12,3) rows + column parity, CRC-8 (encode only)
+ * Bit order follows MMDVMHost: burst bit 0 is the MSB of byte 0, payload bits
+ * 0-97 and 166-263 surround the slot type (98-107, 156-165) and sync / EMB
+ * (108-155). No Arduino dependencies, so it also builds on a host.
+ */
+
+#ifndef DMR_FEC_H
+#define DMR_FEC_H
+
+#include <stdint.h>
+#include <string.h>
+#include "DMRDefines.h"
+
+// RS(12,9) parity masks (ETSI TS 102 361-1 B.3.12)
+#define DMR_LC_HEADER_CRC_MASK 0x96
+#define DMR_LC_TERMINATOR_CRC_MASK 0x99
+
+// ---------------------------------------------------------------------------
+// Hamming codes. A codeword is packed into a uint16_t with d[i] at bit i: data
+// bits 0..K-1, parity bits K.. after them. Each check mask lists the bits one
+// parity equation covers (including its own parity bit).
+// ---------------------------------------------------------------------------
+
+template<uint8_t CHECKS>
+struct DMRHammingTable {
+  uint8_t lo[256];      // Syndrome contribution of bits 0-7
+  uint8_t hi[256];      // ... and of bits 8-15
+  int8_t fix[1 << CHECKS];  // Bit to flip for a syndrome (-1: uncorrectable)
+
+  constexpr DMRHammingTable(const uint16_t (&checks)[CHECKS], uint8_t length) : lo(), hi(), fix() {
+    for (uint16_t v = 0; v < 256; v++) {
+      uint8_t l = 0;
+      uint8_t h = 0;
+      for (uint8_t k = 0; k < CHECKS; k++) {
+        uint8_t pl = 0;
+        uint8_t ph = 0;
+        for (uint8_t b = 0; b < 8; b++) {
+          if ((v >> b) & 1) {
+            pl ^= (checks[k] >> b) & 1;
+            ph ^= (checks[k] >> (b + 8)) & 1;
+          }
+        }
+        l |= pl << k;
+        h |= ph << k;
+      }
+      lo[v] = l;
+      hi[v] = h;
+    }
+    for (uint16_t s = 0; s < (1 << CHECKS); s++) fix[s] = -1;
+    for (uint8_t b = 0; b < length; b++) {
+      uint8_t s = 0;
+      for (uint8_t k = 0; k < CHECKS; k++) s |= ((checks[k] >> b) & 1) << k;
+      fix[s] = (int8_t)b;
+    }
+  }
+
+  uint8_t syndrome(uint16_t word) const {
+    return lo[word & 0xFF] ^ hi[word >> 8];
+  }
+
+  // Data bits in, parity bits (placed at bit `dataBits`) added
+  uint16_t encode(uint16_t data, uint8_t dataBits) const {
+    return data | ((uint16_t)syndrome(data) << dataBits);
+  }
+
+  // Returns bits corrected (0/1) or -1 if the error can't be corrected
+  int8_t decode(uint16_t &word) const {
+    uint8_t s = syndrome(word);
+    if (s == 0) return 0;
+    if (fix[s] < 0) return -1;
+    word ^= (uint16_t)1 << fix[s];
+    return 1;
+  }
+};
+
+// MMDVMHost CHamming::encode15113_2 / encode1393 / encode16114 equations
+constexpr uint16_t DMR_HAMMING_15113_CHECKS[4] = {
+  (1 << 0) | (1 << 1) | (1 << 2) | (1 << 3) | (1 << 5) | (1 << 7) | (1 << 8) | (1 << 11),
+  (1 << 1) | (1 << 2) | (1 << 3) | (1 << 4) | (1 << 6) | (1 << 8) | (1 << 9) | (1 << 12),
+  (1 << 2) | (1 << 3) | (1 << 4) | (1 << 5) | (1 << 7) | (1 << 9) | (1 << 10) | (1 << 13),
+  (1 << 0) | (1 << 1) | (1 << 2) | (1 << 4) | (1 << 6) | (1 << 7) | (1 << 10) | (1 << 14)
+};
+constexpr uint16_t DMR_HAMMING_1393_CHECKS[4] = {
+  (1 << 0) | (1 << 1) | (1 << 3) | (1 << 5) | (1 << 6) | (1 << 9),
+  (1 << 0) | (1 << 1) | (1 << 2) | (1 << 4) | (1 << 6) | (1 << 7) | (1 << 10),
+  (1 << 0) | (1 << 1) | (1 << 2) | (1 << 3) | (1 << 5) | (1 << 7) | (1 << 8) | (1 << 11),
+  (1 << 0) | (1 << 2) | (1 << 4) | (1 << 5) | (1 << 8) | (1 << 12)
+};
+constexpr uint16_t DMR_HAMMING_16114_CHECKS[5] = {
+  (1 << 0) | (1 << 1) | (1 << 2) | (1 << 3) | (1 << 5) | (1 << 7) | (1 << 8) | (1 << 11),
+  (1 << 1) | (1 << 2) | (1 << 3) | (1 << 4) | (1 << 6) | (1 << 8) | (1 << 9) | (1 << 12),
+  (1 << 2) | (1 << 3) | (1 << 4) | (1 << 5) | (1 << 7) | (1 << 9) | (1 << 10) | (1 << 13),
+  (1 << 0) | (1 << 1) | (1 << 2) | (1 << 4) | (1 << 6) | (1 << 7) | (1 << 10) | (1 << 14),
+  (1 << 0) | (1 << 2) | (1 << 5) | (1 << 6) | (1 << 8) | (1 << 9) | (1 << 10) | (1 << 15)
+};
+
+constexpr DMRHammingTable<4> dmrHamming15113(DMR_HAMMING_15113_CHECKS, 15);
+constexpr DMRHammingTable<4> dmrHamming1393(DMR_HAMMING_1393_CHECKS, 13);
+constexpr DMRHammingTable<5> dmrHamming16114(DMR_HAMMING_16114_CHECKS, 16);
+
+// ---------------------------------------------------------------------------
+// Golay(20,8): extended Golay(24,12) (g = 0xC75) shortened by four data bits.
+// Codeword bits 19-12 = data, 11-1 = remainder, 0 = overall parity.
+// ---------------------------------------------------------------------------
+
+constexpr uint16_t dmrGolayParity(uint8_t data) {
+  uint32_t r = (uint32_t)data << 11;
+  for (int8_t b = 18; b >= 11; b--) {
+    if (r & ((uint32_t)1 << b)) r ^= (uint32_t)0xC75 << (b - 11);
+  }
+  uint8_t weight = 0;
+  for (uint8_t b = 0; b < 11; b++) weight += (r >> b) & 1;
+  for (uint8_t b = 0; b < 8; b++) weight += (data >> b) & 1;
+  return (uint16_t)((r << 1) | (weight & 1));
+}
+
+struct DMRGolayTables {
+  uint16_t parity[256];
+  uint32_t error[4096];  // Error pattern (<= 3 bits) for a syndrome, 0xFFFFFFFF if none
+
+  constexpr DMRGolayTables() : parity(), error() {
+    for (uint16_t d = 0; d < 256; d++) parity[d] = dmrGolayParity((uint8_t)d);
+    for (uint16_t s = 0; s < 4096; s++) error[s] = 0xFFFFFFFF;
+    error[0] = 0;
+    for (uint8_t a = 0; a < 20; a++) {
+      add((uint32_t)1 << a);
+      for (uint8_t b = a + 1; b < 20; b++) {
+        add(((uint32_t)1 << a) | ((uint32_t)1 << b));
+        for (uint8_t c = b + 1; c < 20; c++) {
+          add(((uint32_t)1 << a) | ((uint32_t)1 << b) | ((uint32_t)1 << c));
+        }
+      }
+    }
+  }
+
+  constexpr void add(uint32_t pattern) {
+    uint16_t s = parity[(pattern >> 12) & 0xFF] ^ (pattern & 0xFFF);
+    error[s] = pattern;
+  }
+};
+
+constexpr DMRGolayTables dmrGolay;
+
+inline uint32_t dmrGolay2087Encode(uint8_t data) {
+  return ((uint32_t)data << 12) | dmrGolay.parity[data];
+}
+
+// Returns bits corrected (0-3) or -1; data is the corrected data byte
+inline int8_t dmrGolay2087Decode(uint32_t codeword, uint8_t &data) {
+  uint16_t s = dmrGolay.parity[(codeword >> 12) & 0xFF] ^ (codeword & 0xFFF);
+  uint32_t e = dmrGolay.error[s];
+  if (e == 0xFFFFFFFF) return -1;
+  codeword ^= e;
+  data = (uint8_t)(codeword >> 12);
+  int8_t n = 0;
+  for (; e != 0; e &= e - 1) n++;
+  return n;
+}
+
+// ---------------------------------------------------------------------------
+// QR(16,7,6): QR(17,9) (g = 0x139) shortened by two data bits plus overall parity.
+// Codeword bits 15-9 = data, 8-1 = remainder, 0 = overall parity.
+// ---------------------------------------------------------------------------
+
+constexpr uint16_t dmrQRParity(uint8_t data) {
+  uint16_t r = (uint16_t)data << 8;
+  for (int8_t b = 14; b >= 8; b--) {
+    if (r & (1 << b)) r ^= 0x139 << (b - 8);
+  }
+  uint8_t weight = 0;
+  for (uint8_t b = 0; b < 8; b++) weight += (r >> b) & 1;
+  for (uint8_t b = 0; b < 7; b++) weight += (data >> b) & 1;
+  return (uint16_t)((r << 1) | (weight & 1));
+}
+
+struct DMRQRTables {
+  uint16_t parity[128];
+  uint16_t error[512];  // Error pattern (<= 2 bits) for a syndrome, 0xFFFF if none
+
+  constexpr DMRQRTables() : parity(), error() {
+    for (uint8_t d = 0; d < 128; d++) parity[d] = dmrQRParity(d);
+    for (uint16_t s = 0; s < 512; s++) error[s] = 0xFFFF;
+    error[0] = 0;
+    for (uint8_t a = 0; a < 16; a++) {
+      add(1 << a);
+      for (uint8_t b = a + 1; b < 16; b++) add((1 << a) | (1 << b));
+    }
+  }
+
+  constexpr void add(uint16_t pattern) {
+    error[parity[pattern >> 9] ^ (pattern & 0x1FF)] = pattern;
+  }
+};
+
+constexpr DMRQRTables dmrQR;
+
+inline uint16_t dmrQR1676Encode(uint8_t data) {
+  return (uint16_t)(((data & 0x7F) << 9) | dmrQR.parity[data & 0x7F]);
+}
+
+// Returns bits corrected (0-2) or -1; data is the corrected 7-bit value
+inline int8_t dmrQR1676Decode(uint16_t codeword, uint8_t &data) {
+  uint16_t e = dmrQR.error[dmrQR.parity[codeword >> 9] ^ (codeword & 0x1FF)];
+  if (e == 0xFFFF) return -1;
+  data = (uint8_t)((codeword ^ e) >> 9);
+  return (e == 0) ? 0 : ((e & (e - 1)) ? 2 : 1);
+}
+
+// ---------------------------------------------------------------------------
+// RS(12,9) over GF(2^8), field polynomial 0x11D, g(x) = (x + a)(x + a^2)(x + a^3)
+// = x^3 + 14x^2 + 56x + 64. Parity is stored reversed (lc[9] = parity[2]).
+// ---------------------------------------------------------------------------
+
+struct DMRGaloisTables {
+  uint8_t exp[512];
+  uint8_t log[256];
+
+  constexpr DMRGaloisTables() : exp(), log() {
+    uint16_t x = 1;
+    for (uint16_t i = 0; i < 255; i++) {
+      exp[i] = (uint8_t)x;
+      exp[i + 255] = (uint8_t)x;
+      log[x] = (uint8_t)i;
+      x <<= 1;
+      if (x & 0x100) x ^= 0x11D;
+    }
+    exp[510] = exp[0];
+    exp[511] = exp[1];
+  }
+};
+
+constexpr DMRGaloisTables dmrGF;
+
+inline uint8_t dmrGFMul(uint8_t a, uint8_t b) {
+  return (a == 0 || b == 0) ? 0 : dmrGF.exp[dmrGF.log[a] + dmrGF.log[b]];
+}
+
+// Parity of the 9 LC bytes, already in wire order and XORed with the mask
+inline void dmrRS129Parity(const uint8_t* lc, uint8_t mask, uint8_t* parity) {
+  static const uint8_t poly[3] = { 64, 56, 14 };
+  uint8_t p[3] = { 0, 0, 0 };
+  for (uint8_t i = 0; i < 9; i++) {
+    uint8_t feedback = lc[i] ^ p[2];
+    p[2] = p[1] ^ dmrGFMul(poly[2], feedback);
+    p[1] = p[0] ^ dmrGFMul(poly[1], feedback);
+    p[0] = dmrGFMul(poly[0], feedback);
+  }
+  parity[0] = p[2] ^ mask;
+  parity[1] = p[1] ^ mask;
+  parity[2] = p[0] ^ mask;
+}
+
+inline void dmrRS129Encode(uint8_t* lc, uint8_t mask) {
+  dmrRS129Parity(lc, mask, &lc[9]);
+}
+
+// Check / correct a 12-byte full LC. Returns bytes corrected (0/1) or -1.
+inline int8_t dmrRS129Decode(uint8_t* lc, uint8_t mask) {
+  uint8_t s[3] = { 0, 0, 0 };
+  for (uint8_t j = 0; j < 3; j++) {
+    // Syndrome S(j+1) = c(a^(j+1)), lc[0] is the highest-degree coefficient
+    uint8_t acc = 0;
+    uint8_t root = dmrGF.exp[j + 1];
+    for (uint8_t i = 0; i < 12; i++) {
+      uint8_t c = (i < 9) ? lc[i] : (uint8_t)(lc[i] ^ mask);
+      acc = dmrGFMul(acc, root) ^ c;
+    }
+    s[j] = acc;
+  }
+  if (s[0] == 0 && s[1] == 0 && s[2] == 0) return 0;
+  if (s[0] == 0 || s[1] == 0) return -1;
+
+  // Single error of value e at degree d: S1 = e a^d, S2 = e a^2d, S3 = e a^3d
+  uint8_t d = (uint8_t)((dmrGF.log[s[1]] + 255 - dmrGF.log[s[0]]) % 255);
+  if (d > 11 || dmrGFMul(s[1], s[1]) != dmrGFMul(s[0], s[2])) return -1;
+  uint8_t e = dmrGF.exp[(2 * dmrGF.log[s[0]] + 255 - dmrGF.log[s[1]]) % 255];
+  lc[11 - d] ^= e;
+  return 1;
+}
+
+// ---------------------------------------------------------------------------
+// BPTC(196,96)
+// ---------------------------------------------------------------------------
+
+struct DMRBPTCTables {
+  uint16_t burstBit[196];  // Deinterleaved matrix position -> burst bit
+
+  constexpr DMRBPTCTables() : burstBit() {
+    for (uint16_t a = 0; a < 196; a++) {
+      uint16_t raw = (uint16_t)((a * 181) % 196);
+      burstBit[a] = (raw < 98) ? raw : (uint16_t)(raw + 68);
+    }
+  }
+};
+
+constexpr DMRBPTCTables dmrBPTC;
+
+// 13 x 15 matrix, row r bit c = deinterleaved bit r * 15 + 1 + c
+inline void dmrBPTCRead(const uint8_t* burst, uint16_t* rows) {
+  memset(rows, 0, 13 * sizeof(uint16_t));
+  for (uint8_t a = 1; a < 196; a++) {
+    uint16_t bit = dmrBPTC.burstBit[a];
+    if (burst[bit >> 3] & (0x80 >> (bit & 7))) {
+      rows[(a - 1) / 15] |= (uint16_t)1 << ((a - 1) % 15);
+    }
+  }
+}
+
+// One Hamming(15,11,3) pass over the nine data rows; returns false if a row had a syndrome
+inline bool dmrBPTCRows(uint16_t* rows, int16_t &corrected) {
+  bool clean = true;
+  for (uint8_t r = 0; r < 9; r++) {
+    int8_t n = dmrHamming15113.decode(rows[r]);
+    if (n != 0) clean = false;
+    if (n > 0) corrected += n;
+  }
+  return clean;
+}
+
+// One Hamming(13,9,3) pass over the 15 columns
+inline bool dmrBPTCColumns(uint16_t* rows, int16_t &corrected) {
+  bool clean = true;
+  for (uint8_t c = 0; c < 15; c++) {
+    uint16_t col = 0;
+    for (uint8_t r = 0; r < 13; r++) col |= ((rows[r] >> c) & 1) << r;
+    int8_t n = dmrHamming1393.decode(col);
+    if (n != 0) clean = false;
+    if (n > 0) {
+      corrected += n;
+      for (uint8_t r = 0; r < 13; r++) {
+        rows[r] = (rows[r] & ~((uint16_t)1 << c)) | (((col >> r) & 1) << c);
+      }
+    }
+  }
+  return clean;
+}
+
+/*
+ * Decode the 12-byte full LC (or other 96-bit payload) of a data burst with up to
+ * five row / column passes. Returns bits corrected, or -1 if errors remain (data
+ * holds the best effort either way). Two errors in one column or row can make the
+ * first code of a pass miscorrect, so callers with a separate check (RS) retry
+ * with the other order (rowsFirst = false) when the first result fails it.
+ */
+inline int16_t dmrBPTCDecode(const uint8_t* burst, uint8_t* data, bool rowsFirst = true) {
+  uint16_t rows[13];
+  dmrBPTCRead(burst, rows);
+
+  int16_t corrected = 0;
+  bool clean = false;
+  for (uint8_t pass = 0; pass < 5 && !clean; pass++) {
+    if (rowsFirst) {
+      clean = dmrBPTCRows(rows, corrected);
+      clean = dmrBPTCColumns(rows, corrected) && clean;
+    } else {
+      clean = dmrBPTCColumns(rows, corrected);
+      clean = dmrBPTCRows(rows, corrected) && clean;
+    }
+  }
+  if (!clean) {
+    // The last pass corrected something: only fail if syndromes are left
+    int16_t ignored = 0;
+    uint16_t check[13];
+    memcpy(check, rows, sizeof(check));
+    if (!dmrBPTCRows(check, ignored) || !dmrBPTCColumns(check, ignored)) corrected = -1;
+  }
+
+  // Data: row 0 columns 3-10, rows 1-8 columns 0-10
+  memset(data, 0, 12);
+  uint8_t pos = 0;
+  for (uint8_t r = 0; r < 9; r++) {
+    for (uint8_t c = (r == 0) ? 3 : 0; c <= 10; c++, pos++) {
+      if ((rows[r] >> c) & 1) data[pos >> 3] |= 0x80 >> (pos & 7);
+    }
+  }
+  return corrected;
+}
+
+// Encode 12 bytes into the payload bits of a burst (slot type / sync bits are kept)
+inline void dmrBPTCEncode(const uint8_t* data, uint8_t* burst) {
+  uint16_t rows[13];
+  memset(rows, 0, sizeof(rows));
+  uint8_t pos = 0;
+  for (uint8_t r = 0; r < 9; r++) {
+    uint16_t row = 0;
+    for (uint8_t c = (r == 0) ? 3 : 0; c <= 10; c++, pos++) {
+      if (data[pos >> 3] & (0x80 >> (pos & 7))) row |= (uint16_t)1 << c;
+    }
+    rows[r] = dmrHamming15113.encode(row, 11);
+  }
+  for (uint8_t c = 0; c < 15; c++) {
+    uint16_t col = 0;
+    for (uint8_t r = 0; r < 9; r++) col |= ((rows[r] >> c) & 1) << r;
+    col = dmrHamming1393.encode(col, 9);
+    for (uint8_t r = 9; r < 13; r++) rows[r] |= ((col >> r) & 1) << c;
+  }
+  for (uint8_t a = 0; a < 196; a++) {
+    uint16_t bit = dmrBPTC.burstBit[a];
+    bool set = (a > 0) && ((rows[(a - 1) / 15] >> ((a - 1) % 15)) & 1);
+    if (set) {
+      burst[bit >> 3] |= 0x80 >> (bit & 7);
+    } else {
+      burst[bit >> 3] &= ~(0x80 >> (bit & 7));
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Burst fields
+// ---------------------------------------------------------------------------
+
+// Slot type: 10 bits at burst bits 98-107 and 10 at 156-165. Returns bits corrected or -1.
+inline int8_t dmrSlotTypeDecode(const uint8_t* burst, uint8_t &colorCode, uint8_t &dataType) {
+  uint32_t codeword = ((uint32_t)(burst[12] & 0x3F) << 14) | ((uint32_t)(burst[13] >> 4) << 10) |
+                      ((uint32_t)(burst[19] & 0x0F) << 6) | (burst[20] >> 2);
+  uint8_t data = 0;
+  int8_t n = dmrGolay2087Decode(codeword, data);
+  colorCode = data >> 4;
+  dataType = data & 0x0F;
+  return n;
+}
+
+inline void dmrSlotTypeEncode(uint8_t* burst, uint8_t colorCode, uint8_t dataType) {
+  uint32_t codeword = dmrGolay2087Encode((uint8_t)((colorCode << 4) | (dataType & 0x0F)));
+  burst[12] = (burst[12] & 0xC0) | ((codeword >> 14) & 0x3F);
+  burst[13] = (burst[13] & 0x0F) | (uint8_t)(((codeword >> 10) & 0x0F) << 4);
+  burst[19] = (burst[19] & 0xF0) | ((codeword >> 6) & 0x0F);
+  burst[20] = (burst[20] & 0x03) | (uint8_t)((codeword & 0x3F) << 2);
+}
+
+// EMB of voice bursts B-F: 8 bits at burst bits 108-115 and 8 at 148-155. Returns bits corrected or -1.
+inline int8_t dmrEmbDecode(const uint8_t* burst, uint8_t &colorCode, bool &pi, uint8_t &lcss) {
+  uint16_t codeword = ((uint16_t)(((burst[13] << 4) & 0xF0) | (burst[14] >> 4)) << 8) |
+                      (uint8_t)(((burst[18] << 4) & 0xF0) | (burst[19] >> 4));
+  uint8_t data = 0;
+  int8_t n = dmrQR1676Decode(codeword, data);
+  colorCode = data >> 3;
+  pi = (data & 0x04) != 0;
+  lcss = data & 0x03;
+  return n;
+}
+
+// Data sync (bits 108-155) of a data burst: BS-sourced when the hotspot runs duplex,
+// MS-sourced in simplex (as MMDVMHost's CSync::addDMRDataSync)
+inline void dmrDataSyncWrite(uint8_t* burst, bool bsSourced) {
+  static const uint8_t bsSync[7] = { 0x0D, 0xFF, 0x57, 0xD7, 0x5D, 0xF5, 0xD0 };  // 0xDFF57D75DF5D
+  static const uint8_t msSync[7] = { 0x0D, 0x5D, 0x7F, 0x77, 0xFD, 0x75, 0x70 };  // 0xD5D7F77FD757
+  const uint8_t* sync = bsSourced ? bsSync : msSync;
+  burst[13] = (burst[13] & 0xF0) | sync[0];
+  memcpy(&burst[14], &sync[1], 5);
+  burst[19] = (burst[19] & 0x0F) | sync[6];
+}
+
+inline void dmrEmbEncode(uint8_t* burst, uint8_t colorCode, bool pi, uint8_t lcss) {
+  uint16_t codeword = dmrQR1676Encode((uint8_t)(((colorCode & 0x0F) << 3) | (pi ? 0x04 : 0) | (lcss & 0x03)));
+  burst[13] = (burst[13] & 0xF0) | (codeword >> 12);
+  burst[14] = (burst[14] & 0x0F) | (uint8_t)((codeword >> 4) & 0xF0);
+  burst[18] = (burst[18] & 0xF0) | ((codeword >> 4) & 0x0F);
+  burst[19] = (burst[19] & 0x0F) | (uint8_t)((codeword << 4) & 0xF0);
+}
+
+// Full LC of a voice LC header / terminator: BPTC + RS(12,9) with the given mask.
+// lc gets the 9 LC bytes (FLCO/FID/options, dst, src). Returns false if uncorrectable.
+inline bool dmrFullLCDecode(const uint8_t* burst, uint8_t mask, uint8_t* lc) {
+  for (uint8_t attempt = 0; attempt < 2; attempt++) {
+    uint8_t data[12];
+    int16_t bits = dmrBPTCDecode(burst, data, attempt == 0);
+    // Errors left in BPTC parity bits only leave the data intact: accept those when RS
+    // agrees without correcting; a clean BPTC result may have one byte fixed by RS
+    int8_t bytes = dmrRS129Decode(data, mask);
+    if (bytes == 0 || (bytes > 0 && bits >= 0)) {
+      memcpy(lc, data, 9);
+      return true;
+    }
+  }
+  return false;
+}
+
+inline void dmrFullLCEncode(const uint8_t* lc, uint8_t mask, uint8_t* burst) {
+  uint8_t data[12];
+  memcpy(data, lc, 9);
+  dmrRS129Encode(data, mask);
+  dmrBPTCEncode(data, burst);
+}
+
+// Complete voice LC header burst (full LC, slot type, data sync) for the 9 LC bytes
+inline void dmrVoiceLCHeaderBuild(const uint8_t* lc, uint8_t colorCode, bool bsSourced, uint8_t* burst) {
+  memset(burst, 0, 33);
+  dmrFullLCEncode(lc, DMR_LC_HEADER_CRC_MASK, burst);
+  dmrSlotTypeEncode(burst, colorCode, DMR_DT_VOICE_LC_HEADER);
+  dmrDataSyncWrite(burst, bsSourced);
+}
+
+// ---------------------------------------------------------------------------
+// Embedded LC: 72 LC bits + 5-bit checksum in a 16 x 8 matrix (rows 0-6
+// Hamming(16,11,4), row 7 column parity), read out in columns as 128 bits and
+// sent 32 bits at a time between the EMB halves of voice bursts B-E
+// ---------------------------------------------------------------------------
+
+// Fragment of one voice burst: burst bits 116-147
+inline uint32_t dmrEmbeddedFragmentRead(const uint8_t* burst) {
+  return ((uint32_t)(burst[14] & 0x0F) << 28) | ((uint32_t)burst[15] << 20) |
+         ((uint32_t)burst[16] << 12) | ((uint32_t)burst[17] << 4) | (burst[18] >> 4);
+}
+
+inline void dmrEmbeddedFragmentWrite(uint8_t* burst, uint32_t fragment) {
+  burst[14] = (burst[14] & 0xF0) | (uint8_t)(fragment >> 28);
+  burst[15] = (uint8_t)(fragment >> 20);
+  burst[16] = (uint8_t)(fragment >> 12);
+  burst[17] = (uint8_t)(fragment >> 4);
+  burst[18] = (burst[18] & 0x0F) | (uint8_t)((fragment << 4) & 0xF0);
+}
+
+// Fragment bit a (0-127, MSB of fragment 0 first) sits at matrix bit (16 * a) mod 127
+// (bit 127 stays in place); matrix bit b is row b / 16, bit b % 16 of rows[].
+inline void dmrEmbeddedUnpack(const uint32_t* fragments, uint16_t* rows) {
+  memset(rows, 0, 8 * sizeof(uint16_t));
+  uint8_t b = 0;
+  for (uint8_t a = 0; a < 128; a++) {
+    if ((fragments[a >> 5] >> (31 - (a & 31))) & 1) rows[b >> 4] |= (uint16_t)1 << (b & 15);
+    b += 16;
+    if (b > 127) b -= 127;
+  }
+}
+
+inline void dmrEmbeddedPack(const uint16_t* rows, uint32_t* fragments) {
+  memset(fragments, 0, 4 * sizeof(uint32_t));
+  uint8_t b = 0;
+  for (uint8_t a = 0; a < 128; a++) {
+    if ((rows[b >> 4] >> (b & 15)) & 1) fragments[a >> 5] |= (uint32_t)1 << (31 - (a & 31));
+    b += 16;
+    if (b > 127) b -= 127;
+  }
+}
+
+// LC bits per matrix row (11 in rows 0-1, 10 in rows 2-6; bit 10 of rows 2-6 is the checksum)
+inline uint8_t dmrEmbeddedRowBits(uint8_t row) {
+  return (row < 2) ? 11 : 10;
+}
+
+inline uint8_t dmrEmbeddedChecksum(const uint8_t* lc) {
+  uint16_t total = 0;
+  for (uint8_t i = 0; i < 9; i++) total += lc[i];
+  return (uint8_t)(total % 31);
+}
+
+// Decode four assembled fragments into the 9 LC bytes. Returns false if a row is
+// uncorrectable or the column parity / checksum fails.
+inline bool dmrEmbeddedLCDecode(const uint32_t* fragments, uint8_t* lc) {
+  uint16_t rows[8];
+  dmrEmbeddedUnpack(fragments, rows);
+
+  uint16_t parity = rows[7];
+  for (uint8_t r = 0; r < 7; r++) {
+    if (dmrHamming16114.decode(rows[r]) < 0) return false;
+    parity ^= rows[r];
+  }
+  if (parity != 0) return false;
+
+  memset(lc, 0, 9);
+  uint8_t pos = 0;
+  uint8_t checksum = 0;
+  for (uint8_t r = 0; r < 7; r++) {
+    for (uint8_t c = 0; c < dmrEmbeddedRowBits(r); c++, pos++) {
+      if ((rows[r] >> c) & 1) lc[pos >> 3] |= 0x80 >> (pos & 7);
+    }
+    if (r >= 2) checksum = (uint8_t)((checksum << 1) | ((rows[r] >> 10) & 1));
+  }
+  return checksum == dmrEmbeddedChecksum(lc);
+}
+
+inline void dmrEmbeddedLCEncode(const uint8_t* lc, uint32_t* fragments) {
+  uint16_t rows[8];
+  uint8_t checksum = dmrEmbeddedChecksum(lc);
+  uint8_t pos = 0;
+  rows[7] = 0;
+  for (uint8_t r = 0; r < 7; r++) {
+    uint16_t row = 0;
+    for (uint8_t c = 0; c < dmrEmbeddedRowBits(r); c++, pos++) {
+      if (lc[pos >> 3] & (0x80 >> (pos & 7))) row |= (uint16_t)1 << c;
+    }
+    if (r >= 2) row |= (uint16_t)((checksum >> (6 - r)) & 1) << 10;
+    rows[r] = dmrHamming16114.encode(row, 11);
+    rows[7] ^= rows[r];
+  }
+  dmrEmbeddedPack(rows, fragments);
+}
+
+// ---------------------------------------------------------------------------
+// Short LC: 28 bits + CRC-8 in three Hamming(17,12,3) rows and a column parity
+// row, interleaved (4 * i mod 67) into the 72 bits the modem spreads over the CACH
+// of four bursts (CMD_DMR_SHORTLC). Only built here, never received.
+// ---------------------------------------------------------------------------
+
+// CRC-8, polynomial x^8 + x^2 + x + 1 (MMDVMHost CCRC::crc8)
+inline uint8_t dmrCRC8(const uint8_t* data, uint8_t length) {
+  uint8_t crc = 0;
+  for (uint8_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (uint8_t b = 0; b < 8; b++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+  }
+  return crc;
+}
+
+// Parity bits 12-16 of a Hamming(17,12,3) row (MMDVMHost CHamming::encode17123), data bit i at bit i
+inline uint8_t dmrHamming17123Parity(uint16_t data) {
+  static const uint16_t checks[5] = {
+    (1 << 0) | (1 << 1) | (1 << 2) | (1 << 3) | (1 << 6) | (1 << 7) | (1 << 9),
+    (1 << 0) | (1 << 1) | (1 << 2) | (1 << 3) | (1 << 4) | (1 << 7) | (1 << 8) | (1 << 10),
+    (1 << 1) | (1 << 2) | (1 << 3) | (1 << 4) | (1 << 5) | (1 << 8) | (1 << 9) | (1 << 11),
+    (1 << 0) | (1 << 1) | (1 << 4) | (1 << 5) | (1 << 7) | (1 << 10),
+    (1 << 0) | (1 << 4) | (1 << 5) | (1 << 6) | (1 << 8) | (1 << 9) | (1 << 11)
+  };
+  uint8_t parity = 0;
+  for (uint8_t k = 0; k < 5; k++) {
+    uint16_t v = data & checks[k];
+    v ^= v >> 8;
+    v ^= v >> 4;
+    v ^= v >> 2;
+    v ^= v >> 1;
+    parity |= (uint8_t)((v & 1) << k);
+  }
+  return parity;
+}
+
+// lc: 5 bytes, SLCO in the low nibble of byte 0, data, CRC-8 in byte 4. out: 9 bytes.
+inline void dmrShortLCEncode(const uint8_t* lc, uint8_t* out) {
+  uint32_t rows[4] = { 0, 0, 0, 0 };
+  uint8_t pos = 4;
+  for (uint8_t r = 0; r < 3; r++) {
+    uint16_t data = 0;
+    for (uint8_t c = 0; c < 12; c++, pos++) {
+      if (lc[pos >> 3] & (0x80 >> (pos & 7))) data |= (uint16_t)1 << c;
+    }
+    rows[r] = data | ((uint32_t)dmrHamming17123Parity(data) << 12);
+    rows[3] ^= rows[r];
+  }
+
+  memset(out, 0, 9);
+  for (uint8_t i = 0; i < 68; i++) {
+    if ((rows[i / 17] >> (i % 17)) & 1) {
+      uint8_t bit = (i < 67) ? (uint8_t)((i * 4) % 67) : 67;
+      out[bit >> 3] |= 0x80 >> (bit & 7);
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Throughput check (bursts per second), for the host and DMR_FEC_BENCHMARK on the device
+// ---------------------------------------------------------------------------
+
+struct DMRFECBenchmark {
+  bool selfTestOk;
+  uint32_t headerDecodesPerSec;   // Slot type + BPTC + RS, 3 bit errors per burst
+  uint32_t headerEncodesPerSec;
+  uint32_t embDecodesPerSec;      // QR(16,7,6), 1 bit error
+};
+
+inline DMRFECBenchmark dmrFecBenchmark(uint64_t (*clockUs)(), uint32_t iterations) {
+  DMRFECBenchmark result = {};
+  static const uint8_t lc[9] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x5B, 0x3D, 0x2A, 0x64 };  // TG91 from 4008548
+  uint8_t burst[33];
+  memset(burst, 0, sizeof(burst));
+  dmrFullLCEncode(lc, DMR_LC_HEADER_CRC_MASK, burst);
+  dmrSlotTypeEncode(burst, 1, 1);
+  dmrEmbEncode(burst, 1, false, 1);
+
+  uint8_t damaged[33];
+  memcpy(damaged, burst, sizeof(burst));
+  damaged[0] ^= 0x80;   // Payload bit 0
+  damaged[30] ^= 0x04;  // Payload bit 253
+  damaged[13] ^= 0x10;  // Slot type bit 107
+
+  uint8_t out[9];
+  uint8_t cc = 0;
+  uint8_t dt = 0;
+  bool pi = false;
+  uint8_t lcss = 0;
+  result.selfTestOk = dmrFullLCDecode(damaged, DMR_LC_HEADER_CRC_MASK, out) && memcmp(out, lc, 9) == 0 &&
+                      dmrSlotTypeDecode(damaged, cc, dt) >= 0 && cc == 1 && dt == 1;
+  if (iterations == 0) return result;
+
+  uint32_t sink = 0;
+  uint64_t start = clockUs();
+  for (uint32_t i = 0; i < iterations; i++) {
+    damaged[20] ^= (uint8_t)i;  // Vary the input so nothing is hoisted out of the loop
+    sink += dmrSlotTypeDecode(damaged, cc, dt);
+    sink += dmrFullLCDecode(damaged, DMR_LC_HEADER_CRC_MASK, out) ? out[8] : 0;
+  }
+  uint64_t elapsed = clockUs() - start;
+  result.headerDecodesPerSec = (uint32_t)((uint64_t)iterations * 1000000 / (elapsed ? elapsed : 1));
+
+  start = clockUs();
+  for (uint32_t i = 0; i < iterations; i++) {
+    burst[0] = (uint8_t)i;
+    dmrFullLCEncode(lc, DMR_LC_HEADER_CRC_MASK, burst);
+    sink += burst[32];
+  }
+  elapsed = clockUs() - start;
+  result.headerEncodesPerSec = (uint32_t)((uint64_t)iterations * 1000000 / (elapsed ? elapsed : 1));
+
+  start = clockUs();
+  for (uint32_t i = 0; i < iterations * 16; i++) {
+    damaged[14] ^= (uint8_t)(i & 0x10);
+    sink += dmrEmbDecode(damaged, cc, pi, lcss) + cc;
+  }
+  elapsed = clockUs() - start;
+  result.embDecodesPerSec = (uint32_t)((uint64_t)iterations * 16 * 1000000 / (elapsed ? elapsed : 1));
+
+  if (sink == 0xFFFFFFFF) result.selfTestOk = false;  // Keeps the loops from being optimised away
+  return result;
+}
+
+#endif // DMR_FEC_H
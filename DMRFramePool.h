@@ -0,0 +1,101 @@
+/*
+ * DMRFramePool.h - Lock-free frame pool for ESP32 MMDVM Hotspot
+ *
+ * Fixed set of preallocated frame slots shared between tasks. A frame is filled
+ * once by whoever allocates it and then only its index (one byte) moves through
+ * the SpscQueue rings to the one task that dispatches and releases it:
+ * - alloc(): claim a free slot (0 -> 1) with a compare-and-swap scan from a
+ *   rotating cursor; lock-free, bounded by COUNT attempts, usable from any task
+ * - release(): hand the slot back to the pool
+ * A slot has a single owner at a time; there is no reference count, since no
+ * task keeps a frame after dispatch. No locks and no heap allocation, so the
+ * voice path never calls malloc(). The acquire/release ordering on the owned
+ * flag makes the previous owner's reads of a slot happen before the next
+ * owner's writes. No Arduino dependencies, so it also builds on a host.
+ */
+
+#ifndef DMR_FRAME_POOL_H
+#define DMR_FRAME_POOL_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+#define DMR_FRAME_NONE 0xFF  // alloc() result when every slot is in use
+
+// Pool statistics (copied out for the web interface)
+struct DMRFramePoolStats {
+  uint8_t capacity;
+  uint8_t inUse;       // Slots currently owned
+  uint8_t peakInUse;   // Highest inUse seen
+  uint32_t allocs;     // Slots handed out
+  uint32_t exhausted;  // alloc() calls that found no free slot
+};
+
+template <typename T, uint32_t COUNT>
+class DMRFramePool {
+private:
+  static_assert(COUNT >= 1 && COUNT < DMR_FRAME_NONE, "DMRFramePool holds 1-254 frames (one-byte index)");
+
+  T slots[COUNT];
+  std::atomic<uint8_t> owned[COUNT];  // 1 while a slot is allocated
+  std::atomic<uint32_t> cursor;   // Where the next alloc() starts scanning
+  std::atomic<uint32_t> inUse;
+  std::atomic<uint32_t> peakInUse;
+  std::atomic<uint32_t> allocs;
+  std::atomic<uint32_t> exhausted;
+
+public:
+  DMRFramePool() : cursor(0), inUse(0), peakInUse(0), allocs(0), exhausted(0) {
+    for (uint32_t i = 0; i < COUNT; i++) owned[i].store(0, std::memory_order_relaxed);
+  }
+
+  // Claim a free slot; DMR_FRAME_NONE if the pool is exhausted
+  uint8_t alloc() {
+    uint32_t start = cursor.fetch_add(1, std::memory_order_relaxed);
+    for (uint32_t n = 0; n < COUNT; n++) {
+      uint32_t i = (start + n) % COUNT;
+      uint8_t expected = 0;
+      if (owned[i].load(std::memory_order_relaxed) == 0 &&
+          owned[i].compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+        uint32_t used = inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+        uint32_t peak = peakInUse.load(std::memory_order_relaxed);
+        while (used > peak && !peakInUse.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {}
+        allocs.fetch_add(1, std::memory_order_relaxed);
+        return (uint8_t)i;
+      }
+    }
+    exhausted.fetch_add(1, std::memory_order_relaxed);
+    return DMR_FRAME_NONE;
+  }
+
+  // Return a slot from alloc() to the pool
+  void release(uint8_t index) {
+    owned[index].store(0, std::memory_order_release);
+    inUse.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  T &get(uint8_t index) {
+    return slots[index];
+  }
+
+  uint8_t indexOf(const T* frame) const {
+    return (uint8_t)(frame - slots);
+  }
+
+  bool isOwned(uint8_t index) const {
+    return owned[index].load(std::memory_order_relaxed) != 0;
+  }
+
+  DMRFramePoolStats getStats() const {
+    DMRFramePoolStats stats;
+    stats.capacity = (uint8_t)COUNT;
+    stats.inUse = (uint8_t)inUse.load(std::memory_order_relaxed);
+    stats.peakInUse = (uint8_t)peakInUse.load(std::memory_order_relaxed);
+    stats.allocs = allocs.load(std::memory_order_relaxed);
+    stats.exhausted = exhausted.load(std::memory_order_relaxed);
+    return stats;
+  }
+};
+
+#endif // DMR_FRAME_POOL_H
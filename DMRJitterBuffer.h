@@ -0,0 +1,377 @@
+/*
+ * DMRJitterBuffer.h - Per-slot network jitter buffer for ESP32 MMDVM Hotspot
+ *
+ * DMRD frames from the master can arrive bunched, late, twice or out of order.
+ * This buffer sits in front of the modem TX queue and hands frames on in
+ * sequence-number order (packet[4], wraps at 256):
+ * - A stream is held until `target` frames are buffered (or target x 60 ms have
+ *   passed), then released in order as the frames become contiguous
+ * - A missing frame is waited for until `target` frames are queued behind it or
+ *   target x 60 ms have passed, then concealed: the first missing voice burst
+ *   repeats the previous burst's audio, further ones are AMBE silence (as MMDVMHost
+ *   does). The sync / EMB field is taken from the same burst position (A-F) of
+ *   the previous superframe, so embedded LC signalling stays consistent
+ * - Duplicates and frames that arrive after their slot was played are dropped
+ * - The target depth adapts to the measured inter-arrival jitter (RFC 3550
+ *   style estimate) between JITTER_MIN_DEPTH and JITTER_MAX_DEPTH
+ *
+ * Not thread-safe; the owner (ModemTxQueue) serializes access. No Arduino
+ * dependencies, so it also builds on a host.
+ */
+
+#ifndef DMR_JITTER_BUFFER_H
+#define DMR_JITTER_BUFFER_H
+
+#include <stdint.h>
+#include <string.h>
+#include "DMRDefines.h"
+
+#ifndef JITTER_MIN_DEPTH
+#define JITTER_MIN_DEPTH 2  // Frames held before playout on a clean link (2 absorbs a swapped pair)
+#endif
+
+#ifndef JITTER_MAX_DEPTH
+#define JITTER_MAX_DEPTH 6  // Upper bound for the adaptive depth (6 x 60 ms)
+#endif
+
+#define JITTER_WINDOW 32              // Sequence numbers tracked ahead of playout (power of two)
+#define JITTER_FRAME_MS DMR_FRAME_MS  // One DMR voice burst per slot
+#define JITTER_STREAM_TIMEOUT_MS 1000 // No frames for this long without TERM_LC: stream over
+
+// A frame ready for playout. next() writes the burst to data, which the caller
+// points at its own storage (e.g. straight behind a modem frame header).
+struct DMRJitterFrame {
+  uint8_t seq;
+  uint8_t flags;        // DMRD flags byte (for concealed frames: the synthesized burst)
+  bool concealed;
+  uint8_t* data;        // DMR_PAYLOAD_LENGTH bytes
+
+  bool isVoice() const {
+    return (flags & DMRD_FRAME_TYPE_MASK) == DMRD_FRAME_VOICE || (flags & DMRD_FRAME_TYPE_MASK) == DMRD_FRAME_VOICE_SYNC;
+  }
+  bool isTerminator() const {
+    return dmrdIsTerminator(flags);
+  }
+};
+
+// Jitter buffer statistics (copied out for the web interface)
+struct DMRJitterStats {
+  uint32_t received;    // Frames inserted
+  uint32_t played;      // Frames handed on (incl. concealed)
+  uint32_t reordered;   // Frames that arrived after a later sequence number
+  uint32_t duplicates;  // Dropped: already buffered
+  uint32_t late;        // Dropped: their slot had already been played or concealed
+  uint32_t lost;        // Sequence numbers that never arrived
+  uint32_t concealed;   // Of which replaced by a repeated / silent voice burst
+  uint32_t resyncs;     // Jumps too far ahead of playout (buffer restarted)
+  uint8_t depth;        // Frames currently buffered
+  uint8_t target;       // Current target depth (frames)
+  uint16_t jitterMs;    // Inter-arrival jitter estimate
+};
+
+class DMRJitterBuffer {
+private:
+  static_assert((JITTER_WINDOW & (JITTER_WINDOW - 1)) == 0, "JITTER_WINDOW must be a power of two");
+  static_assert(JITTER_MAX_DEPTH < JITTER_WINDOW, "JITTER_MAX_DEPTH must be below JITTER_WINDOW");
+
+  struct Entry {
+    bool valid;
+    bool played;  // Slot was played from this entry (a copy arriving now is a duplicate)
+    uint8_t seq;
+    uint8_t flags;
+    uint8_t data[DMR_PAYLOAD_LENGTH];
+  };
+
+  Entry window[JITTER_WINDOW];
+  bool active;          // A stream is being played
+  bool prebuffering;    // Holding the start of the stream
+  uint32_t streamId;
+  uint32_t endedStreamId;  // Stream that ended with TERM_LC; its stragglers are late
+  uint8_t nextSeq;      // Next sequence number to play
+  uint8_t highestSeq;   // Highest sequence number buffered
+  uint8_t buffered;
+  uint32_t streamStart;
+  uint32_t gapSince;    // When playout first waited on the missing nextSeq (0 = not waiting)
+  uint32_t lastArrival;
+  uint8_t lastArrivalSeq;
+
+  // Concealment state
+  bool haveLastVoice;
+  uint8_t lastFlags;
+  uint8_t lastPosition;  // Burst position (0 = A) of the last voice frame played
+  uint8_t concealRun;    // Consecutive concealed bursts
+  uint8_t lastVoice[DMR_PAYLOAD_LENGTH];
+  uint8_t syncField[6][7];  // Bytes 13-19 (sync / EMB + embedded signalling) per position
+  uint8_t syncKnown;        // Bitmask of positions with a stored field
+
+  int32_t jitterQ4;      // Jitter estimate in ms << 4
+  uint8_t target;
+  DMRJitterStats stats;
+
+  static const uint8_t* silence() {
+    // Three AMBE+2 silence frames around an empty sync field (MMDVMHost DMR_SILENCE_DATA)
+    static const uint8_t data[DMR_PAYLOAD_LENGTH] = {
+      0xB9, 0xE8, 0x81, 0x52, 0x61, 0x73, 0x00, 0x2A, 0x6B, 0xB9, 0xE8, 0x81, 0x52,
+      0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+      0x73, 0x00, 0x2A, 0x6B, 0xB9, 0xE8, 0x81, 0x52, 0x61, 0x73, 0x00, 0x2A, 0x6B
+    };
+    return data;
+  }
+
+  // The 48-bit sync / EMB field is bits 108-155: low nibble of byte 13 .. high nibble of byte 19
+  static void copySyncField(uint8_t* dest, const uint8_t* src) {
+    dest[0] = (dest[0] & 0xF0) | (src[0] & 0x0F);
+    memcpy(&dest[1], &src[1], 5);
+    dest[6] = (dest[6] & 0x0F) | (src[6] & 0xF0);
+  }
+
+  uint8_t span() const {
+    return buffered == 0 ? 0 : (uint8_t)(highestSeq - nextSeq + 1);
+  }
+
+  void clearWindow() {
+    for (uint8_t i = 0; i < JITTER_WINDOW; i++) {
+      window[i].valid = false;
+      window[i].played = false;
+    }
+    buffered = 0;
+    stats.depth = 0;
+  }
+
+  void startStream(uint32_t id, uint8_t seq, uint32_t now) {
+    clearWindow();
+    active = true;
+    prebuffering = true;
+    streamId = id;
+    nextSeq = seq;
+    highestSeq = seq;
+    streamStart = now;
+    gapSince = 0;
+    haveLastVoice = false;
+    concealRun = 0;
+    syncKnown = 0;
+
+    // Depth for this stream from the jitter seen so far: ~2x jitter, at least the minimum
+    uint32_t jitterMs = (uint32_t)(jitterQ4 >> 4);
+    uint32_t depth = 1 + (2 * jitterMs + JITTER_FRAME_MS - 1) / JITTER_FRAME_MS;
+    if (depth < JITTER_MIN_DEPTH) depth = JITTER_MIN_DEPTH;
+    if (depth > JITTER_MAX_DEPTH) depth = JITTER_MAX_DEPTH;
+    target = (uint8_t)depth;
+    stats.target = target;
+  }
+
+  void updateJitter(uint8_t seq, uint32_t now) {
+    if (lastArrival != 0) {
+      // Difference between arrival spacing and the spacing the sequence numbers imply
+      int32_t expected = (int32_t)(int8_t)(seq - lastArrivalSeq) * JITTER_FRAME_MS;
+      int32_t d = (int32_t)(now - lastArrival) - expected;
+      if (d < 0) d = -d;
+      if (d > 1000) d = 1000;  // A pause between streams is not jitter
+      jitterQ4 += ((d << 4) - jitterQ4) / 16;
+      stats.jitterMs = (uint16_t)(jitterQ4 >> 4);
+    }
+    lastArrival = now;
+    lastArrivalSeq = seq;
+  }
+
+  void rememberPlayed(const DMRJitterFrame &frame) {
+    lastFlags = frame.flags;
+    if (!frame.isVoice()) {
+      haveLastVoice = false;
+      return;
+    }
+    uint8_t position = ((frame.flags & DMRD_FRAME_TYPE_MASK) == DMRD_FRAME_VOICE_SYNC) ? 0 : (frame.flags & DMRD_DTYPE_MASK) % 6;
+    lastPosition = position;
+    haveLastVoice = true;
+    if (!frame.concealed) {
+      memcpy(lastVoice, frame.data, DMR_PAYLOAD_LENGTH);
+      memcpy(syncField[position], &frame.data[13], 7);
+      syncKnown |= (1 << position);
+    }
+  }
+
+  // Replace the missing nextSeq. Returns false if there is nothing sensible to play
+  // (gap outside a voice superframe), in which case the slot is just skipped.
+  bool conceal(DMRJitterFrame &out) {
+    stats.lost++;
+    if (!haveLastVoice) return false;
+
+    uint8_t position = (lastPosition + 1) % 6;
+    out.seq = nextSeq;
+    out.concealed = true;
+    out.flags = (lastFlags & 0xC0) | (position == 0 ? DMRD_FRAME_VOICE_SYNC : (DMRD_FRAME_VOICE | position));
+    memcpy(out.data, concealRun == 0 ? lastVoice : silence(), DMR_PAYLOAD_LENGTH);
+    if (syncKnown & (1 << position)) {
+      copySyncField(&out.data[13], syncField[position]);
+    } else if (position == 0) {
+      // BS-sourced voice sync 0x755FD7DF75F7
+      static const uint8_t voiceSync[7] = { 0x07, 0x55, 0xFD, 0x7D, 0xF7, 0x5F, 0x70 };
+      copySyncField(&out.data[13], voiceSync);
+    } else {
+      copySyncField(&out.data[13], &silence()[13]);
+    }
+    concealRun++;
+    stats.concealed++;
+    return true;
+  }
+
+  void advance() {
+    nextSeq++;
+    gapSince = 0;
+  }
+
+public:
+  DMRJitterBuffer() {
+    reset();
+    jitterQ4 = 0;
+    memset(&stats, 0, sizeof(stats));
+    target = JITTER_MIN_DEPTH;
+    stats.target = target;
+  }
+
+  // Drop everything (e.g. slot flushed on disconnect); statistics are kept
+  void reset() {
+    clearWindow();
+    active = false;
+    prebuffering = false;
+    streamId = 0;
+    endedStreamId = 0;
+    nextSeq = 0;
+    highestSeq = 0;
+    gapSince = 0;
+    lastArrival = 0;
+    lastArrivalSeq = 0;
+    haveLastVoice = false;
+    concealRun = 0;
+    syncKnown = 0;
+  }
+
+  // Add a frame from the network. now is a millisecond clock. local frames are
+  // made up by the hotspot (e.g. a synthesized header) and don't count as arrivals
+  // for the jitter estimate.
+  void insert(uint8_t seq, uint32_t id, uint8_t flags, const uint8_t* data, uint32_t now, bool local = false) {
+    stats.received++;
+    if (endedStreamId != 0 && id == endedStreamId && !(active && id == streamId)) {
+      stats.late++;  // Straggler of a stream that already ended
+      return;
+    }
+    if (!local) updateJitter(seq, now);
+
+    if (!active || id != streamId) {
+      if (active) stats.lost += span();  // Previous stream abandoned without TERM_LC
+      startStream(id, seq, now);
+    }
+
+    int8_t ahead = (int8_t)(seq - nextSeq);
+    if (ahead < 0) {
+      if (prebuffering && (uint8_t)(highestSeq - seq) < JITTER_WINDOW - 1) {
+        // Start of the stream arrived out of order: move playout back
+        nextSeq = seq;
+      } else if (window[seq & (JITTER_WINDOW - 1)].played && window[seq & (JITTER_WINDOW - 1)].seq == seq) {
+        stats.duplicates++;
+        return;
+      } else {
+        stats.late++;
+        if (target < JITTER_MAX_DEPTH) stats.target = ++target;  // We gave up on it too early
+        return;
+      }
+    } else if (ahead >= JITTER_WINDOW) {
+      // Far ahead of playout: lost sync with the sender, restart at this frame
+      stats.resyncs++;
+      stats.lost += span();
+      clearWindow();
+      nextSeq = seq;
+      highestSeq = seq;
+      gapSince = 0;
+    }
+
+    Entry &e = window[seq & (JITTER_WINDOW - 1)];
+    if (e.valid && e.seq == seq) {
+      stats.duplicates++;
+      return;
+    }
+    if (buffered > 0 && (int8_t)(seq - highestSeq) < 0) {
+      stats.reordered++;
+    }
+    e.valid = true;
+    e.played = false;
+    e.seq = seq;
+    e.flags = flags;
+    memcpy(e.data, data, DMR_PAYLOAD_LENGTH);
+    buffered++;
+    if (buffered == 1 || (int8_t)(seq - highestSeq) > 0) highestSeq = seq;
+    stats.depth = buffered;
+  }
+
+  // Next frame due for playout (real or concealed) into out (out.data set by the
+  // caller), or false if playout has to wait. Call until it returns false after
+  // each insert() and on every playout tick.
+  bool next(DMRJitterFrame &out, uint32_t now) {
+    while (active) {
+      if (buffered == 0) {
+        if (now - lastArrival > JITTER_STREAM_TIMEOUT_MS) active = false;  // Ended without TERM_LC
+        return false;
+      }
+      if (prebuffering) {
+        bool terminated = false;
+        for (uint8_t i = 0; i < JITTER_WINDOW && !terminated; i++) {
+          terminated = window[i].valid && (window[i].flags & DMRD_FRAME_TYPE_MASK) == DMRD_FRAME_DATA_SYNC &&
+                       (window[i].flags & DMRD_DTYPE_MASK) == DMRD_DTYPE_TERMINATOR;
+        }
+        if (span() < target && !terminated && now - streamStart < (uint32_t)target * JITTER_FRAME_MS) return false;
+        prebuffering = false;
+      }
+
+      Entry &e = window[nextSeq & (JITTER_WINDOW - 1)];
+      if (e.valid && e.seq == nextSeq) {
+        out.seq = e.seq;
+        out.flags = e.flags;
+        out.concealed = false;
+        memcpy(out.data, e.data, DMR_PAYLOAD_LENGTH);
+        e.valid = false;
+        e.played = true;
+        buffered--;
+        stats.depth = buffered;
+        stats.played++;
+        concealRun = 0;
+        rememberPlayed(out);
+        advance();
+        if (out.isTerminator()) {
+          endedStreamId = streamId;
+          stats.lost += span();  // Anything still missing before the end never came
+          clearWindow();
+          active = false;
+        }
+        return true;
+      }
+
+      // nextSeq is missing but later frames are here: wait a little for it
+      if (gapSince == 0) gapSince = now ? now : 1;
+      if (span() <= target && now - gapSince < (uint32_t)target * JITTER_FRAME_MS) return false;
+
+      bool played = conceal(out);
+      if (played) {
+        stats.played++;
+        rememberPlayed(out);
+      }
+      advance();
+      if (played) return true;
+    }
+    return false;
+  }
+
+  // Frames buffered (waiting for playout)
+  uint8_t depth() const {
+    return buffered;
+  }
+
+  bool isActive() const {
+    return active;
+  }
+
+  DMRJitterStats getStats() const {
+    return stats;
+  }
+};
+
+#endif // DMR_JITTER_BUFFER_H
@@ -0,0 +1,278 @@
+/*
+ * DMRNetworkSocket.h - Homebrew master UDP socket for ESP32 MMDVM Hotspot
+ *
+ * Receives the master's datagrams into preallocated frames, so network RX
+ * latency no longer depends on how often loop() gets round to polling:
+ * - NETWORK_RX_ASYNC true: AsyncUDP delivers each datagram in its lwIP callback
+ *   (async_udp task), which classifies it by its 4-byte magic and copies it once
+ *   into a DMRFramePool slot; only the slot index is queued, and the consumer
+ *   dispatches the frames in place
+ * - NETWORK_RX_ASYNC false: the former WiFiUDP polling, kept to compare against;
+ *   poll() (from the consumer's service pass) moves whatever lwIP queued into
+ *   the same frames
+ * Frames carry the time they were received, and release() records the
+ * receive-to-dispatch latency. A polled datagram arrived at some point after the
+ * previous poll, so there the figure is an upper bound (the poll interval).
+ * One producer (callback or poll()) and one consumer (the DMR core task, woken
+ * through setConsumer()), no heap allocation.
+ */
+
+#ifndef DMR_NETWORK_SOCKET_H
+#define DMR_NETWORK_SOCKET_H
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include "esp_timer.h"
+#include "SpscQueue.h"
+#include "DMRFramePool.h"
+
+#ifndef NETWORK_RX_ASYNC
+#define NETWORK_RX_ASYNC true
+#endif
+
+#if NETWORK_RX_ASYNC
+#include <AsyncUDP.h>
+#endif
+
+#ifndef NETWORK_RX_QUEUE_DEPTH
+#define NETWORK_RX_QUEUE_DEPTH 16  // Received datagrams waiting for dispatch (power of two)
+#endif
+
+#ifndef NETWORK_FRAME_POOL_SIZE
+#define NETWORK_FRAME_POOL_SIZE 18  // The RX queue, plus the frame being released and the one being filled
+#endif
+
+#define NETWORK_FRAME_SIZE 64      // Largest datagram a master sends (DMRD = 55 bytes)
+
+enum class NET_FRAME : uint8_t {
+  DMRD,     // Voice / data burst
+  MSTPONG,  // Keepalive reply
+  RPTACK,   // Login / auth / config accepted
+  MSTNAK,   // Login refused or session unknown
+  MSTCL,    // Master closing the session
+  RPTSBKN,  // Beacon request
+  OTHER
+};
+
+// One received datagram, copied into a pool slot
+struct NetworkFrame {
+  int64_t timestamp;  // esp_timer_get_time() at receive
+  uint16_t length;
+  NET_FRAME kind;
+  uint8_t data[NETWORK_FRAME_SIZE];
+};
+
+// Socket statistics (copied out for the web interface)
+struct DMRNetworkSocketStats {
+  bool async;              // Callback-driven receive (NETWORK_RX_ASYNC)
+  uint32_t frames;         // Datagrams dispatched
+  uint32_t dmrd;           // ... of which DMRD
+  uint32_t control;        // ... of which MSTPONG / RPTACK / MSTNAK / MSTCL / RPTSBKN
+  uint32_t oversize;       // Dropped: longer than NETWORK_FRAME_SIZE
+  uint32_t queueFull;      // Dropped: dispatch was NETWORK_RX_QUEUE_DEPTH frames behind
+  uint32_t poolEmpty;      // Dropped: every pool frame was still in use
+  uint8_t poolInUse;       // Pool frames currently in use (being filled, queued or in dispatch)
+  uint8_t poolPeak;        // Highest poolInUse seen
+  uint8_t queueDepth;      // Frames currently waiting for dispatch
+  uint8_t peakQueueDepth;  // Highest queue depth seen
+  uint32_t lastLatencyUs;  // Receive-to-dispatch latency of the last frame
+  uint32_t avgLatencyUs;   // Running average (1/16 weight per frame)
+  uint32_t maxLatencyUs;   // Worst latency since last reset
+};
+
+class DMRNetworkSocket {
+private:
+#if NETWORK_RX_ASYNC
+  AsyncUDP udp;
+#else
+  WiFiUDP udp;
+  int64_t lastPoll;
+#endif
+  bool listening;
+  TaskHandle_t consumer;  // Woken when a frame is queued (NULL: consumer polls)
+  DMRFramePool<NetworkFrame, NETWORK_FRAME_POOL_SIZE> pool;
+  SpscQueue<uint8_t, NETWORK_RX_QUEUE_DEPTH> frames;  // Pool indexes, in arrival order
+  DMRNetworkSocketStats stats;
+  portMUX_TYPE mux;
+
+  static NET_FRAME classify(const uint8_t* data, size_t length) {
+    if (length < 4) return NET_FRAME::OTHER;
+    if (memcmp(data, "DMRD", 4) == 0) return NET_FRAME::DMRD;
+    if (memcmp(data, "MSTP", 4) == 0) return NET_FRAME::MSTPONG;
+    if (memcmp(data, "RPTA", 4) == 0) return NET_FRAME::RPTACK;
+    if (memcmp(data, "MSTN", 4) == 0) return NET_FRAME::MSTNAK;
+    if (memcmp(data, "MSTC", 4) == 0) return NET_FRAME::MSTCL;
+    if (memcmp(data, "RPTS", 4) == 0) return NET_FRAME::RPTSBKN;
+    return NET_FRAME::OTHER;
+  }
+
+  // Producer: pool slot for a datagram of this length (counted as dropped if there is none)
+  NetworkFrame* claim(size_t length, uint8_t &index) {
+    index = DMR_FRAME_NONE;
+    if (length <= NETWORK_FRAME_SIZE && frames.size() < frames.capacity()) {
+      index = pool.alloc();
+    }
+    if (index != DMR_FRAME_NONE) return &pool.get(index);
+
+    portENTER_CRITICAL(&mux);
+    if (length > NETWORK_FRAME_SIZE) {
+      stats.oversize++;
+    } else if (frames.size() >= frames.capacity()) {
+      stats.queueFull++;
+    } else {
+      stats.poolEmpty++;
+    }
+    portEXIT_CRITICAL(&mux);
+    return NULL;
+  }
+
+  // Producer: hand a filled slot to the consumer
+  void post(uint8_t index, NetworkFrame* frame, size_t length, int64_t timestamp) {
+    frame->timestamp = timestamp;
+    frame->length = (uint16_t)length;
+    frame->kind = classify(frame->data, length);
+    frames.push(index);  // Space checked in claim(); this is the only producer
+    if (consumer != NULL) xTaskNotifyGive(consumer);
+
+    uint8_t depth = (uint8_t)frames.size();
+    portENTER_CRITICAL(&mux);
+    if (depth > stats.peakQueueDepth) stats.peakQueueDepth = depth;
+    portEXIT_CRITICAL(&mux);
+  }
+
+  // Producer (callback path): copy one datagram into a pool slot
+  void receive(const uint8_t* data, size_t length, int64_t timestamp) {
+    uint8_t index;
+    NetworkFrame* frame = claim(length, index);
+    if (frame == NULL) return;
+    memcpy(frame->data, data, length);
+    post(index, frame, length, timestamp);
+  }
+
+public:
+  DMRNetworkSocket() : listening(false), consumer(NULL), mux(portMUX_INITIALIZER_UNLOCKED) {
+#if !NETWORK_RX_ASYNC
+    lastPoll = 0;
+#endif
+    memset(&stats, 0, sizeof(stats));
+    stats.async = NETWORK_RX_ASYNC;
+  }
+
+  // Bind the local port (again after a reconnect)
+  bool begin(uint16_t localPort) {
+#if NETWORK_RX_ASYNC
+    udp.close();
+    listening = udp.listen(localPort);
+    if (listening) {
+      udp.onPacket([this](AsyncUDPPacket &packet) {
+        receive(packet.data(), packet.length(), esp_timer_get_time());
+      });
+    }
+#else
+    udp.stop();
+    listening = udp.begin(localPort) == 1;
+    lastPoll = esp_timer_get_time();
+#endif
+    return listening;
+  }
+
+  // Task to notify (xTaskNotifyGive) whenever a datagram is queued
+  void setConsumer(TaskHandle_t handle) {
+    consumer = handle;
+  }
+
+  bool isListening() const {
+    return listening;
+  }
+
+  bool sendTo(const IPAddress &address, uint16_t port, const uint8_t* data, size_t length) {
+#if NETWORK_RX_ASYNC
+    return udp.writeTo(data, length, address, port) == length;
+#else
+    if (udp.beginPacket(address, port) != 1) return false;
+    udp.write(data, length);
+    return udp.endPacket() == 1;
+#endif
+  }
+
+  // Polled receive only: move the datagrams lwIP has queued into frames, stamped
+  // with the previous poll (the earliest they can have arrived)
+  void poll() {
+#if !NETWORK_RX_ASYNC
+    int64_t now = esp_timer_get_time();
+    int size;
+    while ((size = udp.parsePacket()) > 0) {
+      uint8_t index;
+      NetworkFrame* frame = claim(size, index);
+      if (frame == NULL) {
+        // Drop it, as the callback path does
+        uint8_t scratch[NETWORK_FRAME_SIZE];
+        while (udp.read(scratch, sizeof(scratch)) > 0) {}
+        continue;
+      }
+      int length = udp.read(frame->data, NETWORK_FRAME_SIZE);
+      if (length <= 0) {
+        pool.release(index);
+        continue;
+      }
+      post(index, frame, length, lastPoll);
+    }
+    lastPoll = now;
+#endif
+  }
+
+  // Consumer: datagrams waiting for dispatch
+  uint8_t pending() {
+    return (uint8_t)frames.size();
+  }
+
+  // Consumer: next received datagram, or NULL. Valid (and writable in place) until release().
+  NetworkFrame* next() {
+    uint8_t* index = frames.front();
+    return (index != NULL) ? &pool.get(*index) : NULL;
+  }
+
+  // Consumer: record receive-to-dispatch latency and free the frame returned by next()
+  void release(NetworkFrame* frame) {
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - frame->timestamp);
+    NET_FRAME kind = frame->kind;
+    frames.pop();
+    pool.release(pool.indexOf(frame));
+
+    portENTER_CRITICAL(&mux);
+    stats.frames++;
+    if (kind == NET_FRAME::DMRD) {
+      stats.dmrd++;
+    } else if (kind != NET_FRAME::OTHER) {
+      stats.control++;
+    }
+    stats.lastLatencyUs = latency;
+    if (stats.avgLatencyUs == 0) {
+      stats.avgLatencyUs = latency;
+    } else {
+      stats.avgLatencyUs = stats.avgLatencyUs - (stats.avgLatencyUs >> 4) + (latency >> 4);
+    }
+    if (latency > stats.maxLatencyUs) stats.maxLatencyUs = latency;
+    portEXIT_CRITICAL(&mux);
+  }
+
+  DMRNetworkSocketStats getStats() {
+    portENTER_CRITICAL(&mux);
+    DMRNetworkSocketStats copy = stats;
+    portEXIT_CRITICAL(&mux);
+    copy.queueDepth = (uint8_t)frames.size();
+    DMRFramePoolStats used = pool.getStats();
+    copy.poolInUse = used.inUse;
+    copy.poolPeak = used.peakInUse;
+    return copy;
+  }
+
+  void resetStats() {
+    portENTER_CRITICAL(&mux);
+    memset(&stats, 0, sizeof(stats));
+    stats.async = NETWORK_RX_ASYNC;
+    portEXIT_CRITICAL(&mux);
+  }
+};
+
+#endif // DMR_NETWORK_SOCKET_H
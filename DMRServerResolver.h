@@ -0,0 +1,178 @@
+/*
+ * DMRServerResolver.h - Cached DMR master address resolver for ESP32 MMDVM Hotspot
+ *
+ * The DMR master is usually configured by name (e.g. 2041.master.brandmeister.network).
+ * Resolving it in every udp.beginPacket() put a DNS lookup on the voice path.
+ * - A low-priority task resolves the name once and caches the IPAddress
+ * - The cache is refreshed in the background every DMR_DNS_TTL ms (lwIP's
+ *   hostByName() does not expose the record TTL)
+ * - A failed refresh keeps the last good address and retries after DMR_DNS_RETRY_INTERVAL
+ * - Numeric addresses are parsed directly without DNS
+ * - Resolve time and failure counters for the status page
+ */
+
+#ifndef DMR_SERVER_RESOLVER_H
+#define DMR_SERVER_RESOLVER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+#ifndef DMR_DNS_TTL
+#define DMR_DNS_TTL 300000  // Refresh a resolved address after 5 minutes
+#endif
+
+#ifndef DMR_DNS_RETRY_INTERVAL
+#define DMR_DNS_RETRY_INTERVAL 5000  // Retry a failed lookup after 5 seconds
+#endif
+
+#define DMR_DNS_HOST_MAX 64
+#define DMR_DNS_TASK_STACK 4096
+#define DMR_DNS_TASK_PRIORITY 1
+
+#ifndef APP_TASK_CORE
+#define APP_TASK_CORE 1  // Same core as loop(), away from the DMR core task
+#endif
+
+// Resolver statistics (copied out for the web interface)
+struct DMRServerResolverStats {
+  uint32_t lookups;            // DNS queries made
+  uint32_t failures;           // Queries that returned no address
+  uint32_t fallbacks;          // Failed refreshes that kept the last good address
+  uint32_t lastResolveMs;      // Duration of the last query
+  uint32_t maxResolveMs;       // Slowest query
+  unsigned long resolvedAt;    // millis() of the last successful lookup
+  bool numeric;                // Host is an IP address, no DNS needed
+};
+
+class DMRServerResolver {
+private:
+  char host[DMR_DNS_HOST_MAX];  // Written by the caller's task only (under mux)
+  IPAddress address;
+  bool valid;                   // address belongs to the current host
+  bool refreshRequested;
+  unsigned long lastAttempt;
+  TaskHandle_t task;
+  portMUX_TYPE mux;
+  DMRServerResolverStats stats;
+
+  static void taskEntry(void* arg) {
+    static_cast<DMRServerResolver*>(arg)->run();
+  }
+
+  void run() {
+    while (true) {
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+
+      char name[DMR_DNS_HOST_MAX];
+      portENTER_CRITICAL(&mux);
+      unsigned long now = millis();
+      bool due = refreshRequested ||
+                 (!valid && now - lastAttempt >= DMR_DNS_RETRY_INTERVAL) ||
+                 (valid && !stats.numeric && now - stats.resolvedAt >= DMR_DNS_TTL &&
+                  now - lastAttempt >= DMR_DNS_RETRY_INTERVAL);
+      if (due) {
+        refreshRequested = false;
+        lastAttempt = now;
+        memcpy(name, host, sizeof(name));
+      }
+      portEXIT_CRITICAL(&mux);
+
+      if (due && name[0] != '\0') {
+        resolve(name);
+      }
+    }
+  }
+
+  // Blocking lookup, only ever called from the resolver task
+  void resolve(const char* name) {
+    IPAddress result;
+    unsigned long start = millis();
+    bool ok = WiFi.hostByName(name, result) == 1 && result != IPAddress(0, 0, 0, 0);
+    uint32_t elapsed = millis() - start;
+
+    portENTER_CRITICAL(&mux);
+    if (strcmp(name, host) == 0) {  // Host unchanged while we were resolving
+      stats.lookups++;
+      stats.lastResolveMs = elapsed;
+      if (elapsed > stats.maxResolveMs) stats.maxResolveMs = elapsed;
+      if (ok) {
+        address = result;
+        valid = true;
+        stats.resolvedAt = millis();
+      } else {
+        stats.failures++;
+        if (valid) stats.fallbacks++;
+      }
+    }
+    portEXIT_CRITICAL(&mux);
+  }
+
+public:
+  DMRServerResolver()
+    : valid(false), refreshRequested(false), lastAttempt(0), task(NULL), mux(portMUX_INITIALIZER_UNLOCKED) {
+    host[0] = '\0';
+    memset(&stats, 0, sizeof(stats));
+  }
+
+  bool begin() {
+    if (task != NULL) return true;
+    return xTaskCreatePinnedToCore(taskEntry, "dmr_dns", DMR_DNS_TASK_STACK, this, DMR_DNS_TASK_PRIORITY, &task,
+                                   APP_TASK_CORE) == pdPASS;
+  }
+
+  // Set the master host name or address. Cheap when unchanged, so senders can call it
+  // every time; a new host drops the cached address and triggers a lookup.
+  void setHost(const char* name) {
+    if (strncmp(name, host, DMR_DNS_HOST_MAX) == 0) return;
+
+    IPAddress literal;
+    bool numeric = literal.fromString(name);
+
+    portENTER_CRITICAL(&mux);
+    strncpy(host, name, DMR_DNS_HOST_MAX - 1);
+    host[DMR_DNS_HOST_MAX - 1] = '\0';
+    stats.numeric = numeric;
+    if (numeric) {
+      address = literal;
+      valid = true;
+      stats.resolvedAt = millis();
+    } else {
+      valid = false;
+      refreshRequested = true;
+    }
+    portEXIT_CRITICAL(&mux);
+
+    if (!numeric && task != NULL) xTaskNotifyGive(task);
+  }
+
+  // Cached address of the master; false until the first lookup has succeeded
+  bool getAddress(IPAddress &out) {
+    portENTER_CRITICAL(&mux);
+    bool ok = valid;
+    if (ok) out = address;
+    portEXIT_CRITICAL(&mux);
+    return ok;
+  }
+
+  // Ask for a fresh lookup (e.g. after the master stopped answering)
+  void refresh() {
+    portENTER_CRITICAL(&mux);
+    if (!stats.numeric) refreshRequested = true;
+    portEXIT_CRITICAL(&mux);
+    if (task != NULL) xTaskNotifyGive(task);
+  }
+
+  DMRServerResolverStats getStats() {
+    portENTER_CRITICAL(&mux);
+    DMRServerResolverStats copy = stats;
+    portEXIT_CRITICAL(&mux);
+    return copy;
+  }
+
+  String getAddressString() {
+    IPAddress ip;
+    return getAddress(ip) ? ip.toString() : String("unresolved");
+  }
+};
+
+#endif // DMR_SERVER_RESOLVER_H
@@ -0,0 +1,214 @@
+/*
+ * DMRSessionSupervisor.h - Homebrew master session supervisor for ESP32 MMDVM Hotspot
+ *
+ * Watches the logged-in session and decides when to log in again:
+ * - Every RPTPING left without an MSTPONG by the time the next one is due counts
+ *   as missed; after NETWORK_PING_MISS_LIMIT in a row (or NETWORK_TIMEOUT without
+ *   any pong) the link is declared dead
+ * - A dead link, an MSTCL from the master, an MSTNAK or a login step that timed
+ *   out schedules the next RPTL/RPTK/RPTC run with exponential backoff from
+ *   NETWORK_RECONNECT_DELAY up to DMR_RECONNECT_BACKOFF_MAX, each wait picked at
+ *   random between half and all of the current step so hotspots dropped together
+ *   do not log in together
+ * - An MSTNAK to RPTK (refused password) waits the full DMR_RECONNECT_BACKOFF_MAX,
+ *   so a wrong password cannot hammer the master into banning the ID
+ * - An outage runs from losing a working session to the next Config ACK; its
+ *   length (time to recover) is kept for the status page
+ * All calls come from the DMR core task; getStats() may be called from any task.
+ */
+
+#ifndef DMR_SESSION_SUPERVISOR_H
+#define DMR_SESSION_SUPERVISOR_H
+
+#include <Arduino.h>
+#include "esp_random.h"
+
+#ifndef NETWORK_KEEPALIVE_INTERVAL
+#define NETWORK_KEEPALIVE_INTERVAL 5000  // RPTPING interval
+#endif
+#ifndef NETWORK_TIMEOUT
+#define NETWORK_TIMEOUT 30000  // Link dead after this long without an MSTPONG
+#endif
+#ifndef NETWORK_PING_MISS_LIMIT
+#define NETWORK_PING_MISS_LIMIT 3  // Link dead after this many unanswered RPTPINGs in a row
+#endif
+#ifndef NETWORK_RECONNECT_DELAY
+#define NETWORK_RECONNECT_DELAY 5000  // First backoff step
+#endif
+#ifndef DMR_RECONNECT_BACKOFF_MAX
+#define DMR_RECONNECT_BACKOFF_MAX 600000  // Longest backoff step (10 minutes)
+#endif
+
+// Why the session was lost or a login attempt failed
+enum class DMR_SESSION_EVENT : uint8_t {
+  NONE,
+  PONG_TIMEOUT,   // RPTPINGs unanswered
+  MASTER_CLOSE,   // MSTCL
+  MASTER_NAK,     // MSTNAK
+  LOGIN_TIMEOUT   // No RPTACK within DMR_LOGIN_TIMEOUT
+};
+
+inline const char* dmrSessionEventName(DMR_SESSION_EVENT event) {
+  switch (event) {
+    case DMR_SESSION_EVENT::PONG_TIMEOUT: return "Keepalive lost";
+    case DMR_SESSION_EVENT::MASTER_CLOSE: return "Closed by master";
+    case DMR_SESSION_EVENT::MASTER_NAK: return "Refused by master";
+    case DMR_SESSION_EVENT::LOGIN_TIMEOUT: return "Login timeout";
+    default: return "None";
+  }
+}
+
+// Session statistics (copied out for the web interface)
+struct DMRSessionStats {
+  bool connected;              // Config ACK received, session alive
+  bool outage;                 // A working session was lost and is not back yet
+  uint32_t pings;              // RPTPINGs sent
+  uint32_t pongs;              // MSTPONGs received
+  uint32_t missedPongs;        // RPTPINGs left unanswered
+  uint32_t lastRttMs;          // RPTPING to MSTPONG of the last answered ping
+  uint32_t lastPongAgeMs;      // Time since the last MSTPONG (0 while disconnected)
+  uint32_t attempts;           // Login runs started (RPTL sent)
+  uint32_t failures;           // Login runs that failed (NAK or timeout)
+  uint32_t closes;             // MSTCL received
+  uint32_t naks;               // MSTNAK received
+  uint32_t outages;            // Working sessions lost
+  uint32_t recoveries;         // ... and won back
+  uint32_t lastRecoverMs;      // Time to recover from the last outage
+  uint32_t maxRecoverMs;
+  uint32_t totalRecoverMs;     // For the average (totalRecoverMs / recoveries)
+  uint32_t retryInMs;          // Wait left before the next login run (0: none scheduled)
+  uint8_t backoffStep;         // Failed runs since the last working session
+  DMR_SESSION_EVENT lastEvent; // Cause of the last outage or failure
+};
+
+class DMRSessionSupervisor {
+private:
+  DMRSessionStats stats;
+  bool pingOutstanding;
+  uint8_t missedInRow;
+  unsigned long lastPingAt;
+  unsigned long lastPongAt;
+  unsigned long outageStart;
+  bool retryPending;
+  unsigned long retryAt;
+  portMUX_TYPE mux;
+
+  // Random wait in [step/2, step] for the current backoff step
+  uint32_t backoff(bool longWait) {
+    uint32_t step = DMR_RECONNECT_BACKOFF_MAX;
+    if (!longWait && stats.backoffStep < 16) {
+      step = min((uint32_t)DMR_RECONNECT_BACKOFF_MAX, (uint32_t)NETWORK_RECONNECT_DELAY << stats.backoffStep);
+    }
+    return step / 2 + esp_random() % (step / 2 + 1);
+  }
+
+public:
+  DMRSessionSupervisor() : pingOutstanding(false), missedInRow(0), lastPingAt(0), lastPongAt(0),
+                           outageStart(0), retryPending(false), retryAt(0), mux(portMUX_INITIALIZER_UNLOCKED) {
+    memset(&stats, 0, sizeof(stats));
+  }
+
+  // RPTL sent
+  void attemptStarted() {
+    portENTER_CRITICAL(&mux);
+    stats.attempts++;
+    retryPending = false;
+    portEXIT_CRITICAL(&mux);
+  }
+
+  // Config ACK: the session works. Sets recoverMs and returns true if it ended an outage.
+  bool connected(unsigned long now, uint32_t &recoverMs) {
+    bool recovered = false;
+    portENTER_CRITICAL(&mux);
+    stats.connected = true;
+    stats.backoffStep = 0;
+    pingOutstanding = false;
+    missedInRow = 0;
+    lastPingAt = now;
+    lastPongAt = now;
+    if (stats.outage) {
+      recoverMs = now - outageStart;
+      stats.outage = false;
+      stats.recoveries++;
+      stats.lastRecoverMs = recoverMs;
+      if (recoverMs > stats.maxRecoverMs) stats.maxRecoverMs = recoverMs;
+      stats.totalRecoverMs += recoverMs;
+      recovered = true;
+    }
+    portEXIT_CRITICAL(&mux);
+    return recovered;
+  }
+
+  // Keepalive due: false if the link is dead (no RPTPING then), true to send one
+  bool ping(unsigned long now) {
+    bool alive;
+    portENTER_CRITICAL(&mux);
+    if (pingOutstanding) {
+      stats.missedPongs++;
+      missedInRow++;
+    }
+    alive = missedInRow < NETWORK_PING_MISS_LIMIT && now - lastPongAt < NETWORK_TIMEOUT;
+    if (alive) {
+      stats.pings++;
+      pingOutstanding = true;
+      lastPingAt = now;
+    }
+    portEXIT_CRITICAL(&mux);
+    return alive;
+  }
+
+  void pong(unsigned long now) {
+    portENTER_CRITICAL(&mux);
+    stats.pongs++;
+    if (pingOutstanding) stats.lastRttMs = now - lastPingAt;
+    pingOutstanding = false;
+    missedInRow = 0;
+    lastPongAt = now;
+    portEXIT_CRITICAL(&mux);
+  }
+
+  // Session lost or login run failed: schedule the next run and return the wait.
+  // longWait uses the longest backoff step (password refused).
+  uint32_t lost(DMR_SESSION_EVENT event, unsigned long now, bool longWait) {
+    portENTER_CRITICAL(&mux);
+    if (stats.connected) {
+      stats.connected = false;
+      stats.outage = true;
+      stats.outages++;
+      outageStart = now;
+    } else {
+      stats.failures++;
+    }
+    if (event == DMR_SESSION_EVENT::MASTER_CLOSE) stats.closes++;
+    if (event == DMR_SESSION_EVENT::MASTER_NAK) stats.naks++;
+    stats.lastEvent = event;
+    uint32_t wait = backoff(longWait);
+    if (stats.backoffStep < 255) stats.backoffStep++;
+    pingOutstanding = false;
+    missedInRow = 0;
+    retryPending = true;
+    retryAt = now + wait;
+    portEXIT_CRITICAL(&mux);
+    return wait;
+  }
+
+  // A scheduled login run is due (cleared by attemptStarted())
+  bool retryDue(unsigned long now) {
+    portENTER_CRITICAL(&mux);
+    bool due = retryPending && (long)(now - retryAt) >= 0;
+    portEXIT_CRITICAL(&mux);
+    return due;
+  }
+
+  DMRSessionStats getStats() {
+    unsigned long now = millis();
+    portENTER_CRITICAL(&mux);
+    DMRSessionStats copy = stats;
+    copy.lastPongAgeMs = stats.connected ? now - lastPongAt : 0;
+    copy.retryInMs = (retryPending && (long)(retryAt - now) > 0) ? retryAt - now : 0;
+    portEXIT_CRITICAL(&mux);
+    return copy;
+  }
+};
+
+#endif // DMR_SESSION_SUPERVISOR_H
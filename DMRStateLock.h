@@ -0,0 +1,41 @@
+/*
+ * DMRStateLock.h - Guard for the dashboard state shared with the DMR core task
+ *
+ * The DMR core task owns the call state (dmrActivity, dmrHistory, dmrLoginStatus,
+ * currentTalkgroup) and takes this lock only while it updates that state, never
+ * across modem or network I/O. Readers on the UI side (web pages, OLED) take it
+ * only while they copy the state and format the copy afterwards, so a slow page
+ * cannot hold up voice frames for more than a few microseconds. The web handlers
+ * also take it while they reassign the DMR login settings, which the core task
+ * copies under it when a login run starts.
+ * The mutex is recursive (a locked update may call another one) and has priority
+ * inheritance, so a reader holding it runs at the core task's priority.
+ */
+
+#ifndef DMR_STATE_LOCK_H
+#define DMR_STATE_LOCK_H
+
+#include <Arduino.h>
+#include "freertos/semphr.h"
+
+inline SemaphoreHandle_t dmrStateMutex() {
+  static SemaphoreHandle_t mutex = xSemaphoreCreateRecursiveMutex();
+  return mutex;
+}
+
+// Scoped lock: { DMRStateLock lock; ...read or update the shared state... }
+class DMRStateLock {
+public:
+  DMRStateLock() {
+    xSemaphoreTakeRecursive(dmrStateMutex(), portMAX_DELAY);
+  }
+
+  ~DMRStateLock() {
+    xSemaphoreGiveRecursive(dmrStateMutex());
+  }
+
+  DMRStateLock(const DMRStateLock &) = delete;
+  DMRStateLock &operator=(const DMRStateLock &) = delete;
+};
+
+#endif // DMR_STATE_LOCK_H
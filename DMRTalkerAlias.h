@@ -0,0 +1,174 @@
+/*
+ * DMRTalkerAlias.h - Talker alias assembler for ESP32 MMDVM Hotspot
+ *
+ * Radios that send a talker alias put it in the embedded LC (FLCO 4 = header,
+ * 5-7 = blocks 1-3, FID 0), one block per superframe in between the voice LC.
+ * The header holds format (2 bits), length in characters (5 bits) and the first
+ * 49 bits of text; each block adds 56 bits. Only as many blocks as the length
+ * needs are sent, in any order, repeated for the whole call.
+ * - 7-bit: ASCII packed in 7-bit groups, starting right after format + length
+ * - ISO 8-bit (ISO-8859-1) and UTF-8: bytes, from the header's second byte
+ * - UTF-16 (big endian): from the header's second byte
+ * The text is converted to UTF-8 (surrogate pairs become '?'). Fixed buffers,
+ * one instance per slot. No Arduino dependencies, so it also builds on a host.
+ */
+
+#ifndef DMR_TALKER_ALIAS_H
+#define DMR_TALKER_ALIAS_H
+
+#include <stdint.h>
+#include <string.h>
+#include "DMRDefines.h"
+
+#define DMR_TALKER_ALIAS_BLOCK_BYTES 7   // LC bytes 2-8 of each block
+#define DMR_TALKER_ALIAS_MAX_CHARS 31    // 5-bit length
+#define DMR_TALKER_ALIAS_TEXT_MAX (DMR_TALKER_ALIAS_MAX_CHARS * 3 + 1)  // UTF-8 of 31 BMP characters
+
+class DMRTalkerAlias {
+private:
+  uint8_t raw[4 * DMR_TALKER_ALIAS_BLOCK_BYTES];  // Header + blocks 1-3 as received
+  uint8_t received;   // Bitmask of the blocks in raw (bit 0 = header)
+  bool complete;
+  char text[DMR_TALKER_ALIAS_TEXT_MAX];
+
+  uint8_t format() const {
+    return raw[0] >> 6;
+  }
+
+  uint8_t length() const {
+    return (raw[0] >> 1) & 0x1F;
+  }
+
+  // Characters that fit in header + three blocks for the format (the length may claim more)
+  uint8_t maxChars() const {
+    switch (format()) {
+      case DMR_TA_FORMAT_7BIT: return 31;   // 217 bits / 7
+      case DMR_TA_FORMAT_UTF16: return 13;  // 27 bytes / 2
+      default: return 27;
+    }
+  }
+
+  uint8_t chars() const {
+    return (length() < maxChars()) ? length() : maxChars();
+  }
+
+  // Blocks (including the header) that carry text for the announced format and length
+  uint8_t blocksNeeded() const {
+    uint16_t bits;
+    uint16_t headerBits;
+    switch (format()) {
+      case DMR_TA_FORMAT_7BIT: bits = 7 * chars(); headerBits = 49; break;
+      case DMR_TA_FORMAT_UTF16: bits = 16 * chars(); headerBits = 48; break;
+      default: bits = 8 * chars(); headerBits = 48; break;
+    }
+    if (bits <= headerBits) return 1;
+    return (uint8_t)(1 + (bits - headerBits + 55) / 56);
+  }
+
+  // Drop a multi-byte UTF-8 sequence cut off at the end of the text
+  void trimUtf8(uint16_t &pos) {
+    uint16_t lead = pos;
+    while (lead > 0 && ((uint8_t)text[lead - 1] & 0xC0) == 0x80) lead--;
+    if (lead == 0 || !((uint8_t)text[lead - 1] & 0x80)) return;
+    uint8_t c = (uint8_t)text[lead - 1];
+    uint8_t need = (c >= 0xF0) ? 4 : (c >= 0xE0) ? 3 : 2;
+    if (pos - (lead - 1) < need) pos = lead - 1;
+  }
+
+  void appendUtf8(uint16_t &pos, uint16_t code) {
+    if (code < 0x80) {
+      if (pos + 1 >= DMR_TALKER_ALIAS_TEXT_MAX) return;
+      text[pos++] = (char)code;
+    } else if (code < 0x800) {
+      if (pos + 2 >= DMR_TALKER_ALIAS_TEXT_MAX) return;
+      text[pos++] = (char)(0xC0 | (code >> 6));
+      text[pos++] = (char)(0x80 | (code & 0x3F));
+    } else {
+      if (pos + 3 >= DMR_TALKER_ALIAS_TEXT_MAX) return;
+      text[pos++] = (char)(0xE0 | (code >> 12));
+      text[pos++] = (char)(0x80 | ((code >> 6) & 0x3F));
+      text[pos++] = (char)(0x80 | (code & 0x3F));
+    }
+  }
+
+  void decode() {
+    uint16_t pos = 0;
+    uint8_t count = chars();
+    const uint8_t* data = &raw[1];
+    switch (format()) {
+      case DMR_TA_FORMAT_7BIT:
+        // Bit 7 of raw[0] is bit 0 of the stream; text starts after format + length
+        for (uint8_t c = 0; c < count; c++) {
+          uint16_t bit = 7 + 7 * c;
+          uint8_t value = 0;
+          for (uint8_t b = 0; b < 7; b++, bit++) {
+            value = (uint8_t)((value << 1) | ((raw[bit >> 3] >> (7 - (bit & 7))) & 1));
+          }
+          appendUtf8(pos, value);
+        }
+        break;
+      case DMR_TA_FORMAT_ISO8:
+        for (uint8_t c = 0; c < count; c++) appendUtf8(pos, data[c]);
+        break;
+      case DMR_TA_FORMAT_UTF8:
+        for (uint8_t c = 0; c < count; c++) text[pos++] = (char)data[c];
+        trimUtf8(pos);
+        break;
+      default:  // DMR_TA_FORMAT_UTF16
+        for (uint8_t c = 0; c < count; c++) {
+          uint16_t code = (uint16_t)((data[2 * c] << 8) | data[2 * c + 1]);
+          appendUtf8(pos, (code >= 0xD800 && code <= 0xDFFF) ? '?' : code);
+        }
+        break;
+    }
+    text[pos] = '\0';
+    // Radios pad with spaces / NULs
+    while (pos > 0 && (text[pos - 1] == ' ' || text[pos - 1] == '\0')) text[--pos] = '\0';
+  }
+
+public:
+  DMRTalkerAlias() {
+    reset();
+  }
+
+  // New call: forget everything received so far
+  void reset() {
+    memset(raw, 0, sizeof(raw));
+    received = 0;
+    complete = false;
+    text[0] = '\0';
+  }
+
+  /*
+   * Feed a decoded embedded LC (9 bytes). Anything but a talker alias block is
+   * ignored. Returns true once, when the block completing the alias arrives.
+   */
+  bool add(const uint8_t* lc) {
+    uint8_t flco = lc[0] & 0x3F;
+    if (flco < DMR_FLCO_TALKER_ALIAS_HEADER || flco > DMR_FLCO_TALKER_ALIAS_BLOCK3 || lc[1] != 0x00) return false;
+    if (complete) return false;
+
+    uint8_t block = flco - DMR_FLCO_TALKER_ALIAS_HEADER;
+    memcpy(&raw[block * DMR_TALKER_ALIAS_BLOCK_BYTES], &lc[2], DMR_TALKER_ALIAS_BLOCK_BYTES);
+    received |= 1 << block;
+
+    if (!(received & 0x01)) return false;  // Format and length are in the header
+    uint8_t needed = (uint8_t)((1 << blocksNeeded()) - 1);
+    if ((received & needed) != needed) return false;
+
+    decode();
+    complete = true;
+    return true;
+  }
+
+  bool isComplete() const {
+    return complete;
+  }
+
+  // UTF-8 alias (empty until complete)
+  const char* getText() const {
+    return complete ? text : "";
+  }
+};
+
+#endif // DMR_TALKER_ALIAS_H
@@ -0,0 +1,260 @@
+/*
+ * DMRUplink.h - RF -> network DMRD encoder for ESP32 MMDVM Hotspot
+ *
+ * Turns the DMR bursts the modem receives over the air (CMD_DMR_DATA1/2) into
+ * Homebrew DMRD packets for the master, the way MMDVMHost's DMRNetwork does:
+ * - A voice LC header starts a call: new random stream ID, sequence restarts at 0,
+ *   source / destination / group-or-private taken from the full LC (BPTC(196,96)
+ *   and RS(12,9) corrected, see DMRFEC.h); a header that fails FEC only repeats
+ *   a running call
+ * - Voice sync and voice bursts carry the burst position (A = sync, B-F = 1-5)
+ * - The terminator with LC is sent and ends the call; so does a lost carrier
+ *   (CMD_DMR_LOST) or DMR_UPLINK_TIMEOUT_MS without bursts
+ * - Late entry: without a header, the embedded LC of voice bursts B-E (see
+ *   DMREmbeddedLC.h) starts the call within one superframe; bursts before that
+ *   are counted and dropped
+ * The packet is built in a caller-supplied 55-byte buffer; nothing is allocated.
+ * No Arduino dependencies, so it also builds on a host.
+ */
+
+#ifndef DMR_UPLINK_H
+#define DMR_UPLINK_H
+
+#include <stdint.h>
+#include <string.h>
+#include "DMRDefines.h"
+#include "DMRFEC.h"
+#include "DMREmbeddedLC.h"
+
+#ifndef DMR_UPLINK_TIMEOUT_MS
+#define DMR_UPLINK_TIMEOUT_MS 360  // One superframe without bursts: the call is over
+#endif
+
+// Uplink statistics (copied out for the web interface)
+struct DMRUplinkStats {
+  uint32_t calls;          // Calls started (voice LC header or late entry)
+  uint32_t lateEntries;    // ... of those, started from the embedded LC
+  uint32_t packets;        // DMRD packets built
+  uint32_t sendErrors;     // Packets the UDP stack refused
+  uint32_t noCall;         // Bursts dropped: call not identified yet
+  uint32_t badHeaders;     // Voice LC headers whose FEC failed
+  uint32_t unsupported;    // Bursts dropped: data / CSBK / idle
+  uint32_t lastLatencyUs;  // Modem UART to UDP send, last packet
+  uint32_t avgLatencyUs;   // Running average (1/16 weight per packet)
+  uint32_t maxLatencyUs;   // Worst since last reset
+};
+
+// The call currently received on a slot
+struct DMRUplinkCall {
+  bool active;
+  bool privateCall;
+  bool lateEntry;          // Identified from the embedded LC (no header received)
+  uint32_t srcId;
+  uint32_t dstId;
+  uint32_t streamId;
+  uint32_t startMs;
+  uint32_t lastMs;
+  uint32_t packets;
+};
+
+class DMRUplink {
+private:
+  struct Slot {
+    DMRUplinkCall call;
+    DMREmbeddedLC embeddedLC;
+    uint8_t seq;
+  };
+
+  Slot slots[2];
+  uint32_t repeaterId;
+  uint32_t random;
+  DMRUplinkStats stats;
+
+  uint32_t nextStreamId() {
+    // xorshift32; never 0 (0 means "no stream" to the jitter buffer / call tracker)
+    do {
+      random ^= random << 13;
+      random ^= random >> 17;
+      random ^= random << 5;
+    } while (random == 0);
+    return random;
+  }
+
+  // New call from a group / private LC; false for other FLCOs (e.g. talker alias)
+  bool startCall(Slot &slot, const uint8_t* lc, uint32_t nowMs, bool lateEntry) {
+    uint8_t flco = lc[0] & 0x3F;
+    if (flco != DMR_FLCO_GROUP && flco != DMR_FLCO_USER_USER) return false;
+    DMRUplinkCall &call = slot.call;
+    call.active = true;
+    call.privateCall = (flco == DMR_FLCO_USER_USER);
+    call.lateEntry = lateEntry;
+    call.dstId = ((uint32_t)lc[3] << 16) | ((uint32_t)lc[4] << 8) | lc[5];
+    call.srcId = ((uint32_t)lc[6] << 16) | ((uint32_t)lc[7] << 8) | lc[8];
+    call.streamId = nextStreamId();
+    call.startMs = nowMs;
+    call.packets = 0;
+    slot.seq = 0;
+    stats.calls++;
+    if (lateEntry) stats.lateEntries++;
+    return true;
+  }
+
+public:
+  DMRUplink() : repeaterId(0), random(0x2545F491) {
+    for (uint8_t s = 0; s < 2; s++) {
+      memset(&slots[s].call, 0, sizeof(slots[s].call));
+      slots[s].seq = 0;
+    }
+    memset(&stats, 0, sizeof(stats));
+  }
+
+  // seed: any entropy (e.g. esp_random()) so stream IDs differ across reboots
+  void begin(uint32_t id, uint32_t seed) {
+    repeaterId = id;
+    if (seed != 0) random = seed;
+  }
+
+  void setRepeaterId(uint32_t id) {
+    repeaterId = id;
+  }
+
+  /*
+   * Build the DMRD packet for one CMD_DMR_DATA1/2 frame (payload = control byte +
+   * 33-byte burst). Returns false if nothing is to be sent for this burst.
+   * endedCall is set when the burst ended the call (terminator).
+   */
+  bool encode(uint8_t slotNo, const uint8_t* payload, uint16_t length, uint32_t nowMs,
+              uint8_t* packet, bool &endedCall) {
+    endedCall = false;
+    if (slotNo < 1 || slotNo > 2 || length < 1 + DMR_PAYLOAD_LENGTH) return false;
+    Slot &slot = slots[slotNo - 1];
+    DMRUplinkCall &call = slot.call;
+    uint8_t control = payload[0];
+    const uint8_t* burst = &payload[1];
+
+    uint8_t flags;
+    if (control & MMDVM_DMR_SYNC_DATA) {
+      uint8_t dataType = control & 0x0F;
+      slot.embeddedLC.reset();
+      if (dataType == DMR_DT_VOICE_LC_HEADER) {
+        uint8_t lc[9];
+        if (dmrFullLCDecode(burst, DMR_LC_HEADER_CRC_MASK, lc)) {
+          uint32_t dst = ((uint32_t)lc[3] << 16) | ((uint32_t)lc[4] << 8) | lc[5];
+          uint32_t src = ((uint32_t)lc[6] << 16) | ((uint32_t)lc[7] << 8) | lc[8];
+          if (!call.active || call.srcId != src || call.dstId != dst) {
+            // New call (a repeated header of the running call keeps its stream)
+            startCall(slot, lc, nowMs, false);
+          }
+        } else {
+          // Unreadable header: forwarded only as a repeat within a running call
+          stats.badHeaders++;
+        }
+      } else if (dataType != DMR_DT_TERMINATOR_WITH_LC) {
+        stats.unsupported++;
+        return false;
+      }
+      flags = DMRD_FRAME_DATA_SYNC | dataType;
+    } else if (control & MMDVM_DMR_SYNC_VOICE) {
+      flags = DMRD_FRAME_VOICE_SYNC;
+    } else {
+      flags = DMRD_FRAME_VOICE | (control & 0x0F);
+      // Voice bursts B-F: collect the embedded LC; it identifies a call joined late
+      uint8_t lc[9];
+      if (slot.embeddedLC.add(burst, lc) && !call.active) {
+        startCall(slot, lc, nowMs, true);
+      }
+    }
+
+    if (!call.active) {
+      stats.noCall++;
+      return false;
+    }
+    if (slotNo == 2) flags |= DMRD_FLAG_SLOT2;
+    if (call.privateCall) flags |= DMRD_FLAG_PRIVATE;
+
+    memcpy(packet, "DMRD", 4);
+    packet[DMRD_SEQ_OFFSET] = slot.seq++;
+    packet[DMRD_SRC_OFFSET] = (uint8_t)(call.srcId >> 16);
+    packet[DMRD_SRC_OFFSET + 1] = (uint8_t)(call.srcId >> 8);
+    packet[DMRD_SRC_OFFSET + 2] = (uint8_t)call.srcId;
+    packet[DMRD_DST_OFFSET] = (uint8_t)(call.dstId >> 16);
+    packet[DMRD_DST_OFFSET + 1] = (uint8_t)(call.dstId >> 8);
+    packet[DMRD_DST_OFFSET + 2] = (uint8_t)call.dstId;
+    packet[DMRD_REPEATER_OFFSET] = (uint8_t)(repeaterId >> 24);
+    packet[DMRD_REPEATER_OFFSET + 1] = (uint8_t)(repeaterId >> 16);
+    packet[DMRD_REPEATER_OFFSET + 2] = (uint8_t)(repeaterId >> 8);
+    packet[DMRD_REPEATER_OFFSET + 3] = (uint8_t)repeaterId;
+    packet[DMRD_FLAGS_OFFSET] = flags;
+    packet[DMRD_STREAM_OFFSET] = (uint8_t)(call.streamId >> 24);
+    packet[DMRD_STREAM_OFFSET + 1] = (uint8_t)(call.streamId >> 16);
+    packet[DMRD_STREAM_OFFSET + 2] = (uint8_t)(call.streamId >> 8);
+    packet[DMRD_STREAM_OFFSET + 3] = (uint8_t)call.streamId;
+    memcpy(&packet[DMRD_PAYLOAD_OFFSET], burst, DMR_PAYLOAD_LENGTH);
+    packet[DMRD_BER_OFFSET] = 0;
+    packet[DMRD_RSSI_OFFSET] = 0;
+
+    call.lastMs = nowMs;
+    call.packets++;
+    stats.packets++;
+
+    if ((flags & DMRD_FRAME_TYPE_MASK) == DMRD_FRAME_DATA_SYNC && (flags & DMRD_DTYPE_MASK) == DMR_DT_TERMINATOR_WITH_LC) {
+      call.active = false;
+      endedCall = true;
+    }
+    return true;
+  }
+
+  // Carrier lost (CMD_DMR_LOST1/2): the call is over without a terminator
+  bool lost(uint8_t slotNo) {
+    if (slotNo < 1 || slotNo > 2) return false;
+    slots[slotNo - 1].embeddedLC.reset();
+    if (!slots[slotNo - 1].call.active) return false;
+    slots[slotNo - 1].call.active = false;
+    return true;
+  }
+
+  // End calls that stopped without a terminator; returns a bitmask of the slots ended (1 = TS1, 2 = TS2)
+  uint8_t expire(uint32_t nowMs) {
+    uint8_t ended = 0;
+    for (uint8_t s = 0; s < 2; s++) {
+      DMRUplinkCall &call = slots[s].call;
+      if (call.active && nowMs - call.lastMs > DMR_UPLINK_TIMEOUT_MS) {
+        call.active = false;
+        ended |= 1 << s;
+      }
+    }
+    return ended;
+  }
+
+  void recordSend(bool ok, uint32_t latencyUs) {
+    if (!ok) {
+      stats.sendErrors++;
+      return;
+    }
+    stats.lastLatencyUs = latencyUs;
+    if (stats.avgLatencyUs == 0) {
+      stats.avgLatencyUs = latencyUs;
+    } else {
+      stats.avgLatencyUs = stats.avgLatencyUs - (stats.avgLatencyUs >> 4) + (latencyUs >> 4);
+    }
+    if (latencyUs > stats.maxLatencyUs) stats.maxLatencyUs = latencyUs;
+  }
+
+  bool isActive() const {
+    return slots[0].call.active || slots[1].call.active;
+  }
+
+  const DMRUplinkCall &getCall(uint8_t slotNo) const {
+    return slots[(slotNo == 2) ? 1 : 0].call;
+  }
+
+  DMRUplinkStats getStats() const {
+    return stats;
+  }
+
+  void resetStats() {
+    memset(&stats, 0, sizeof(stats));
+  }
+};
+
+#endif // DMR_UPLINK_H
@@ -0,0 +1,247 @@
+/*
+ * MMDVMFrameParser.h - Zero-copy MMDVM serial frame parser for ESP32 MMDVM Hotspot
+ *
+ * Bytes from the modem UART are read straight into a ring buffer and completed
+ * frames are handed out as views into that ring, so nothing is copied per byte.
+ * - Short frames: E0 LEN CMD ...            (LEN = whole frame, 3..255)
+ * - Long frames:  E1 LEN_HI LEN_LO CMD ...  (newer firmware, up to MMDVM_RX_FRAME_MAX)
+ * - A malformed length drops only the start byte; parsing resyncs on the next E0/E1
+ * - The first MMDVM_RX_FRAME_MAX ring bytes are mirrored past the end, so a frame
+ *   that wraps around is still contiguous
+ *
+ * One producer (commit / poll / resync) and one consumer (front / pop) may run
+ * in different tasks. Views stay valid until pop(). No Arduino dependencies,
+ * so it also builds on a host.
+ *
+ * The sending side, mmdvmFrameBuild(), writes the E0 header into headroom the
+ * caller left in front of the payload, so a command goes out in one UART write
+ * without copying the payload into a separate frame buffer.
+ */
+
+#ifndef MMDVM_FRAME_PARSER_H
+#define MMDVM_FRAME_PARSER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include "SpscQueue.h"
+
+#ifndef MMDVM_RX_RING_SIZE
+#define MMDVM_RX_RING_SIZE 1024  // Received bytes buffered (power of two)
+#endif
+
+#ifndef MMDVM_RX_FRAME_MAX
+#define MMDVM_RX_FRAME_MAX 512  // Longest frame accepted; longer lengths are treated as corrupt
+#endif
+
+#ifndef MMDVM_RX_QUEUE_DEPTH
+#define MMDVM_RX_QUEUE_DEPTH 16  // Completed frames waiting for the consumer (power of two)
+#endif
+
+#define MMDVM_SHORT_FRAME_START 0xE0
+#define MMDVM_LONG_FRAME_START 0xE1
+#define MMDVM_FRAME_HEADROOM 3  // E0 LEN CMD in front of a short frame's payload
+
+// Build a short frame in place: the payload is already at frame[MMDVM_FRAME_HEADROOM]
+// (payloadLength bytes, up to 252). Returns the length of the frame to write.
+inline uint8_t mmdvmFrameBuild(uint8_t* frame, uint8_t cmd, uint8_t payloadLength) {
+  frame[0] = MMDVM_SHORT_FRAME_START;
+  frame[1] = (uint8_t)(payloadLength + MMDVM_FRAME_HEADROOM);
+  frame[2] = cmd;
+  return frame[1];
+}
+
+// A complete frame inside the parser ring (valid until pop())
+struct MMDVMFrameView {
+  const uint8_t* data;   // Whole frame, starting with E0/E1
+  uint16_t length;       // Whole frame length
+  uint8_t headerLength;  // 2 for E0 frames, 3 for E1 frames
+  int64_t timestamp;     // Producer-supplied time the frame's first byte was committed
+  uint32_t endPos;       // Ring position after the frame (released by pop())
+
+  uint8_t command() const { return data[headerLength]; }
+  const uint8_t* payload() const { return data + headerLength + 1; }
+  uint16_t payloadLength() const { return length - headerLength - 1; }
+  bool isLong() const { return headerLength == 3; }
+};
+
+// Parser counters (producer-owned; read from other tasks for display only)
+struct MMDVMFrameParserStats {
+  uint32_t frames;        // Frames published
+  uint32_t longFrames;    // Of which E1 frames
+  uint32_t invalid;       // Start bytes dropped for an impossible length
+  uint32_t skippedBytes;  // Bytes discarded while hunting for a start byte
+  uint32_t timeouts;      // Partial frames abandoned by resync()
+  uint32_t bytes;         // Bytes committed
+};
+
+class MMDVMFrameParser {
+private:
+  static_assert((MMDVM_RX_RING_SIZE & (MMDVM_RX_RING_SIZE - 1)) == 0, "MMDVM_RX_RING_SIZE must be a power of two");
+  static_assert(MMDVM_RX_FRAME_MAX >= 255 && MMDVM_RX_FRAME_MAX <= MMDVM_RX_RING_SIZE / 2, "MMDVM_RX_FRAME_MAX out of range");
+
+  static const uint32_t MASK = MMDVM_RX_RING_SIZE - 1;
+
+  uint8_t ring[MMDVM_RX_RING_SIZE + MMDVM_RX_FRAME_MAX];  // Ring plus mirror of its first bytes
+  uint32_t writePos;                // Producer: next byte to write (free-running)
+  uint32_t parsePos;                // Producer: start of the next candidate frame
+  std::atomic<uint32_t> releasePos; // Consumer: end of the last popped frame
+  uint32_t reclaimPos;              // Producer: parsePos when a frame was published to an empty queue
+  SpscQueue<MMDVMFrameView, MMDVM_RX_QUEUE_DEPTH> frames;
+
+  // Time of the first byte of the frame at parsePos (when it was left incomplete)
+  uint32_t pendingPos;
+  int64_t pendingTime;
+  bool pendingValid;
+  bool blocked;  // Last parse stopped because the frame queue was full
+
+  MMDVMFrameParserStats stats;
+
+  uint8_t at(uint32_t pos) const {
+    return ring[pos & MASK];
+  }
+
+  // Oldest byte still in use. With no frames outstanding everything before
+  // parsePos is either released or garbage; otherwise the later of the last
+  // released frame end and the garbage skipped before the oldest frame.
+  uint32_t usedBase() const {
+    if (frames.isEmpty()) return parsePos;
+    uint32_t released = releasePos.load(std::memory_order_acquire);
+    return ((int32_t)(released - reclaimPos) > 0) ? released : reclaimPos;
+  }
+
+  void parse(int64_t timestamp) {
+    blocked = false;
+    while (parsePos != writePos) {
+      uint32_t available = writePos - parsePos;
+      uint8_t start = at(parsePos);
+      if (start != MMDVM_SHORT_FRAME_START && start != MMDVM_LONG_FRAME_START) {
+        parsePos++;
+        stats.skippedBytes++;
+        continue;
+      }
+
+      uint8_t header = (start == MMDVM_SHORT_FRAME_START) ? 2 : 3;
+      if (available < header) break;
+
+      uint16_t length = (start == MMDVM_SHORT_FRAME_START) ? at(parsePos + 1) : (uint16_t)((at(parsePos + 1) << 8) | at(parsePos + 2));
+      if (length < header + 1 || length > MMDVM_RX_FRAME_MAX) {
+        // Can't be a frame: drop the start byte and hunt for the next one
+        parsePos++;
+        stats.invalid++;
+        continue;
+      }
+      if (available < length) break;
+
+      if (frames.isEmpty()) reclaimPos = parsePos;
+      MMDVMFrameView* view = frames.acquire();
+      if (view == NULL) {
+        blocked = true;  // Retried by poll() once the consumer catches up
+        break;
+      }
+      view->data = &ring[parsePos & MASK];
+      view->length = length;
+      view->headerLength = header;
+      view->timestamp = (pendingValid && pendingPos == parsePos) ? pendingTime : timestamp;
+      view->endPos = parsePos + length;
+      frames.publish();
+
+      parsePos += length;
+      stats.frames++;
+      if (header == 3) stats.longFrames++;
+    }
+
+    if (parsePos != writePos && (!pendingValid || pendingPos != parsePos)) {
+      pendingPos = parsePos;
+      pendingTime = timestamp;
+      pendingValid = true;
+    }
+  }
+
+public:
+  MMDVMFrameParser()
+    : writePos(0), parsePos(0), releasePos(0), reclaimPos(0), pendingPos(0), pendingTime(0), pendingValid(false), blocked(false) {
+    memset(&stats, 0, sizeof(stats));
+  }
+
+  // Producer: contiguous free space to read into. space is 0 while the ring is full.
+  uint8_t* writeBuffer(size_t &space) {
+    uint32_t index = writePos & MASK;
+    uint32_t free = MMDVM_RX_RING_SIZE - (writePos - usedBase());
+    uint32_t toEnd = MMDVM_RX_RING_SIZE - index;
+    space = (free < toEnd) ? free : toEnd;
+    return &ring[index];
+  }
+
+  // Producer: n bytes were written into writeBuffer(); parse and publish frames
+  void commit(size_t n, int64_t timestamp) {
+    if (n == 0) return;
+    uint32_t index = writePos & MASK;
+    if (index < MMDVM_RX_FRAME_MAX) {
+      size_t mirror = MMDVM_RX_FRAME_MAX - index;
+      memcpy(&ring[MMDVM_RX_RING_SIZE + index], &ring[index], (n < mirror) ? n : mirror);
+    }
+    writePos += n;
+    stats.bytes += n;
+    parse(timestamp);
+  }
+
+  // Producer: copy bytes in (for sources that can't read in place). Returns bytes taken.
+  size_t write(const uint8_t* data, size_t length, int64_t timestamp) {
+    size_t taken = 0;
+    while (taken < length) {
+      size_t space;
+      uint8_t* dest = writeBuffer(space);
+      if (space == 0) break;
+      size_t n = (length - taken < space) ? length - taken : space;
+      memcpy(dest, data + taken, n);
+      commit(n, timestamp);
+      taken += n;
+    }
+    return taken;
+  }
+
+  // Producer: publish frames held back while the frame queue was full
+  void poll(int64_t timestamp) {
+    if (blocked) parse(timestamp);
+  }
+
+  // Producer: an incomplete frame is waiting for more bytes
+  bool hasPartial() const {
+    return parsePos != writePos && !blocked;
+  }
+
+  // Producer: give up on an incomplete frame (e.g. line went quiet mid-frame) and
+  // resync on the next start byte after it
+  void resync(int64_t timestamp) {
+    if (!hasPartial()) return;
+    parsePos++;
+    stats.timeouts++;
+    parse(timestamp);
+  }
+
+  // Consumer: oldest complete frame, or NULL
+  const MMDVMFrameView* front() {
+    return frames.front();
+  }
+
+  // Consumer: release the frame returned by front() and its ring space
+  void pop() {
+    const MMDVMFrameView* view = frames.front();
+    if (view == NULL) return;
+    releasePos.store(view->endPos, std::memory_order_release);
+    frames.pop();
+  }
+
+  // Frames waiting for the consumer
+  uint32_t pending() const {
+    return frames.size();
+  }
+
+  MMDVMFrameParserStats getStats() const {
+    return stats;
+  }
+};
+
+#endif // MMDVM_FRAME_PARSER_H
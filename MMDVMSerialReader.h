@@ -0,0 +1,198 @@
+/*
+ * MMDVMSerialReader.h - Event-driven MMDVM UART reader task for ESP32 MMDVM Hotspot
+ *
+ * Moves modem frame assembly out of loop(), where web requests, OLED redraws and
+ * API lookups could leave frames sitting in the UART FIFO for hundreds of ms.
+ * - HardwareSerial onReceive() (UART RX-timeout / FIFO-full events) wakes a
+ *   dedicated task pinned to MMDVM_RX_TASK_CORE
+ * - The task reads the UART straight into an MMDVMFrameParser ring; the DMR core task
+ *   dispatches the completed frames in place and then releases them
+ * - The consumer task (setConsumer()) is notified as soon as frames are waiting;
+ *   when the reader stopped on a full ring or frame queue, release() wakes it
+ *   again, so the bytes don't sit in the UART until the next RX event
+ * - Each frame carries the time its bytes were taken from the UART, so the
+ *   UART-to-dispatch latency can be reported on the status page
+ */
+
+#ifndef MMDVM_SERIAL_READER_H
+#define MMDVM_SERIAL_READER_H
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "MMDVMFrameParser.h"
+
+#ifndef MMDVM_RX_TASK_CORE
+#define MMDVM_RX_TASK_CORE 0  // loop() runs on core 1
+#endif
+
+#ifndef MMDVM_RX_TASK_PRIORITY
+#define MMDVM_RX_TASK_PRIORITY 5  // Above loop() (1), below the WiFi/lwIP tasks
+#endif
+
+#define MMDVM_RX_TASK_STACK 3072
+#define MMDVM_RX_IDLE_WAIT_MS 20            // Wake up periodically even without a UART event
+#define MMDVM_RX_FRAME_TIMEOUT_US 50000     // Line quiet this long mid-frame: resync past the partial frame
+
+// Reader statistics (copied out for the web interface)
+struct MMDVMSerialReaderStats {
+  uint32_t frames;         // Frames dispatched
+  uint32_t longFrames;     // Of which E1 (16-bit length) frames
+  uint32_t invalid;        // Start bytes dropped for an impossible length
+  uint32_t skippedBytes;   // Bytes discarded between frames
+  uint32_t timeouts;       // Partial frames abandoned after the line went quiet
+  uint32_t ringFull;       // Reads deferred because the main loop was behind
+  uint32_t bytes;          // Bytes read from the UART
+  uint8_t queueDepth;      // Frames currently waiting for dispatch
+  uint8_t peakQueueDepth;  // Highest queue depth seen
+  uint32_t lastLatencyUs;  // UART-to-dispatch latency of the last frame
+  uint32_t avgLatencyUs;   // Running average (1/16 weight per frame)
+  uint32_t maxLatencyUs;   // Worst latency since last reset
+};
+
+class MMDVMSerialReader {
+private:
+  HardwareSerial* port;
+  TaskHandle_t task;
+  TaskHandle_t consumer;  // Woken when frames are ready (NULL: consumer polls)
+  MMDVMFrameParser parser;
+  MMDVMSerialReaderStats stats;
+  portMUX_TYPE mux;
+  int64_t lastByteTime;  // Reader task only
+  std::atomic<bool> stalled;  // Last drain stopped for lack of ring or queue space
+
+  static void taskEntry(void* arg) {
+    static_cast<MMDVMSerialReader*>(arg)->run();
+  }
+
+  void run() {
+    while (true) {
+      // Woken by onReceive(); the timeout only covers a missed notification
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MMDVM_RX_IDLE_WAIT_MS));
+      drain();
+    }
+  }
+
+  // Read everything the UART has straight into the parser ring
+  void drain() {
+    int64_t now = esp_timer_get_time();
+    bool full = false;
+    size_t count = 0;
+
+    parser.poll(now);  // Frames held back while the queue was full
+    while (port->available() > 0) {
+      size_t space;
+      uint8_t* dest = parser.writeBuffer(space);
+      if (space == 0) {
+        // Dispatch is behind; bytes wait in the UART driver buffer
+        full = true;
+        break;
+      }
+      size_t available = port->available();
+      size_t n = port->read(dest, (available < space) ? available : space);
+      if (n == 0) break;
+      parser.commit(n, now);
+      count += n;
+    }
+
+    if (count > 0) {
+      lastByteTime = now;
+    } else if (parser.hasPartial() && now - lastByteTime > MMDVM_RX_FRAME_TIMEOUT_US) {
+      parser.resync(now);
+    }
+
+    uint8_t depth = parser.pending();
+    bool noRoom = full || depth >= MMDVM_RX_QUEUE_DEPTH;
+    stalled.store(noRoom, std::memory_order_release);
+    if (noRoom) {
+      // The consumer may have freed everything before stalled was set
+      size_t space;
+      parser.writeBuffer(space);
+      if (space > 0 && parser.pending() < MMDVM_RX_QUEUE_DEPTH && stalled.exchange(false, std::memory_order_acq_rel)) {
+        xTaskNotifyGive(task);
+      }
+    }
+    if (depth > 0 && consumer != NULL) xTaskNotifyGive(consumer);
+    portENTER_CRITICAL(&mux);
+    if (full) stats.ringFull++;
+    if (depth > stats.peakQueueDepth) stats.peakQueueDepth = depth;
+    portEXIT_CRITICAL(&mux);
+  }
+
+public:
+  MMDVMSerialReader()
+    : port(NULL), task(NULL), consumer(NULL), mux(portMUX_INITIALIZER_UNLOCKED), lastByteTime(0), stalled(false) {
+    memset(&stats, 0, sizeof(stats));
+  }
+
+  // Start the reader task on an already opened port. Call after any synchronous
+  // modem handshake, since the task takes over all reads from then on.
+  bool begin(HardwareSerial &modemPort) {
+    if (task != NULL) return true;
+    port = &modemPort;
+
+    // Wake on the UART RX timeout (1 symbol of idle line) instead of only on FIFO full
+    port->setRxTimeout(1);
+    port->onReceive([this]() {
+      if (task != NULL) xTaskNotifyGive(task);
+    }, false);
+
+    return xTaskCreatePinnedToCore(taskEntry, "mmdvm_rx", MMDVM_RX_TASK_STACK, this,
+                                   MMDVM_RX_TASK_PRIORITY, &task, MMDVM_RX_TASK_CORE) == pdPASS;
+  }
+
+  // Task to notify (xTaskNotifyGive) whenever frames are waiting
+  void setConsumer(TaskHandle_t handle) {
+    consumer = handle;
+  }
+
+  bool isRunning() const {
+    return task != NULL;
+  }
+
+  // Consumer: next complete frame, or NULL. Valid until release().
+  const MMDVMFrameView* next() {
+    return parser.front();
+  }
+
+  // Consumer: record dispatch latency and free the frame returned by next()
+  void release(const MMDVMFrameView* frame) {
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - frame->timestamp);
+    parser.pop();
+    if (stalled.exchange(false, std::memory_order_acq_rel) && task != NULL) {
+      xTaskNotifyGive(task);  // Room again: read what waited in the UART
+    }
+
+    portENTER_CRITICAL(&mux);
+    stats.frames++;
+    stats.lastLatencyUs = latency;
+    if (stats.avgLatencyUs == 0) {
+      stats.avgLatencyUs = latency;
+    } else {
+      stats.avgLatencyUs = stats.avgLatencyUs - (stats.avgLatencyUs >> 4) + (latency >> 4);
+    }
+    if (latency > stats.maxLatencyUs) stats.maxLatencyUs = latency;
+    portEXIT_CRITICAL(&mux);
+  }
+
+  MMDVMSerialReaderStats getStats() {
+    portENTER_CRITICAL(&mux);
+    MMDVMSerialReaderStats copy = stats;
+    portEXIT_CRITICAL(&mux);
+    MMDVMFrameParserStats parsed = parser.getStats();
+    copy.longFrames = parsed.longFrames;
+    copy.invalid = parsed.invalid;
+    copy.skippedBytes = parsed.skippedBytes;
+    copy.timeouts = parsed.timeouts;
+    copy.bytes = parsed.bytes;
+    copy.queueDepth = parser.pending();
+    return copy;
+  }
+
+  void resetStats() {
+    portENTER_CRITICAL(&mux);
+    memset(&stats, 0, sizeof(stats));
+    portEXIT_CRITICAL(&mux);
+  }
+};
+
+#endif // MMDVM_SERIAL_READER_H
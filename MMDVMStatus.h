@@ -0,0 +1,113 @@
+/*
+ * MMDVMStatus.h - MMDVM modem status (CMD_GET_STATUS) decoding for ESP32 MMDVM Hotspot
+ *
+ * The modem is polled every MMDVM_STATUS_POLL_INTERVAL ms (MMDVMHost uses 250 ms).
+ * The reply carries the current mode, TX state, overflow flags and the free
+ * buffer space per mode, which drives flow control of the TX queue.
+ *
+ * Reply layout (payload offsets, after E0 LEN CMD):
+ *   Protocol v1: [0] modes enabled, [1] mode, [2] flags, [3] D-Star space,
+ *                [4] DMR slot 1 space, [5] DMR slot 2 space, [6] YSF, [7] P25,
+ *                [8] NXDN, [9] POCSAG (optional)
+ *   Protocol v2: [0] mode, [1] flags, [2] reserved, [3] D-Star space,
+ *                [4] DMR slot 1 space, [5] DMR slot 2 space, [6] YSF, [7] P25,
+ *                [8] NXDN, [9] M17, [10] FM, [11] POCSAG (optional)
+ *   Flags: 0x01 TX, 0x02 ADC overflow, 0x04 RX overflow, 0x08 TX overflow,
+ *          0x10 lockout, 0x20 DAC overflow, 0x40 carrier detect
+ */
+
+#ifndef MMDVM_STATUS_H
+#define MMDVM_STATUS_H
+
+#include <Arduino.h>
+
+#ifndef MMDVM_STATUS_POLL_INTERVAL
+#define MMDVM_STATUS_POLL_INTERVAL 250  // Milliseconds between CMD_GET_STATUS polls
+#endif
+
+struct MMDVMStatus {
+  bool valid;               // At least one status reply decoded
+  uint8_t protocolVersion;  // From CMD_GET_VERSION reply byte 3
+  uint8_t modesEnabled;     // Protocol v1 only (bitfield, same as config byte 1)
+  uint8_t mode;             // 0=IDLE 1=D-Star 2=DMR 3=YSF 4=P25 5=NXDN 7=POCSAG ...
+  bool tx;
+  bool adcOverflow;
+  bool rxOverflow;
+  bool txOverflow;
+  bool lockout;
+  bool dacOverflow;
+  bool carrierDetect;
+  uint8_t dstarSpace;
+  uint8_t dmrSpace1;        // Free DMR frames in the slot 1 TX buffer
+  uint8_t dmrSpace2;        // Free DMR frames in the slot 2 TX buffer (simplex: the DMO buffer)
+  uint8_t ysfSpace;
+  uint8_t p25Space;
+  uint8_t nxdnSpace;
+  uint8_t pocsagSpace;
+  unsigned long lastUpdate; // millis() of the last decoded reply
+  uint32_t polls;           // Status requests sent
+  uint32_t replies;         // Status replies decoded
+  uint32_t rxOverflows;     // Replies reporting an RX overflow
+  uint32_t txOverflows;     // Replies reporting a TX overflow
+  uint32_t nakNoSpace;      // NAKs with reason "Not Enough Buffer Space"
+};
+
+// Decode a CMD_GET_STATUS reply payload (the bytes after E0 LEN CMD). Counters are left
+// untouched except "replies" and the overflow counts.
+inline bool parseMMDVMStatus(const uint8_t* payload, uint16_t length, uint8_t protocolVersion, MMDVMStatus &status) {
+  if (length < 9) return false;
+
+  uint8_t flags;
+  if (protocolVersion >= 2) {
+    status.mode = payload[0];
+    flags = payload[1];
+    status.pocsagSpace = (length > 11) ? payload[11] : 0;
+  } else {
+    status.modesEnabled = payload[0];
+    status.mode = payload[1];
+    flags = payload[2];
+    status.pocsagSpace = (length > 9) ? payload[9] : 0;
+  }
+
+  status.tx = (flags & 0x01) != 0;
+  status.adcOverflow = (flags & 0x02) != 0;
+  status.rxOverflow = (flags & 0x04) != 0;
+  status.txOverflow = (flags & 0x08) != 0;
+  status.lockout = (flags & 0x10) != 0;
+  status.dacOverflow = (flags & 0x20) != 0;
+  status.carrierDetect = (flags & 0x40) != 0;
+
+  status.dstarSpace = payload[3];
+  status.dmrSpace1 = payload[4];
+  status.dmrSpace2 = payload[5];
+  status.ysfSpace = payload[6];
+  status.p25Space = payload[7];
+  status.nxdnSpace = payload[8];
+
+  if (status.rxOverflow) status.rxOverflows++;
+  if (status.txOverflow) status.txOverflows++;
+
+  status.protocolVersion = protocolVersion;
+  status.lastUpdate = millis();
+  status.replies++;
+  status.valid = true;
+  return true;
+}
+
+inline const char* getMMDVMModeName(uint8_t mode) {
+  switch (mode) {
+    case 0x00: return "IDLE";
+    case 0x01: return "D-Star";
+    case 0x02: return "DMR";
+    case 0x03: return "YSF";
+    case 0x04: return "P25";
+    case 0x05: return "NXDN";
+    case 0x07: return "POCSAG";
+    case 0x63: return "CW";
+    case 0x64: return "Lockout";
+    case 0x65: return "Error";
+    default: return "Unknown";
+  }
+}
+
+#endif // MMDVM_STATUS_H
@@ -0,0 +1,359 @@
+/*
+ * ModemTxQueue.h - Paced DMR frame playout queue for ESP32 MMDVM Hotspot
+ *
+ * Holds network->modem DMR frames per timeslot and writes them to the modem
+ * UART on a 60 ms TDMA playout clock (esp_timer), so handleNetwork() can
+ * enqueue a frame and return immediately instead of blocking in delay().
+ * - One fixed-size ring per slot, no heap allocation after begin()
+ * - Flow control: once the modem reports its free DMR buffer space (CMD_GET_STATUS
+ *   poll), frames are written as long as the modem has room; without status
+ *   replies it falls back to one frame per slot per tick. In simplex (DMO) the
+ *   firmware has one buffer for both slots and reports it as the slot 2 space
+ * - Depth / peak depth / underrun / overflow counters for the status page
+ * - Network DMR frames go through a per-slot DMRJitterBuffer first (enqueueDMR),
+ *   which puts them back in sequence order and conceals lost bursts
+ * - Frames are built in place in the ring: the jitter buffer writes each burst
+ *   straight behind headroom for the E0 header (mmdvmFrameBuild), so the payload
+ *   is copied once from the jitter buffer and the playout clock writes each
+ *   frame to the UART in one write. One spare ring slot takes the frame being
+ *   built, so a full queue only drops its oldest frame once a new one exists.
+ * - The playout clock runs in the esp_timer task, which must never block. The
+ *   modem port needs a UART TX ring buffer of at least MODEM_TX_UART_BUFFER_MIN
+ *   bytes (setTxBufferSize() before begin()), so a write only copies into it
+ *   instead of waiting for the 128-byte hardware FIFO to drain.
+ */
+
+#ifndef MODEM_TX_QUEUE_H
+#define MODEM_TX_QUEUE_H
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "DMRJitterBuffer.h"
+#include "MMDVMFrameParser.h"
+
+#ifndef MODEM_TX_QUEUE_DEPTH
+#define MODEM_TX_QUEUE_DEPTH 16  // Frames buffered per slot (16 x 60 ms = ~1 s)
+#endif
+
+#define MODEM_TX_FRAME_MAX 40               // Largest modem frame we queue (E0 + len + cmd + 34 bytes payload)
+#define MODEM_TX_RING_SIZE (MODEM_TX_QUEUE_DEPTH + 1)  // Queued frames plus the one being built
+#define MODEM_TX_PLAYOUT_INTERVAL_US 60000  // One DMR TDMA frame (two 30 ms slots)
+#define MODEM_TX_STREAM_HOLDOFF_TICKS 6     // Empty ticks (360 ms = one superframe) before a stream is considered over
+#define MODEM_TX_SPACE_RESERVE 1            // Keep one modem buffer slot free (as MMDVMHost does)
+#define MODEM_TX_SPACE_STALE_MS 1000        // Fall back to paced playout if no status reply for this long
+#define MODEM_TX_UART_BUFFER_MIN (2 * MODEM_TX_QUEUE_DEPTH * MODEM_TX_FRAME_MAX)  // Both slots' queues in the UART TX buffer
+
+// MMDVM DMR data commands (same values as the sketch's command table)
+#ifndef CMD_DMR_DATA1
+#define CMD_DMR_DATA1 0x18
+#endif
+#ifndef CMD_DMR_DATA2
+#define CMD_DMR_DATA2 0x1A
+#endif
+
+// Per-slot queue statistics (copied out for the web interface)
+struct ModemTxQueueStats {
+  uint8_t depth;          // Frames currently waiting
+  uint8_t peakDepth;      // Highest depth seen since last reset
+  uint32_t enqueued;      // Frames accepted
+  uint32_t played;        // Frames written to the modem
+  uint32_t underruns;     // Playout ticks that found the queue empty mid-stream
+  uint32_t overflows;     // Frames dropped because the queue was full (oldest dropped)
+  uint32_t waitForSpace;  // Playout ticks where frames waited because the modem buffer was full
+};
+
+class ModemTxQueue {
+private:
+  struct Frame {
+    uint8_t data[MODEM_TX_FRAME_MAX];
+    uint8_t length;
+    bool endOfStream;
+  };
+
+  struct SlotQueue {
+    Frame frames[MODEM_TX_RING_SIZE];
+    uint8_t head;        // Next frame to play
+    uint8_t count;       // Frames waiting
+    bool streaming;      // A stream is in progress on this slot
+    uint8_t idleTicks;   // Consecutive empty ticks while streaming
+    uint8_t modemSpace;  // Free frames in the modem buffer (from the last status reply, minus writes since)
+    volatile unsigned long lastPlayoutTime;  // millis() of the last frame written for this slot
+    ModemTxQueueStats stats;
+  };
+
+  SlotQueue slots[2];
+  DMRJitterBuffer jitter[2];
+  Print* port;
+  esp_timer_handle_t timer;
+  portMUX_TYPE mux;
+  volatile unsigned long lastPlayoutTime;
+  bool flowControl;                // Modem buffer space is known
+  bool sharedSpace;                // Simplex: both slots draw on slots[1].modemSpace (the DMO buffer)
+  unsigned long spaceUpdateTime;   // millis() of the last setModemSpace()
+
+  // Take the next frame for a slot if the modem can accept it (call with mux held)
+  bool popFrame(SlotQueue &q, bool useSpace, Frame &frame) {
+    if (q.count == 0) return false;
+    if (useSpace) {
+      uint8_t &space = sharedSpace ? slots[1].modemSpace : q.modemSpace;
+      if (space <= MODEM_TX_SPACE_RESERVE) {
+        q.stats.waitForSpace++;
+        return false;
+      }
+      space--;
+    }
+    frame = q.frames[q.head];  // Copied out: the UART write happens after the mux is released
+    q.head = (q.head + 1) % MODEM_TX_RING_SIZE;
+    q.count--;
+    q.idleTicks = 0;
+    q.stats.played++;
+    q.stats.depth = q.count;
+    if (frame.endOfStream) {
+      q.streaming = false;
+    }
+    return true;
+  }
+
+  // Ring slot behind the queued frames, where the next frame is built (call with mux held)
+  Frame &spareFrame(SlotQueue &q) {
+    return q.frames[(q.head + q.count) % MODEM_TX_RING_SIZE];
+  }
+
+  // Queue the frame built in spareFrame(): payload at data[MMDVM_FRAME_HEADROOM],
+  // the header goes in front of it (call with mux held)
+  void commitFrame(SlotQueue &q, uint8_t cmd, uint8_t length, bool endOfStream) {
+    Frame &frame = spareFrame(q);
+    frame.length = mmdvmFrameBuild(frame.data, cmd, length);
+    frame.endOfStream = endOfStream;
+
+    if (q.count == MODEM_TX_QUEUE_DEPTH) {
+      q.head = (q.head + 1) % MODEM_TX_RING_SIZE;
+      q.count--;
+      q.stats.overflows++;
+    }
+
+    // Stream resumed after the playout clock found the queue empty
+    if (q.streaming && q.idleTicks > 0) {
+      q.stats.underruns++;
+    }
+    q.streaming = !endOfStream;
+    q.idleTicks = 0;
+
+    q.count++;
+    q.stats.enqueued++;
+    q.stats.depth = q.count;
+    if (q.count > q.stats.peakDepth) {
+      q.stats.peakDepth = q.count;
+    }
+  }
+
+  // Move frames the jitter buffer has released into the slot queue (call with mux held)
+  void releaseJitter(int s, uint32_t now) {
+    SlotQueue &q = slots[s];
+    DMRJitterFrame frame;
+    while (true) {
+      uint8_t* payload = &spareFrame(q).data[MMDVM_FRAME_HEADROOM];
+      frame.data = &payload[1];  // Burst goes behind the control byte
+      if (!jitter[s].next(frame, now)) break;
+      payload[0] = 0x00;  // Control byte
+      commitFrame(q, (s == 0) ? CMD_DMR_DATA1 : CMD_DMR_DATA2, DMR_PAYLOAD_LENGTH + 1, frame.isTerminator());
+    }
+  }
+
+  static void onTimer(void* arg) {
+    static_cast<ModemTxQueue*>(arg)->tick();
+  }
+
+  // Playout clock (every 60 ms): with known modem space write everything that fits,
+  // otherwise write at most one frame per slot. Runs in the esp_timer task, so it
+  // must not block: the writes go into the UART TX ring buffer.
+  void tick() {
+    portENTER_CRITICAL(&mux);
+    bool useSpace = flowControl && (millis() - spaceUpdateTime < MODEM_TX_SPACE_STALE_MS);
+    portEXIT_CRITICAL(&mux);
+
+    for (int s = 0; s < 2; s++) {
+      SlotQueue &q = slots[s];
+      bool wrote = false;
+
+      // Gaps the jitter buffer has stopped waiting for are concealed here
+      portENTER_CRITICAL(&mux);
+      releaseJitter(s, millis());
+      portEXIT_CRITICAL(&mux);
+
+      while (true) {
+        Frame frame;
+        portENTER_CRITICAL(&mux);
+        bool haveFrame = popFrame(q, useSpace, frame);
+        if (!haveFrame && !wrote && q.count == 0 && q.streaming) {
+          // Starved mid-stream; decided in enqueue() whether this was a real underrun
+          if (++q.idleTicks > MODEM_TX_STREAM_HOLDOFF_TICKS) {
+            q.streaming = false;
+            q.idleTicks = 0;
+          }
+        }
+        portEXIT_CRITICAL(&mux);
+
+        if (!haveFrame) break;
+
+        // UART write happens outside the critical section (copies into the TX ring buffer)
+        if (port != NULL) {
+          port->write(frame.data, frame.length);
+          lastPlayoutTime = millis();
+          q.lastPlayoutTime = lastPlayoutTime;
+        }
+        wrote = true;
+        if (!useSpace) break;
+      }
+    }
+  }
+
+public:
+  ModemTxQueue()
+    : port(NULL), timer(NULL), mux(portMUX_INITIALIZER_UNLOCKED), lastPlayoutTime(0),
+      flowControl(false), sharedSpace(false), spaceUpdateTime(0) {
+    memset(slots, 0, sizeof(slots));
+  }
+
+  // Start the playout clock, writing frames to the given modem port
+  bool begin(Print &modemPort) {
+    port = &modemPort;
+    if (timer != NULL) return true;
+
+    esp_timer_create_args_t args = {};
+    args.callback = &ModemTxQueue::onTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "modem_tx";
+    if (esp_timer_create(&args, &timer) != ESP_OK) {
+      timer = NULL;
+      return false;
+    }
+    return esp_timer_start_periodic(timer, MODEM_TX_PLAYOUT_INTERVAL_US) == ESP_OK;
+  }
+
+  // Queue a modem command for playout on slot (1 or 2). Never blocks.
+  // When the queue is full the oldest frame is dropped so latency stays bounded.
+  bool enqueue(uint8_t slotNo, uint8_t cmd, const uint8_t* data, uint8_t length, bool endOfStream = false) {
+    if (slotNo < 1 || slotNo > 2 || length + MMDVM_FRAME_HEADROOM > MODEM_TX_FRAME_MAX) return false;
+
+    portENTER_CRITICAL(&mux);
+    SlotQueue &q = slots[slotNo - 1];
+    memcpy(&spareFrame(q).data[MMDVM_FRAME_HEADROOM], data, length);
+    commitFrame(q, cmd, length, endOfStream);
+    portEXIT_CRITICAL(&mux);
+    return true;
+  }
+
+  // Queue a received DMRD packet through its slot's jitter buffer (the burst is copied
+  // out, so the packet buffer can be released straight after)
+  bool enqueueDMR(const DmrdView &dmrd) {
+    return enqueueDMR(dmrd.slotNo(), dmrd.seq(), dmrd.streamId(), dmrd.flags(), dmrd.payload());
+  }
+
+  // Queue a DMRD frame (seq = packet[4], stream ID = packet[16..19],
+  // flags = packet[15], payload = the 33 DMR bytes) through the slot's jitter buffer.
+  // local: built by the hotspot rather than received (kept out of the jitter estimate)
+  bool enqueueDMR(uint8_t slotNo, uint8_t seq, uint32_t streamId, uint8_t flags, const uint8_t* payload, bool local = false) {
+    if (slotNo < 1 || slotNo > 2) return false;
+    uint32_t now = millis();
+    portENTER_CRITICAL(&mux);
+    jitter[slotNo - 1].insert(seq, streamId, flags, payload, now, local);
+    releaseJitter(slotNo - 1, now);
+    portEXIT_CRITICAL(&mux);
+    return true;
+  }
+
+  // Update free modem buffer space (in frames) from a CMD_GET_STATUS reply. A simplex
+  // modem reports a fixed 10 for slot 1 and its DMO buffer as space2, which then
+  // gates both slots.
+  void setModemSpace(uint8_t space1, uint8_t space2, bool duplex) {
+    portENTER_CRITICAL(&mux);
+    slots[0].modemSpace = duplex ? space1 : space2;
+    slots[1].modemSpace = space2;
+    sharedSpace = !duplex;
+    flowControl = true;
+    spaceUpdateTime = millis();
+    portEXIT_CRITICAL(&mux);
+  }
+
+  // True while frames are paced by reported modem space rather than the fixed clock
+  bool isFlowControlled() {
+    portENTER_CRITICAL(&mux);
+    bool active = flowControl && (millis() - spaceUpdateTime < MODEM_TX_SPACE_STALE_MS);
+    portEXIT_CRITICAL(&mux);
+    return active;
+  }
+
+  // Drop everything queued on a slot (e.g. on network disconnect)
+  void flush(uint8_t slotNo) {
+    if (slotNo < 1 || slotNo > 2) return;
+    portENTER_CRITICAL(&mux);
+    SlotQueue &q = slots[slotNo - 1];
+    q.head = 0;
+    q.count = 0;
+    q.streaming = false;
+    q.idleTicks = 0;
+    q.stats.depth = 0;
+    jitter[slotNo - 1].reset();
+    portEXIT_CRITICAL(&mux);
+  }
+
+  bool isEmpty() {
+    portENTER_CRITICAL(&mux);
+    bool empty = slots[0].count == 0 && slots[1].count == 0 && jitter[0].depth() == 0 && jitter[1].depth() == 0;
+    portEXIT_CRITICAL(&mux);
+    return empty;
+  }
+
+  // Nothing queued or buffered for one slot
+  bool isEmpty(uint8_t slotNo) {
+    if (slotNo < 1 || slotNo > 2) return true;
+    portENTER_CRITICAL(&mux);
+    bool empty = slots[slotNo - 1].count == 0 && jitter[slotNo - 1].depth() == 0;
+    portEXIT_CRITICAL(&mux);
+    return empty;
+  }
+
+  // millis() of the last frame written to the modem
+  unsigned long lastPlayout() const {
+    return lastPlayoutTime;
+  }
+
+  // ... for one slot
+  unsigned long lastPlayout(uint8_t slotNo) const {
+    if (slotNo < 1 || slotNo > 2) return 0;
+    return slots[slotNo - 1].lastPlayoutTime;
+  }
+
+  ModemTxQueueStats getStats(uint8_t slotNo) {
+    ModemTxQueueStats copy = {};
+    if (slotNo < 1 || slotNo > 2) return copy;
+    portENTER_CRITICAL(&mux);
+    copy = slots[slotNo - 1].stats;
+    portEXIT_CRITICAL(&mux);
+    return copy;
+  }
+
+  DMRJitterStats getJitterStats(uint8_t slotNo) {
+    DMRJitterStats copy = {};
+    if (slotNo < 1 || slotNo > 2) return copy;
+    portENTER_CRITICAL(&mux);
+    copy = jitter[slotNo - 1].getStats();
+    portEXIT_CRITICAL(&mux);
+    return copy;
+  }
+
+  void resetStats() {
+    portENTER_CRITICAL(&mux);
+    for (int s = 0; s < 2; s++) {
+      uint8_t depth = slots[s].stats.depth;
+      memset(&slots[s].stats, 0, sizeof(ModemTxQueueStats));
+      slots[s].stats.depth = depth;
+      slots[s].stats.peakDepth = depth;
+    }
+    portEXIT_CRITICAL(&mux);
+  }
+};
+
+#endif // MODEM_TX_QUEUE_H
@@ -0,0 +1,592 @@
+/*
+ * SDUserDatabase.h - Offline DMR user lookups from the SD card for ESP32 MMDVM Hotspot
+ *
+ * The radioid database (/database/database.csv, downloaded by the database_sdcard
+ * sketch) is several MB, far too large to scan per lookup. A sorted fixed-width
+ * index is kept next to it:
+ * - /database/database.idx: one 512-byte header block, then 8-byte entries
+ *   { uint32 DMR ID, uint32 CSV line offset } sorted by ID, 64 per 512-byte block
+ * - Built by a background task on first boot, or when the CSV size / timestamp no
+ *   longer match the header (i.e. after a new download); written to a temp file
+ *   and renamed, so a half-built index is never used
+ * - A sparse fence (first ID of every DMR_DB_FENCE_STRIDE-th block) stays in RAM;
+ *   a lookup is a binary search over at most DMR_DB_FENCE_STRIDE index blocks
+ *   plus one CSV read: a handful of 512-byte SD reads
+ * - Index build time and lookup latency (p99 over the last DMR_DB_LATENCY_SAMPLES
+ *   lookups) for the status page
+ *
+ * CSV columns (radioid user.csv layout): RADIO_ID,CALLSIGN,FIRST_NAME,LAST_NAME,CITY,STATE,COUNTRY
+ * Lines that don't start with a number (e.g. the header line) are skipped.
+ *
+ * If /database/database.udb (compact format from database-converter, see
+ * UserDatabaseFormat.h) is on the card it is used instead of the CSV: its block
+ * index and dictionaries are loaded into (PSRAM) memory and no index is built.
+ */
+
+#ifndef SD_USER_DATABASE_H
+#define SD_USER_DATABASE_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include <algorithm>
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "UserDatabaseFormat.h"
+
+#ifndef DMR_DB_CSV_PATH
+#define DMR_DB_CSV_PATH "/database/database.csv"
+#endif
+
+#ifndef DMR_DB_INDEX_PATH
+#define DMR_DB_INDEX_PATH "/database/database.idx"
+#endif
+
+#ifndef DMR_DB_COMPACT_PATH
+#define DMR_DB_COMPACT_PATH "/database/database.udb"
+#endif
+
+#ifndef DMR_DB_FENCE_STRIDE
+#define DMR_DB_FENCE_STRIDE 16  // Index blocks per in-RAM fence entry (max blocks searched on the card)
+#endif
+
+#define DMR_DB_INDEX_TEMP_PATH DMR_DB_INDEX_PATH ".tmp"
+#define DMR_DB_INDEX_MAGIC 0x58444944  // "DIDX"
+#define DMR_DB_INDEX_VERSION 1
+#define DMR_DB_BLOCK_SIZE 512
+#define DMR_DB_ENTRIES_PER_BLOCK (DMR_DB_BLOCK_SIZE / sizeof(SDUserIndexEntry))
+#define DMR_DB_BUILD_CHUNK 4096   // CSV bytes read per SD access while building
+#define DMR_DB_RECORD_MAX 256     // Longest CSV line read back on a lookup
+#define DMR_DB_LATENCY_SAMPLES 128
+#define DMR_DB_TASK_STACK 4096
+#define DMR_DB_TASK_PRIORITY 1
+
+#ifndef APP_TASK_CORE
+#define APP_TASK_CORE 1  // Same core as loop(), away from the DMR core task
+#endif
+
+// CSV column numbers
+#define DMR_DB_COL_CALLSIGN 1
+#define DMR_DB_COL_NAME 2
+#define DMR_DB_COL_CITY 4
+#define DMR_DB_COL_COUNTRY 6
+
+struct SDUserIndexEntry {
+  uint32_t dmrId;
+  uint32_t offset;  // Start of the CSV line
+};
+
+// First bytes of the index file (rest of the header block is zero)
+struct SDUserIndexHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t entrySize;
+  uint32_t count;    // Entries
+  uint32_t csvSize;  // CSV the index was built from
+  uint32_t csvTime;
+  uint32_t buildMs;
+};
+
+enum SDUserDatabaseState {
+  DMR_DB_IDLE,      // Not started
+  DMR_DB_NO_CSV,    // No database on the card
+  DMR_DB_BUILDING,  // Index being (re)built
+  DMR_DB_READY,
+  DMR_DB_FAILED     // Index could not be built or read
+};
+
+// Database statistics (copied out for the web interface)
+struct SDUserDatabaseStats {
+  SDUserDatabaseState state;
+  uint32_t entries;       // Indexed DMR IDs
+  uint32_t fileSize;      // CSV or compact database
+  bool compact;           // Using database.udb rather than the CSV index
+  uint32_t buildMs;       // Time the index took to build
+  uint32_t loadMs;        // Time to validate the index and read the fence
+  bool built;             // Index was (re)built this boot rather than loaded
+  uint32_t lookups;
+  uint32_t hits;
+  uint32_t blockReads;    // SD reads over all lookups (index blocks, records and strings)
+  uint32_t lastLookupUs;
+  uint32_t p99LookupUs;   // Over the last DMR_DB_LATENCY_SAMPLES lookups
+  uint32_t maxLookupUs;
+};
+
+// SD file as a UserDatabaseReader source
+class SDFileSource {
+public:
+  File* file;
+
+  SDFileSource() : file(NULL) {}
+
+  bool readAt(uint32_t offset, uint8_t* buffer, size_t length) {
+    if (!file->seek(offset)) return false;
+    size_t n = file->read(buffer, length);
+    if (n < length) memset(buffer + n, 0, length - n);  // Pool strings at the end of the file
+    return n > 0;
+  }
+};
+
+class SDUserDatabase {
+private:
+  File indexFile;  // Kept open while READY (guarded by lock)
+  File csvFile;
+  File compactFile;
+  SDFileSource compactSource;
+  UserDatabaseReader<SDFileSource> compact;
+  bool useCompact;
+  uint32_t* fence;
+  uint32_t fenceCount;
+  uint32_t count;
+  uint32_t blockCount;
+  volatile SDUserDatabaseState state;
+  uint32_t latencies[DMR_DB_LATENCY_SAMPLES];
+  uint32_t latencyCount;
+  SemaphoreHandle_t lock;
+  TaskHandle_t task;
+  portMUX_TYPE mux;
+  SDUserDatabaseStats stats;
+
+  static void taskEntry(void* arg) {
+    static_cast<SDUserDatabase*>(arg)->run();
+  }
+
+  void run() {
+    while (true) {
+      open();
+      // Woken again by rebuild()
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      close();
+      SD.remove(DMR_DB_INDEX_PATH);
+    }
+  }
+
+  void setState(SDUserDatabaseState s) {
+    portENTER_CRITICAL(&mux);
+    state = s;
+    stats.state = s;
+    portEXIT_CRITICAL(&mux);
+  }
+
+  void close() {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    setState(DMR_DB_IDLE);
+    if (indexFile) indexFile.close();
+    if (csvFile) csvFile.close();
+    compact.close();
+    if (compactFile) compactFile.close();
+    useCompact = false;
+    free(fence);
+    fence = NULL;
+    fenceCount = 0;
+    xSemaphoreGive(lock);
+  }
+
+  static void* allocTables(size_t bytes) {
+    void* p = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    return (p != NULL) ? p : heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+  }
+
+  static void freeTables(void* p) {
+    heap_caps_free(p);
+  }
+
+  // Compact database: header check and in-memory tables only, nothing to build
+  bool openCompact() {
+    unsigned long start = millis();
+    File file = SD.open(DMR_DB_COMPACT_PATH, FILE_READ);
+    if (!file) return false;
+    uint32_t size = file.size();
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    compactFile = file;
+    compactSource.file = &compactFile;
+    useCompact = compact.open(&compactSource, size, allocTables, freeTables);
+    if (!useCompact) compactFile.close();
+    xSemaphoreGive(lock);
+    if (!useCompact) return false;
+
+    portENTER_CRITICAL(&mux);
+    stats.compact = true;
+    stats.entries = compact.getHeader().recordCount;
+    stats.fileSize = size;
+    stats.buildMs = 0;
+    stats.loadMs = millis() - start;
+    portEXIT_CRITICAL(&mux);
+    return true;
+  }
+
+  // Use the compact database if present; else the CSV index if it matches the CSV,
+  // otherwise build one first
+  void open() {
+    if (openCompact()) {
+      setState(DMR_DB_READY);
+      return;
+    }
+
+    File csv = SD.open(DMR_DB_CSV_PATH, FILE_READ);
+    if (!csv) {
+      setState(DMR_DB_NO_CSV);
+      return;
+    }
+    uint32_t csvSize = csv.size();
+    uint32_t csvTime = (uint32_t)csv.getLastWrite();
+    csv.close();
+
+    if (!load(csvSize, csvTime)) {
+      setState(DMR_DB_BUILDING);
+      uint32_t buildMs = build(csvSize, csvTime);
+      if (buildMs == 0 || !load(csvSize, csvTime)) {
+        SD.remove(DMR_DB_INDEX_TEMP_PATH);
+        setState(DMR_DB_FAILED);
+        return;
+      }
+      portENTER_CRITICAL(&mux);
+      stats.built = true;
+      portEXIT_CRITICAL(&mux);
+    }
+    setState(DMR_DB_READY);
+  }
+
+  // Validate the index header and read the fence. Leaves both files open on success.
+  bool load(uint32_t csvSize, uint32_t csvTime) {
+    unsigned long start = millis();
+    File idx = SD.open(DMR_DB_INDEX_PATH, FILE_READ);
+    if (!idx) return false;
+
+    SDUserIndexHeader header;
+    if (idx.read((uint8_t*)&header, sizeof(header)) != sizeof(header) ||
+        header.magic != DMR_DB_INDEX_MAGIC || header.version != DMR_DB_INDEX_VERSION ||
+        header.entrySize != sizeof(SDUserIndexEntry) || header.csvSize != csvSize || header.csvTime != csvTime ||
+        idx.size() != DMR_DB_BLOCK_SIZE + header.count * sizeof(SDUserIndexEntry) || header.count == 0) {
+      idx.close();
+      return false;
+    }
+
+    uint32_t blocks = (header.count + DMR_DB_ENTRIES_PER_BLOCK - 1) / DMR_DB_ENTRIES_PER_BLOCK;
+    uint32_t fences = (blocks + DMR_DB_FENCE_STRIDE - 1) / DMR_DB_FENCE_STRIDE;
+    uint32_t* ids = (uint32_t*)malloc(fences * sizeof(uint32_t));
+    if (ids == NULL) {
+      idx.close();
+      return false;
+    }
+    for (uint32_t i = 0; i < fences; i++) {
+      if (!idx.seek(DMR_DB_BLOCK_SIZE + i * DMR_DB_FENCE_STRIDE * DMR_DB_BLOCK_SIZE) ||
+          idx.read((uint8_t*)&ids[i], sizeof(uint32_t)) != sizeof(uint32_t)) {
+        free(ids);
+        idx.close();
+        return false;
+      }
+    }
+
+    File csv = SD.open(DMR_DB_CSV_PATH, FILE_READ);
+    if (!csv) {
+      free(ids);
+      idx.close();
+      return false;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    indexFile = idx;
+    csvFile = csv;
+    fence = ids;
+    fenceCount = fences;
+    count = header.count;
+    blockCount = blocks;
+    xSemaphoreGive(lock);
+
+    portENTER_CRITICAL(&mux);
+    stats.entries = header.count;
+    stats.compact = false;
+    stats.fileSize = csvSize;
+    stats.buildMs = header.buildMs;
+    stats.loadMs = millis() - start;
+    portEXIT_CRITICAL(&mux);
+    return true;
+  }
+
+  // Scan the CSV once, writing { id, line offset } per record. radioid exports are
+  // sorted by ID, so the index usually comes out sorted; otherwise it is sorted in
+  // (PSRAM) memory afterwards. Returns the build time in ms, 0 on failure.
+  uint32_t build(uint32_t csvSize, uint32_t csvTime) {
+    unsigned long start = millis();
+    File csv = SD.open(DMR_DB_CSV_PATH, FILE_READ);
+    File out = SD.open(DMR_DB_INDEX_TEMP_PATH, FILE_WRITE);
+    uint8_t* chunk = (uint8_t*)malloc(DMR_DB_BUILD_CHUNK);
+    if (!csv || !out || chunk == NULL) {
+      free(chunk);
+      return 0;
+    }
+
+    uint8_t zero[DMR_DB_BLOCK_SIZE] = {0};
+    bool ok = out.write(zero, sizeof(zero)) == sizeof(zero);
+
+    SDUserIndexEntry block[DMR_DB_ENTRIES_PER_BLOCK];
+    uint32_t blockFill = 0;
+    uint32_t entries = 0;
+    uint32_t lastId = 0;
+    bool sorted = true;
+
+    uint32_t pos = 0;          // CSV offset of chunk[0]
+    uint32_t lineStart = 0;
+    uint32_t id = 0;
+    uint8_t digits = 0;
+    bool inId = true;          // Still reading the leading ID of this line
+
+    while (ok) {
+      int n = csv.read(chunk, DMR_DB_BUILD_CHUNK);
+      if (n <= 0) break;
+      for (int i = 0; i < n; i++) {
+        uint8_t c = chunk[i];
+        if (c == '\n') {
+          lineStart = pos + i + 1;
+          id = 0;
+          digits = 0;
+          inId = true;
+          continue;
+        }
+        if (!inId) continue;
+        if (c >= '0' && c <= '9' && digits < 9) {
+          id = id * 10 + (c - '0');
+          digits++;
+          continue;
+        }
+        inId = false;
+        if (c != ',' || digits == 0 || id == 0) continue;  // Header or malformed line
+
+        if (id <= lastId) sorted = false;
+        lastId = id;
+        block[blockFill].dmrId = id;
+        block[blockFill].offset = lineStart;
+        entries++;
+        if (++blockFill == DMR_DB_ENTRIES_PER_BLOCK) {
+          ok = out.write((uint8_t*)block, sizeof(block)) == sizeof(block);
+          blockFill = 0;
+        }
+      }
+      pos += n;
+    }
+    free(chunk);
+    csv.close();
+    if (ok && blockFill > 0) {
+      ok = out.write((uint8_t*)block, blockFill * sizeof(SDUserIndexEntry)) == blockFill * sizeof(SDUserIndexEntry);
+    }
+    out.close();
+    if (!ok || entries == 0 || pos != csvSize) return 0;
+
+    if (!sorted && !sortIndex(entries)) return 0;
+
+    SDUserIndexHeader header;
+    header.magic = DMR_DB_INDEX_MAGIC;
+    header.version = DMR_DB_INDEX_VERSION;
+    header.entrySize = sizeof(SDUserIndexEntry);
+    header.count = entries;
+    header.csvSize = csvSize;
+    header.csvTime = csvTime;
+    header.buildMs = millis() - start;
+    if (header.buildMs == 0) header.buildMs = 1;
+
+    out = SD.open(DMR_DB_INDEX_TEMP_PATH, "r+");
+    if (!out) return 0;
+    ok = out.seek(0) && out.write((uint8_t*)&header, sizeof(header)) == sizeof(header);
+    out.close();
+    if (!ok) return 0;
+
+    SD.remove(DMR_DB_INDEX_PATH);
+    if (!SD.rename(DMR_DB_INDEX_TEMP_PATH, DMR_DB_INDEX_PATH)) return 0;
+    return header.buildMs;
+  }
+
+  // Sort the temp index in memory (needs count * 8 bytes, PSRAM preferred)
+  bool sortIndex(uint32_t entries) {
+    size_t bytes = entries * sizeof(SDUserIndexEntry);
+    SDUserIndexEntry* all = (SDUserIndexEntry*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (all == NULL) all = (SDUserIndexEntry*)heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+    if (all == NULL) return false;
+
+    File file = SD.open(DMR_DB_INDEX_TEMP_PATH, "r+");
+    bool ok = file && file.seek(DMR_DB_BLOCK_SIZE) && file.read((uint8_t*)all, bytes) == bytes;
+    if (ok) {
+      std::sort(all, all + entries, [](const SDUserIndexEntry &a, const SDUserIndexEntry &b) {
+        return a.dmrId < b.dmrId;
+      });
+      ok = file.seek(DMR_DB_BLOCK_SIZE) && file.write((uint8_t*)all, bytes) == bytes;
+    }
+    if (file) file.close();
+    heap_caps_free(all);
+    return ok;
+  }
+
+  // CSV offset of dmrId, or false. Call with lock held.
+  bool findOffset(uint32_t dmrId, uint32_t &offset, uint32_t &reads) {
+    // Last fence entry <= dmrId
+    uint32_t* f = std::upper_bound(fence, fence + fenceCount, dmrId);
+    if (f == fence) return false;
+    uint32_t lo = (uint32_t)(f - fence - 1) * DMR_DB_FENCE_STRIDE;
+    uint32_t hi = std::min(lo + DMR_DB_FENCE_STRIDE, blockCount);  // Exclusive
+
+    SDUserIndexEntry block[DMR_DB_ENTRIES_PER_BLOCK];
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      uint32_t first = mid * DMR_DB_ENTRIES_PER_BLOCK;
+      uint32_t n = std::min((uint32_t)DMR_DB_ENTRIES_PER_BLOCK, count - first);
+      size_t bytes = n * sizeof(SDUserIndexEntry);
+      reads++;
+      if (!indexFile.seek(DMR_DB_BLOCK_SIZE + first * sizeof(SDUserIndexEntry)) ||
+          indexFile.read((uint8_t*)block, bytes) != bytes) {
+        return false;
+      }
+      if (dmrId < block[0].dmrId) {
+        hi = mid;
+      } else if (dmrId > block[n - 1].dmrId) {
+        lo = mid + 1;
+      } else {
+        SDUserIndexEntry* e = std::lower_bound(block, block + n, dmrId, [](const SDUserIndexEntry &a, uint32_t id) {
+          return a.dmrId < id;
+        });
+        if (e == block + n || e->dmrId != dmrId) return false;
+        offset = e->offset;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Read the CSV line at offset into "callsign|name|city|country". Call with lock held.
+  bool readRecord(uint32_t offset, String &userInfo, uint32_t &reads) {
+    char line[DMR_DB_RECORD_MAX + 1];
+    reads++;
+    if (!csvFile.seek(offset)) return false;
+    int n = csvFile.read((uint8_t*)line, DMR_DB_RECORD_MAX);
+    if (n <= 0) return false;
+    line[n] = '\0';
+
+    char fields[4][48];
+    const uint8_t columns[4] = { DMR_DB_COL_CALLSIGN, DMR_DB_COL_NAME, DMR_DB_COL_CITY, DMR_DB_COL_COUNTRY };
+    memset(fields, 0, sizeof(fields));
+
+    uint8_t column = 0;
+    uint8_t length = 0;
+    bool quoted = false;
+    for (int i = 0; i < n; i++) {
+      char c = line[i];
+      if (c == '\n' || c == '\r') break;
+      if (c == '"') {
+        quoted = !quoted;
+        continue;
+      }
+      if (c == ',' && !quoted) {
+        column++;
+        length = 0;
+        continue;
+      }
+      for (uint8_t f = 0; f < 4; f++) {
+        if (columns[f] == column && length < sizeof(fields[f]) - 1) {
+          fields[f][length] = (c == '|') ? ' ' : c;  // '|' separates the fields of userInfo
+        }
+      }
+      length++;
+    }
+    if (fields[0][0] == '\0') return false;
+
+    userInfo = String(fields[0]) + "|" + fields[1] + "|" + fields[2] + "|" + fields[3];
+    return true;
+  }
+
+  // Compact database lookup: one block read plus one read per string. Call with lock held.
+  bool readCompact(uint32_t dmrId, String &userInfo, uint32_t &reads) {
+    uint32_t before = compact.getReads();
+    UDBRecord record;
+    bool found = compact.find(dmrId, record);
+    if (found) {
+      char name[UDB_STRING_MAX], city[UDB_STRING_MAX], country[UDB_STRING_MAX];
+      compact.readString(record.firstName, name, sizeof(name));
+      compact.readDict(UDB_DICT_CITY, record.dict[UDB_DICT_CITY], city, sizeof(city));
+      compact.readDict(UDB_DICT_COUNTRY, record.dict[UDB_DICT_COUNTRY], country, sizeof(country));
+      userInfo = String(record.callsign) + "|" + name + "|" + city + "|" + country;
+    }
+    reads += compact.getReads() - before;
+    return found;
+  }
+
+public:
+  SDUserDatabase()
+    : useCompact(false), fence(NULL), fenceCount(0), count(0), blockCount(0), state(DMR_DB_IDLE), latencyCount(0),
+      lock(NULL), task(NULL), mux(portMUX_INITIALIZER_UNLOCKED) {
+    memset(&stats, 0, sizeof(stats));
+  }
+
+  // Start the background task that loads (or builds) the index. SD must be mounted.
+  bool begin() {
+    if (task != NULL) return true;
+    lock = xSemaphoreCreateMutex();
+    if (lock == NULL) return false;
+    return xTaskCreatePinnedToCore(taskEntry, "user_db", DMR_DB_TASK_STACK, this, DMR_DB_TASK_PRIORITY, &task,
+                                   APP_TASK_CORE) == pdPASS;
+  }
+
+  // Drop the index and build it again (e.g. after replacing the CSV)
+  void rebuild() {
+    if (task != NULL) xTaskNotifyGive(task);
+  }
+
+  bool isReady() const {
+    return state == DMR_DB_READY;
+  }
+
+  // Blocking SD lookup (a few ms); returns "callsign|name|city|country" in userInfo.
+  // Safe from any task, but keep it off the voice path.
+  bool lookup(uint32_t dmrId, String &userInfo) {
+    if (state != DMR_DB_READY || dmrId == 0) return false;
+
+    int64_t start = esp_timer_get_time();
+    uint32_t reads = 0;
+    uint32_t offset = 0;
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool found = false;
+    if (state == DMR_DB_READY) {
+      found = useCompact ? readCompact(dmrId, userInfo, reads)
+                         : findOffset(dmrId, offset, reads) && readRecord(offset, userInfo, reads);
+    }
+    xSemaphoreGive(lock);
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+
+    portENTER_CRITICAL(&mux);
+    stats.lookups++;
+    if (found) stats.hits++;
+    stats.blockReads += reads;
+    stats.lastLookupUs = elapsed;
+    if (elapsed > stats.maxLookupUs) stats.maxLookupUs = elapsed;
+    latencies[latencyCount % DMR_DB_LATENCY_SAMPLES] = elapsed;
+    latencyCount++;
+    portEXIT_CRITICAL(&mux);
+    return found;
+  }
+
+  SDUserDatabaseStats getStats() {
+    uint32_t samples[DMR_DB_LATENCY_SAMPLES];
+    portENTER_CRITICAL(&mux);
+    SDUserDatabaseStats copy = stats;
+    uint32_t n = std::min(latencyCount, (uint32_t)DMR_DB_LATENCY_SAMPLES);
+    memcpy(samples, latencies, n * sizeof(uint32_t));
+    portEXIT_CRITICAL(&mux);
+
+    if (n > 0) {
+      uint32_t rank = (n * 99 + 99) / 100 - 1;  // Nearest-rank p99
+      std::nth_element(samples, samples + rank, samples + n);
+      copy.p99LookupUs = samples[rank];
+    }
+    return copy;
+  }
+
+  static const char* stateName(SDUserDatabaseState s) {
+    switch (s) {
+      case DMR_DB_NO_CSV: return "No database";
+      case DMR_DB_BUILDING: return "Building index";
+      case DMR_DB_READY: return "Ready";
+      case DMR_DB_FAILED: return "Index failed";
+      default: return "Idle";
+    }
+  }
+};
+
+#endif // SD_USER_DATABASE_H
@@ -0,0 +1,77 @@
+/*
+ * SpscQueue.h - Lock-free single-producer/single-consumer ring queue for ESP32 MMDVM Hotspot
+ *
+ * Fixed-capacity ring of preallocated items shared between exactly one producer
+ * task and one consumer task. No locks and no heap allocation:
+ * - Producer: acquire() a slot, fill it in place, then publish()
+ * - Consumer: front() to read in place, then pop()
+ * Capacity must be a power of two; head/tail are free-running counters.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+template <typename T, uint32_t CAPACITY>
+class SpscQueue {
+private:
+  static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+  T items[CAPACITY];
+  std::atomic<uint32_t> head;  // Next item to consume (written by consumer only)
+  std::atomic<uint32_t> tail;  // Next slot to fill (written by producer only)
+
+public:
+  SpscQueue() : head(0), tail(0) {}
+
+  // Producer: slot to fill in place, or NULL if the queue is full
+  T* acquire() {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) >= CAPACITY) return NULL;
+    return &items[t & (CAPACITY - 1)];
+  }
+
+  // Producer: make the slot returned by acquire() visible to the consumer
+  void publish() {
+    tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // Producer: copy an item in (false if full)
+  bool push(const T &item) {
+    T* slot = acquire();
+    if (slot == NULL) return false;
+    *slot = item;
+    publish();
+    return true;
+  }
+
+  // Consumer: oldest item, or NULL if empty. Valid until pop().
+  T* front() {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) return NULL;
+    return &items[h & (CAPACITY - 1)];
+  }
+
+  // Consumer: release the item returned by front()
+  void pop() {
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // Approximate from either side
+  uint32_t size() const {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+  }
+
+  bool isEmpty() const {
+    return size() == 0;
+  }
+
+  uint32_t capacity() const {
+    return CAPACITY;
+  }
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,117 @@
+/*
+ * TaskMonitor.h - FreeRTOS task load and stack reporting for ESP32 MMDVM Hotspot
+ *
+ * Keeps a small table of the sketch's tasks (the DMR core task, loop() and the
+ * background workers) for the status page:
+ * - stack high-water mark (least free stack seen, bytes) for every task
+ * - CPU load and worst pass time for tasks that report their work with
+ *   record(): busy time over the last TASK_MONITOR_WINDOW_US, in percent
+ * Tasks created elsewhere (async_udp, the lookup workers) are found by name
+ * the first time they are asked for.
+ */
+
+#ifndef TASK_MONITOR_H
+#define TASK_MONITOR_H
+
+#include <Arduino.h>
+#include "esp_timer.h"
+
+#define TASK_MONITOR_MAX 10
+#define TASK_MONITOR_WINDOW_US 1000000  // CPU load averaging window
+
+// One task as shown on the status page
+struct TaskMonitorStats {
+  const char* name;
+  bool running;           // Task handle known
+  bool measured;          // Reports its work with record()
+  int8_t core;            // Pinned core, -1 = either
+  uint8_t priority;
+  uint32_t stackFree;     // High-water mark: least free stack seen (bytes)
+  uint8_t cpuPercent;     // Busy share of the last window (measured tasks)
+  uint32_t maxPassUs;     // Longest recorded pass
+};
+
+class TaskMonitor {
+private:
+  struct Entry {
+    const char* name;
+    TaskHandle_t handle;
+    int8_t core;
+    bool measured;
+    int64_t windowStart;
+    uint64_t busyUs;
+    uint8_t cpuPercent;
+    uint32_t maxPassUs;
+  };
+
+  Entry tasks[TASK_MONITOR_MAX];
+  uint8_t count;
+  portMUX_TYPE mux;
+
+public:
+  TaskMonitor() : count(0), mux(portMUX_INITIALIZER_UNLOCKED) {
+    memset(tasks, 0, sizeof(tasks));
+  }
+
+  // Register a task; handle may be NULL to look it up by name later. Returns its id.
+  uint8_t add(const char* name, TaskHandle_t handle, int8_t core) {
+    if (count >= TASK_MONITOR_MAX) return TASK_MONITOR_MAX - 1;
+    Entry &e = tasks[count];
+    e.name = name;
+    e.handle = handle;
+    e.core = core;
+    e.windowStart = esp_timer_get_time();
+    return count++;
+  }
+
+  void setHandle(uint8_t id, TaskHandle_t handle) {
+    if (id < count) tasks[id].handle = handle;
+  }
+
+  // Called by the task itself after each unit of work (start = esp_timer_get_time() before it)
+  void record(uint8_t id, int64_t start) {
+    if (id >= count) return;
+    int64_t now = esp_timer_get_time();
+    uint32_t pass = (uint32_t)(now - start);
+    Entry &e = tasks[id];
+    portENTER_CRITICAL(&mux);
+    e.measured = true;
+    e.busyUs += pass;
+    if (pass > e.maxPassUs) e.maxPassUs = pass;
+    if (now - e.windowStart >= TASK_MONITOR_WINDOW_US) {
+      uint64_t percent = e.busyUs * 100 / (uint64_t)(now - e.windowStart);
+      e.cpuPercent = (uint8_t)(percent > 100 ? 100 : percent);
+      e.busyUs = 0;
+      e.windowStart = now;
+    }
+    portEXIT_CRITICAL(&mux);
+  }
+
+  uint8_t size() const {
+    return count;
+  }
+
+  TaskMonitorStats getStats(uint8_t id) {
+    TaskMonitorStats stats;
+    memset(&stats, 0, sizeof(stats));
+    if (id >= count) return stats;
+    Entry &e = tasks[id];
+    if (e.handle == NULL) e.handle = xTaskGetHandle(e.name);
+
+    portENTER_CRITICAL(&mux);
+    stats.name = e.name;
+    stats.measured = e.measured;
+    stats.cpuPercent = e.cpuPercent;
+    stats.maxPassUs = e.maxPassUs;
+    portEXIT_CRITICAL(&mux);
+    stats.core = e.core;
+    if (e.handle != NULL) {
+      stats.running = true;
+      stats.priority = (uint8_t)uxTaskPriorityGet(e.handle);
+      stats.stackFree = uxTaskGetStackHighWaterMark(e.handle);  // ESP-IDF: bytes
+    }
+    return stats;
+  }
+};
+
+#endif // TASK_MONITOR_H
@@ -0,0 +1,61 @@
+/*
+ * UDPDrainStats.h - Network receive drain statistics for ESP32 MMDVM Hotspot
+ *
+ * handleNetwork() dispatches every datagram waiting in the DMR socket's receive
+ * queue in one pass (bounded by UDP_DRAIN_MAX_PACKETS / UDP_DRAIN_BUDGET_US). The
+ * queue depth at the start of each pass goes into a histogram: mostly 1 on a healthy
+ * link, larger values mean packets waited for the core task (master bursts, a long
+ * modem write). The queue holds NETWORK_RX_QUEUE_DEPTH (16) datagrams, so the last
+ * bucket is a full queue, where further datagrams were dropped. Passes that stop at
+ * the budget with datagrams still queued leave them for the next pass.
+ */
+
+#ifndef UDP_DRAIN_STATS_H
+#define UDP_DRAIN_STATS_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifndef UDP_DRAIN_MAX_PACKETS
+#define UDP_DRAIN_MAX_PACKETS 16    // Datagrams handled per pass at most
+#endif
+#ifndef UDP_DRAIN_BUDGET_US
+#define UDP_DRAIN_BUDGET_US 4000    // Time per pass after which the rest waits for the next pass
+#endif
+
+#define UDP_DRAIN_BUCKETS 6         // Datagrams queued at pass start: 1, 2, 3-4, 5-8, 9-15, 16 (full)
+
+struct UDPDrainStats {
+  uint32_t passes;                        // Passes that found at least one datagram
+  uint32_t packets;                       // Datagrams read
+  uint32_t budgetHits;                    // Passes that hit the budget with datagrams still queued
+  uint16_t peakPending;                   // Most datagrams queued at the start of a pass
+  uint32_t lastPassUs;                    // Duration of the last pass (including packet handling)
+  uint32_t maxPassUs;
+  uint32_t histogram[UDP_DRAIN_BUCKETS];  // Passes by datagrams queued at their start
+};
+
+inline uint8_t udpDrainBucket(uint16_t pending) {
+  if (pending <= 2) return (pending == 0) ? 0 : pending - 1;
+  if (pending <= 4) return 2;
+  if (pending <= 8) return 3;
+  if (pending <= 15) return 4;
+  return 5;
+}
+
+inline const char* udpDrainBucketLabel(uint8_t bucket) {
+  static const char* const labels[UDP_DRAIN_BUCKETS] = { "1", "2", "3-4", "5-8", "9-15", "16 (full)" };
+  return (bucket < UDP_DRAIN_BUCKETS) ? labels[bucket] : "";
+}
+
+inline void udpDrainRecord(UDPDrainStats &stats, uint16_t pending, uint16_t packets, bool budgetHit, uint32_t passUs) {
+  stats.passes++;
+  stats.packets += packets;
+  if (budgetHit) stats.budgetHits++;
+  if (pending > stats.peakPending) stats.peakPending = pending;
+  stats.lastPassUs = passUs;
+  if (passUs > stats.maxPassUs) stats.maxPassUs = passUs;
+  stats.histogram[udpDrainBucket(pending)]++;
+}
+
+#endif // UDP_DRAIN_STATS_H
@@ -0,0 +1,350 @@
+/*
+ * UserCache.h - Hash-indexed DMR user info cache for ESP32 MMDVM Hotspot
+ *
+ * Replaces the two 500-entry String arrays (user info + legacy callsign) that
+ * were scanned linearly on every lookup.
+ * - Fixed-size POD records: packed callsign plus name/city/country offsets into
+ *   a string pool; identical strings (cities, countries) are stored once
+ * - Open-addressing index keyed by the 24-bit DMR ID (linear probing,
+ *   backward-shift deletion, so no tombstones)
+ * - CLOCK eviction: recently used entries get a second chance instead of the
+ *   old blind round-robin overwrite
+ * - The string pool is compacted when it fills up; entries are evicted only
+ *   if compaction can't make room
+ * - All storage is allocated once in begin(), optionally in PSRAM
+ *
+ * Owned by the dmr_core task (lookups, inserts), so there is no locking. Other
+ * tasks may only call getStats(), which copies the counters without writing.
+ */
+
+#ifndef USER_CACHE_H
+#define USER_CACHE_H
+
+#include <Arduino.h>
+#include "esp_heap_caps.h"
+
+#define USER_CACHE_CALLSIGN_LEN 8  // Stored without terminator when 8 characters long
+#define USER_CACHE_POOL_MAX 65535  // Pool offsets are 16 bit
+
+struct UserCacheRecord {
+  uint32_t dmrId;                          // 0 = free slot
+  char callsign[USER_CACHE_CALLSIGN_LEN];
+  uint16_t name;                           // String pool offsets (0 = empty string)
+  uint16_t city;
+  uint16_t country;
+  uint8_t referenced;                      // CLOCK bit, set on every hit
+  uint8_t reserved;
+};
+
+// Cache statistics (for the web interface)
+struct UserCacheStats {
+  uint16_t entries;
+  uint16_t capacity;
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+  uint32_t compactions;
+  uint32_t poolUsed;
+  uint32_t poolSize;
+  uint32_t bytes;  // Total memory allocated
+  bool psram;
+};
+
+class UserCache {
+private:
+  UserCacheRecord* records;
+  uint16_t* index;        // Record number + 1 per slot (0 = empty)
+  uint16_t* strings;      // Pool offset per slot (0 = empty), for interning
+  char* pool;
+  uint16_t capacity;
+  uint32_t indexMask;
+  uint32_t stringMask;
+  uint32_t poolSize;
+  uint32_t poolUsed;
+  uint32_t stringCount;
+  uint16_t count;
+  uint16_t clockHand;
+  bool inPsram;
+  UserCacheStats stats;
+
+  static uint32_t hashId(uint32_t dmrId) {
+    return (dmrId & 0xFFFFFF) * 2654435761u;
+  }
+
+  static uint32_t hashString(const char* s) {
+    uint32_t h = 2166136261u;  // FNV-1a
+    while (*s) {
+      h = (h ^ (uint8_t)*s++) * 16777619u;
+    }
+    return h;
+  }
+
+  static uint32_t nextPow2(uint32_t n) {
+    uint32_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+  }
+
+  void* allocate(size_t bytes) {
+    void* p = NULL;
+    if (inPsram) p = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (p == NULL) p = heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+    if (p != NULL) memset(p, 0, bytes);
+    return p;
+  }
+
+  // Index slot holding dmrId, or -1
+  int32_t findSlot(uint32_t dmrId) const {
+    uint32_t slot = hashId(dmrId) & indexMask;
+    while (index[slot] != 0) {
+      if (records[index[slot] - 1].dmrId == dmrId) return slot;
+      slot = (slot + 1) & indexMask;
+    }
+    return -1;
+  }
+
+  void indexInsert(uint32_t dmrId, uint16_t record) {
+    uint32_t slot = hashId(dmrId) & indexMask;
+    while (index[slot] != 0) slot = (slot + 1) & indexMask;
+    index[slot] = record + 1;
+  }
+
+  // Remove a slot and shift following entries back so probes stay unbroken
+  void indexRemove(uint32_t hole) {
+    uint32_t next = hole;
+    while (true) {
+      next = (next + 1) & indexMask;
+      if (index[next] == 0) break;
+      uint32_t home = hashId(records[index[next] - 1].dmrId) & indexMask;
+      // Entry can move into the hole only if its home is not in (hole, next]
+      bool between = (hole <= next) ? (hole < home && home <= next) : (hole < home || home <= next);
+      if (between) continue;
+      index[hole] = index[next];
+      hole = next;
+    }
+    index[hole] = 0;
+  }
+
+  // Pick a record to reuse: a free one, or the first unreferenced one the clock hand finds
+  uint16_t takeRecord() {
+    if (count < capacity) {
+      while (records[clockHand].dmrId != 0) clockHand = (clockHand + 1) % capacity;
+      uint16_t r = clockHand;
+      clockHand = (clockHand + 1) % capacity;
+      count++;
+      return r;
+    }
+    while (records[clockHand].referenced) {
+      records[clockHand].referenced = 0;
+      clockHand = (clockHand + 1) % capacity;
+    }
+    uint16_t r = clockHand;
+    clockHand = (clockHand + 1) % capacity;
+    evict(r);
+    count++;
+    return r;
+  }
+
+  void evict(uint16_t r) {
+    int32_t slot = findSlot(records[r].dmrId);
+    if (slot >= 0) indexRemove(slot);
+    memset(&records[r], 0, sizeof(UserCacheRecord));
+    count--;
+    stats.evictions++;
+  }
+
+  // Offset of s in the pool, adding it if new. 0 for "" or when the pool is full.
+  uint16_t intern(const char* s, bool &full) {
+    if (s[0] == '\0') return 0;
+    uint32_t slot = hashString(s) & stringMask;
+    while (strings[slot] != 0) {
+      if (strcmp(&pool[strings[slot]], s) == 0) return strings[slot];
+      slot = (slot + 1) & stringMask;
+    }
+    size_t length = strlen(s) + 1;
+    if (poolUsed + length > poolSize || (stringCount + 1) * 4 > (stringMask + 1) * 3) {
+      full = true;
+      return 0;
+    }
+    uint16_t offset = poolUsed;
+    memcpy(&pool[offset], s, length);
+    poolUsed += length;
+    strings[slot] = offset;
+    stringCount++;
+    return offset;
+  }
+
+  // Rebuild the pool with only the strings live records still use
+  bool compact() {
+    char* oldPool = pool;
+    char* newPool = (char*)allocate(poolSize);
+    if (newPool == NULL) return false;
+
+    pool = newPool;
+    poolUsed = 1;  // Offset 0 is the empty string
+    stringCount = 0;
+    memset(strings, 0, (stringMask + 1) * sizeof(uint16_t));
+    bool full = false;
+    for (uint16_t r = 0; r < capacity; r++) {
+      if (records[r].dmrId == 0) continue;
+      records[r].name = intern(&oldPool[records[r].name], full);
+      records[r].city = intern(&oldPool[records[r].city], full);
+      records[r].country = intern(&oldPool[records[r].country], full);
+    }
+    heap_caps_free(oldPool);
+    stats.compactions++;
+    return true;
+  }
+
+  void fill(uint16_t r, const char* name, const char* city, const char* country, bool &full) {
+    full = false;
+    records[r].name = intern(name, full);
+    records[r].city = intern(city, full);
+    records[r].country = intern(country, full);
+  }
+
+public:
+  UserCache()
+    : records(NULL), index(NULL), strings(NULL), pool(NULL), capacity(0), indexMask(0), stringMask(0),
+      poolSize(0), poolUsed(0), stringCount(0), count(0), clockHand(0), inPsram(false) {
+    memset(&stats, 0, sizeof(stats));
+  }
+
+  // Allocate storage for up to entries users; usePsram places it in PSRAM when present
+  bool begin(uint16_t entries, uint32_t stringPoolSize, bool usePsram) {
+    if (records != NULL || entries == 0) return records != NULL;
+    capacity = entries;
+    poolSize = (stringPoolSize > USER_CACHE_POOL_MAX) ? USER_CACHE_POOL_MAX : stringPoolSize;
+    inPsram = usePsram && psramFound();
+
+    uint32_t indexSlots = nextPow2((uint32_t)entries * 2);
+    uint32_t stringSlots = nextPow2((uint32_t)entries * 4);
+    indexMask = indexSlots - 1;
+    stringMask = stringSlots - 1;
+
+    records = (UserCacheRecord*)allocate(sizeof(UserCacheRecord) * entries);
+    index = (uint16_t*)allocate(sizeof(uint16_t) * indexSlots);
+    strings = (uint16_t*)allocate(sizeof(uint16_t) * stringSlots);
+    pool = (char*)allocate(poolSize);
+    if (records == NULL || index == NULL || strings == NULL || pool == NULL) {
+      heap_caps_free(records);
+      heap_caps_free(index);
+      heap_caps_free(strings);
+      heap_caps_free(pool);
+      records = NULL;
+      index = NULL;
+      strings = NULL;
+      pool = NULL;
+      capacity = 0;
+      return false;
+    }
+    poolUsed = 1;  // pool[0] = '\0' is the shared empty string
+
+    stats.bytes = sizeof(UserCacheRecord) * entries + sizeof(uint16_t) * (indexSlots + stringSlots) + poolSize;
+    stats.psram = inPsram;
+    return true;
+  }
+
+  // Fetch a user; any output pointer may be NULL. callsign needs USER_CACHE_CALLSIGN_LEN + 1 bytes.
+  // The name/city/country pointers stay valid until the next put().
+  bool find(uint32_t dmrId, char* callsign, const char** name, const char** city, const char** country) {
+    int32_t slot = (records != NULL && dmrId != 0) ? findSlot(dmrId) : -1;
+    if (slot < 0) {
+      stats.misses++;
+      return false;
+    }
+    UserCacheRecord &rec = records[index[slot] - 1];
+    rec.referenced = 1;
+    stats.hits++;
+    if (callsign != NULL) {
+      memcpy(callsign, rec.callsign, USER_CACHE_CALLSIGN_LEN);
+      callsign[USER_CACHE_CALLSIGN_LEN] = '\0';
+    }
+    if (name != NULL) *name = &pool[rec.name];
+    if (city != NULL) *city = &pool[rec.city];
+    if (country != NULL) *country = &pool[rec.country];
+    return true;
+  }
+
+  // Add or update a user
+  bool put(uint32_t dmrId, const char* callsign, const char* name, const char* city, const char* country) {
+    if (records == NULL || dmrId == 0 || callsign[0] == '\0') return false;
+
+    int32_t slot = findSlot(dmrId);
+    uint16_t r;
+    if (slot >= 0) {
+      r = index[slot] - 1;
+    } else {
+      r = takeRecord();
+      records[r].dmrId = dmrId;
+      indexInsert(dmrId, r);
+    }
+    memset(records[r].callsign, 0, USER_CACHE_CALLSIGN_LEN);
+    memcpy(records[r].callsign, callsign, strnlen(callsign, USER_CACHE_CALLSIGN_LEN));  // No NUL when 8 long
+    records[r].referenced = 1;
+
+    bool full;
+    fill(r, name, city, country, full);
+    if (full) {
+      // Reclaim strings of evicted/updated entries, then evict until it fits
+      records[r].name = records[r].city = records[r].country = 0;
+      if (!compact()) return true;  // Keep the callsign at least
+      fill(r, name, city, country, full);
+      while (full && count > 1) {
+        records[r].referenced = 1;
+        uint16_t victim = clockHand;
+        while (victim == r || records[victim].dmrId == 0 || records[victim].referenced) {
+          if (victim != r) records[victim].referenced = 0;
+          victim = (victim + 1) % capacity;
+        }
+        clockHand = (victim + 1) % capacity;
+        evict(victim);
+        records[r].name = records[r].city = records[r].country = 0;
+        if (!compact()) break;
+        fill(r, name, city, country, full);
+      }
+    }
+    return true;
+  }
+
+  // "callsign|name|city|country" (or just "callsign"), the format the rest of the sketch uses
+  String get(uint32_t dmrId) {
+    char callsign[USER_CACHE_CALLSIGN_LEN + 1];
+    const char* name;
+    const char* city;
+    const char* country;
+    if (!find(dmrId, callsign, &name, &city, &country)) return "";
+    String info = callsign;
+    if (name[0] != '\0' || city[0] != '\0' || country[0] != '\0') {
+      info += "|" + String(name) + "|" + String(city) + "|" + String(country);
+    }
+    return info;
+  }
+
+  // Store a "callsign|name|city|country" (or plain callsign) string
+  bool put(uint32_t dmrId, const String &userInfo) {
+    String fields[4];
+    int start = 0;
+    for (int f = 0; f < 4; f++) {
+      int pipe = (f < 3) ? userInfo.indexOf('|', start) : -1;
+      if (pipe < 0) {
+        fields[f] = userInfo.substring(start);
+        break;
+      }
+      fields[f] = userInfo.substring(start, pipe);
+      start = pipe + 1;
+    }
+    return put(dmrId, fields[0].c_str(), fields[1].c_str(), fields[2].c_str(), fields[3].c_str());
+  }
+
+  UserCacheStats getStats() const {
+    UserCacheStats copy = stats;
+    copy.entries = count;
+    copy.capacity = capacity;
+    copy.poolUsed = poolUsed;
+    copy.poolSize = poolSize;
+    return copy;
+  }
+};
+
+#endif // USER_CACHE_H
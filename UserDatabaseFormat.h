@@ -0,0 +1,283 @@
+/*
+ * UserDatabaseFormat.h - Compact DMR user database format for ESP32 MMDVM Hotspot
+ *
+ * database.csv repeats the same city / state / country names hundreds of thousands
+ * of times. database-converter (host tool, see make-database.sh) turns it into a
+ * compact binary file that is read here:
+ *
+ *   header      64 bytes (UDBHeader, CRC32 over the first 60)
+ *   block index blockCount x UDBBlockInfo { first ID, offset, size, count, CRC32 }
+ *   blocks      up to UDB_RECORDS_PER_BLOCK records each, sorted by ID:
+ *                 varint  ID delta from the previous record (first: 0 = firstId)
+ *                 uint8   callsign length, callsign bytes
+ *                 varint  first name, last name  (string pool offsets, 0 = empty)
+ *                 varint  city, state, country   (dictionary indexes, 0 = empty)
+ *   dictionaries city / state / country: count x uint32 string pool offset
+ *   string pool  NUL-terminated, deduplicated strings; offset 0 is ""
+ *
+ * All integers are little-endian. The block index and dictionaries are small
+ * enough to keep in RAM, so a lookup is one block read plus one read per string.
+ * No Arduino dependencies, so the converter builds the same code on a host.
+ */
+
+#ifndef USER_DATABASE_FORMAT_H
+#define USER_DATABASE_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define UDB_MAGIC 0x42445544  // "DUDB"
+#define UDB_VERSION 1
+#define UDB_RECORDS_PER_BLOCK 128
+#define UDB_CALLSIGN_MAX 15
+#define UDB_STRING_MAX 64      // Longest string read back from the pool (incl. NUL)
+#define UDB_BLOCK_SIZE_MAX 16384
+
+enum {
+  UDB_DICT_CITY,
+  UDB_DICT_STATE,
+  UDB_DICT_COUNTRY,
+  UDB_DICT_COUNT
+};
+
+struct UDBHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t recordsPerBlock;
+  uint32_t recordCount;
+  uint32_t blockCount;
+  uint32_t indexOffset;
+  uint32_t dataOffset;
+  uint32_t dictOffset[UDB_DICT_COUNT];
+  uint32_t dictCount[UDB_DICT_COUNT];
+  uint32_t poolOffset;
+  uint32_t poolSize;
+  uint32_t maxBlockSize;
+  uint32_t headerCrc;  // CRC32 of the bytes before it
+};
+
+struct UDBBlockInfo {
+  uint32_t firstId;
+  uint32_t offset;  // From the start of the file
+  uint16_t size;
+  uint16_t count;
+  uint32_t crc;     // CRC32 of the block bytes
+};
+
+// One decoded record (strings still as pool offsets / dictionary indexes)
+struct UDBRecord {
+  uint32_t dmrId;
+  char callsign[UDB_CALLSIGN_MAX + 1];
+  uint32_t firstName;
+  uint32_t lastName;
+  uint32_t dict[UDB_DICT_COUNT];
+};
+
+static_assert(sizeof(UDBHeader) == 64, "UDBHeader must be 64 bytes");
+static_assert(sizeof(UDBBlockInfo) == 16, "UDBBlockInfo must be 16 bytes");
+
+// CRC-32 (IEEE 802.3), nibble table
+inline uint32_t udbCrc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+  static const uint32_t table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+  };
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc = (crc >> 4) ^ table[(crc ^ data[i]) & 0x0F];
+    crc = (crc >> 4) ^ table[(crc ^ (data[i] >> 4)) & 0x0F];
+  }
+  return ~crc;
+}
+
+// LEB128 varint; returns bytes written (max 5)
+inline size_t udbPutVarint(uint8_t* out, uint32_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+// Returns false on a truncated or over-long varint
+inline bool udbGetVarint(const uint8_t* &p, const uint8_t* end, uint32_t &value) {
+  value = 0;
+  for (uint8_t shift = 0; shift < 35 && p < end; shift += 7) {
+    uint8_t b = *p++;
+    value |= (uint32_t)(b & 0x7F) << shift;
+    if ((b & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+// Find dmrId in a block. Records are decoded in order until the ID is reached or passed.
+inline bool udbFindInBlock(const uint8_t* block, size_t size, uint16_t count, uint32_t firstId,
+                           uint32_t dmrId, UDBRecord &record) {
+  const uint8_t* p = block;
+  const uint8_t* end = block + size;
+  uint32_t id = firstId;
+  for (uint16_t i = 0; i < count; i++) {
+    uint32_t delta;
+    if (!udbGetVarint(p, end, delta)) return false;
+    id += delta;
+    if (p >= end) return false;
+    uint8_t csLength = *p++;
+    if (csLength > UDB_CALLSIGN_MAX || p + csLength > end) return false;
+    const uint8_t* callsign = p;
+    p += csLength;
+
+    uint32_t fields[2 + UDB_DICT_COUNT];
+    for (uint8_t f = 0; f < 2 + UDB_DICT_COUNT; f++) {
+      if (!udbGetVarint(p, end, fields[f])) return false;
+    }
+    if (id < dmrId) continue;
+    if (id > dmrId) return false;
+
+    record.dmrId = id;
+    memcpy(record.callsign, callsign, csLength);
+    record.callsign[csLength] = '\0';
+    record.firstName = fields[0];
+    record.lastName = fields[1];
+    for (uint8_t d = 0; d < UDB_DICT_COUNT; d++) record.dict[d] = fields[2 + d];
+    return true;
+  }
+  return false;
+}
+
+/*
+ * Reader over any random-access source:
+ *   bool Source::readAt(uint32_t offset, uint8_t* buffer, size_t length)
+ * Loads the header, block index and dictionaries into memory from alloc()
+ * (e.g. PSRAM on the device); one reader per thread.
+ */
+template<typename Source>
+class UserDatabaseReader {
+private:
+  Source* source;
+  UDBHeader header;
+  UDBBlockInfo* blocks;
+  uint32_t* dicts[UDB_DICT_COUNT];
+  uint8_t* blockBuffer;
+  void (*release)(void*);
+  uint32_t reads;
+  uint32_t crcErrors;
+
+  bool readAt(uint32_t offset, void* buffer, size_t length) {
+    reads++;
+    return source->readAt(offset, (uint8_t*)buffer, length);
+  }
+
+public:
+  UserDatabaseReader()
+    : source(NULL), blocks(NULL), blockBuffer(NULL), release(free), reads(0), crcErrors(0) {
+    memset(&header, 0, sizeof(header));
+    for (uint8_t d = 0; d < UDB_DICT_COUNT; d++) dicts[d] = NULL;
+  }
+
+  ~UserDatabaseReader() {
+    close();
+  }
+
+  bool open(Source* src, uint32_t fileSize, void* (*alloc)(size_t) = malloc, void (*dealloc)(void*) = free) {
+    close();
+    source = src;
+    release = dealloc;
+
+    if (!readAt(0, &header, sizeof(header)) || header.magic != UDB_MAGIC || header.version != UDB_VERSION ||
+        header.headerCrc != udbCrc32((const uint8_t*)&header, offsetof(UDBHeader, headerCrc)) ||
+        header.blockCount == 0 || header.maxBlockSize == 0 || header.maxBlockSize > UDB_BLOCK_SIZE_MAX ||
+        header.poolOffset + header.poolSize > fileSize) {
+      return false;
+    }
+
+    size_t indexBytes = header.blockCount * sizeof(UDBBlockInfo);
+    blocks = (UDBBlockInfo*)alloc(indexBytes);
+    blockBuffer = (uint8_t*)alloc(header.maxBlockSize);
+    if (blocks == NULL || blockBuffer == NULL || !readAt(header.indexOffset, blocks, indexBytes)) {
+      close();
+      return false;
+    }
+    for (uint8_t d = 0; d < UDB_DICT_COUNT; d++) {
+      size_t dictBytes = (header.dictCount[d] > 0 ? header.dictCount[d] : 1) * sizeof(uint32_t);
+      dicts[d] = (uint32_t*)alloc(dictBytes);
+      if (dicts[d] == NULL ||
+          (header.dictCount[d] > 0 && !readAt(header.dictOffset[d], dicts[d], header.dictCount[d] * sizeof(uint32_t)))) {
+        close();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void close() {
+    if (blocks != NULL) release(blocks);
+    if (blockBuffer != NULL) release(blockBuffer);
+    for (uint8_t d = 0; d < UDB_DICT_COUNT; d++) {
+      if (dicts[d] != NULL) release(dicts[d]);
+      dicts[d] = NULL;
+    }
+    blocks = NULL;
+    blockBuffer = NULL;
+    source = NULL;
+  }
+
+  bool isOpen() const {
+    return blocks != NULL;
+  }
+
+  // Binary search of the in-RAM block index, then one block read (CRC checked)
+  bool find(uint32_t dmrId, UDBRecord &record) {
+    if (blocks == NULL || dmrId < blocks[0].firstId) return false;
+    uint32_t lo = 0;
+    uint32_t hi = header.blockCount;
+    while (hi - lo > 1) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (blocks[mid].firstId <= dmrId) {
+        lo = mid;
+      } else {
+        hi = mid;
+      }
+    }
+    const UDBBlockInfo &info = blocks[lo];
+    if (info.size > header.maxBlockSize || !readAt(info.offset, blockBuffer, info.size)) return false;
+    if (udbCrc32(blockBuffer, info.size) != info.crc) {
+      crcErrors++;
+      return false;
+    }
+    return udbFindInBlock(blockBuffer, info.size, info.count, info.firstId, dmrId, record);
+  }
+
+  // Copy a pool string ("" for offset 0 or on error)
+  bool readString(uint32_t offset, char* out, size_t outSize) {
+    out[0] = '\0';
+    if (offset == 0) return true;
+    if (offset >= header.poolSize || outSize == 0) return false;
+    size_t length = header.poolSize - offset;
+    if (length > outSize - 1) length = outSize - 1;
+    if (!readAt(header.poolOffset + offset, out, length)) {
+      out[0] = '\0';
+      return false;
+    }
+    out[length] = '\0';  // Pool strings are NUL-terminated; this only bounds over-long ones
+    return true;
+  }
+
+  // Dictionary entry (city / state / country) as a string
+  bool readDict(uint8_t dict, uint32_t index, char* out, size_t outSize) {
+    if (index == 0 || dict >= UDB_DICT_COUNT || index >= header.dictCount[dict]) {
+      out[0] = '\0';
+      return index == 0;
+    }
+    return readString(dicts[dict][index], out, outSize);
+  }
+
+  const UDBHeader &getHeader() const { return header; }
+  uint32_t getReads() const { return reads; }
+  uint32_t getCrcErrors() const { return crcErrors; }
+};
+
+#endif // USER_DATABASE_FORMAT_H
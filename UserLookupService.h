@@ -0,0 +1,220 @@
+/*
+ * UserLookupService.h - Background DMR user info lookups for ESP32 MMDVM Hotspot
+ *
+ * A cache miss used to do a blocking HTTPS GET to radioid.net (up to
+ * DMR_API_TIMEOUT) inside handleNetwork(), stalling modem forwarding.
+ * - request() only queues the DMR ID and returns immediately
+ * - A worker task runs the lookup and posts the result; the dmr_core task collects
+ *   it with poll() and fills in the activity / history entries
+ * - IDs already queued, in flight or waiting to be collected are not queued twice
+ * - Bounded request queue: when full the oldest request is dropped
+ * - A request still queued can be cancelled (e.g. the talker alias named the station)
+ */
+
+#ifndef USER_LOOKUP_SERVICE_H
+#define USER_LOOKUP_SERVICE_H
+
+#include <Arduino.h>
+
+#ifndef DMR_LOOKUP_QUEUE_DEPTH
+#define DMR_LOOKUP_QUEUE_DEPTH 8  // Pending lookups (and uncollected results)
+#endif
+
+#define USER_LOOKUP_INFO_MAX 128     // "callsign|name|city|country"
+#define USER_LOOKUP_TASK_STACK 8192  // HTTPS (mbedTLS) needs a large stack
+#define USER_LOOKUP_TASK_PRIORITY 1
+
+#ifndef APP_TASK_CORE
+#define APP_TASK_CORE 1  // Same core as loop(), away from the DMR core task
+#endif
+
+// Lookup backend, runs in the worker task. Returns "" when the ID is unknown.
+typedef String (*UserLookupFetch)(uint32_t dmrId, int &httpCode);
+
+struct UserLookupResult {
+  uint32_t dmrId;
+  int httpCode;                     // HTTP status, negative HTTPClient error, or 0 if not attempted
+  char info[USER_LOOKUP_INFO_MAX];  // Empty if the ID was not found
+};
+
+// Service statistics (copied out for the web interface)
+struct UserLookupStats {
+  uint32_t requested;     // Requests accepted into the queue
+  uint32_t deduplicated;  // Requests for an ID already pending
+  uint32_t dropped;       // Oldest requests dropped because the queue was full
+  uint32_t cancelled;     // Requests withdrawn before the worker started them
+  uint32_t completed;     // Lookups that returned user info
+  uint32_t failed;        // Lookups that returned nothing
+  uint32_t lastLookupMs;  // Duration of the last lookup
+  uint32_t maxLookupMs;   // Slowest lookup
+  uint8_t queueDepth;     // Requests waiting
+  uint8_t peakQueueDepth;
+};
+
+class UserLookupService {
+private:
+  uint32_t requests[DMR_LOOKUP_QUEUE_DEPTH];
+  uint8_t requestHead;
+  uint8_t requestCount;
+  uint32_t inFlight;  // ID the worker is looking up (0 = idle)
+
+  UserLookupResult results[DMR_LOOKUP_QUEUE_DEPTH];
+  uint8_t resultHead;
+  uint8_t resultCount;
+
+  UserLookupFetch fetch;
+  TaskHandle_t task;
+  portMUX_TYPE mux;
+  UserLookupStats stats;
+
+  static void taskEntry(void* arg) {
+    static_cast<UserLookupService*>(arg)->run();
+  }
+
+  // Already queued, being looked up or waiting for poll() (call with mux held)
+  bool isPending(uint32_t dmrId) const {
+    if (inFlight == dmrId) return true;
+    for (uint8_t i = 0; i < requestCount; i++) {
+      if (requests[(requestHead + i) % DMR_LOOKUP_QUEUE_DEPTH] == dmrId) return true;
+    }
+    for (uint8_t i = 0; i < resultCount; i++) {
+      if (results[(resultHead + i) % DMR_LOOKUP_QUEUE_DEPTH].dmrId == dmrId) return true;
+    }
+    return false;
+  }
+
+  void run() {
+    while (true) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+      while (true) {
+        portENTER_CRITICAL(&mux);
+        uint32_t dmrId = 0;
+        if (requestCount > 0) {
+          dmrId = requests[requestHead];
+          requestHead = (requestHead + 1) % DMR_LOOKUP_QUEUE_DEPTH;
+          requestCount--;
+          stats.queueDepth = requestCount;
+        }
+        inFlight = dmrId;
+        portEXIT_CRITICAL(&mux);
+
+        if (dmrId == 0) break;
+
+        // Blocking lookup happens here, off the voice path
+        UserLookupResult result;
+        result.dmrId = dmrId;
+        result.httpCode = 0;
+        unsigned long start = millis();
+        String info = fetch(dmrId, result.httpCode);
+        uint32_t elapsed = millis() - start;
+        strncpy(result.info, info.c_str(), USER_LOOKUP_INFO_MAX - 1);
+        result.info[USER_LOOKUP_INFO_MAX - 1] = '\0';
+
+        portENTER_CRITICAL(&mux);
+        if (resultCount == DMR_LOOKUP_QUEUE_DEPTH) {
+          resultHead = (resultHead + 1) % DMR_LOOKUP_QUEUE_DEPTH;
+          resultCount--;
+        }
+        results[(resultHead + resultCount) % DMR_LOOKUP_QUEUE_DEPTH] = result;
+        resultCount++;
+        inFlight = 0;
+        if (result.info[0] != '\0') {
+          stats.completed++;
+        } else {
+          stats.failed++;
+        }
+        stats.lastLookupMs = elapsed;
+        if (elapsed > stats.maxLookupMs) stats.maxLookupMs = elapsed;
+        portEXIT_CRITICAL(&mux);
+      }
+    }
+  }
+
+public:
+  UserLookupService()
+    : requestHead(0), requestCount(0), inFlight(0), resultHead(0), resultCount(0),
+      fetch(NULL), task(NULL), mux(portMUX_INITIALIZER_UNLOCKED) {
+    memset(&stats, 0, sizeof(stats));
+  }
+
+  // Start the worker task with the given lookup backend
+  bool begin(UserLookupFetch lookup) {
+    fetch = lookup;
+    if (task != NULL) return true;
+    return xTaskCreatePinnedToCore(taskEntry, "user_lookup", USER_LOOKUP_TASK_STACK, this,
+                                   USER_LOOKUP_TASK_PRIORITY, &task, APP_TASK_CORE) == pdPASS;
+  }
+
+  // Queue a lookup. Never blocks; returns false only for an invalid ID or if not started.
+  bool request(uint32_t dmrId) {
+    if (dmrId == 0 || task == NULL) return false;
+
+    portENTER_CRITICAL(&mux);
+    if (isPending(dmrId)) {
+      stats.deduplicated++;
+      portEXIT_CRITICAL(&mux);
+      return true;
+    }
+    if (requestCount == DMR_LOOKUP_QUEUE_DEPTH) {
+      requestHead = (requestHead + 1) % DMR_LOOKUP_QUEUE_DEPTH;
+      requestCount--;
+      stats.dropped++;
+    }
+    requests[(requestHead + requestCount) % DMR_LOOKUP_QUEUE_DEPTH] = dmrId;
+    requestCount++;
+    stats.requested++;
+    stats.queueDepth = requestCount;
+    if (requestCount > stats.peakQueueDepth) stats.peakQueueDepth = requestCount;
+    portEXIT_CRITICAL(&mux);
+
+    xTaskNotifyGive(task);
+    return true;
+  }
+
+  // Withdraw a queued request. Returns false if it isn't queued (unknown, or the
+  // worker has already started it; its result then arrives as usual).
+  bool cancel(uint32_t dmrId) {
+    portENTER_CRITICAL(&mux);
+    bool found = false;
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < requestCount; i++) {
+      uint32_t id = requests[(requestHead + i) % DMR_LOOKUP_QUEUE_DEPTH];
+      if (id == dmrId) {
+        found = true;
+        continue;
+      }
+      requests[(requestHead + kept) % DMR_LOOKUP_QUEUE_DEPTH] = id;
+      kept++;
+    }
+    if (found) {
+      requestCount = kept;
+      stats.cancelled++;
+      stats.queueDepth = requestCount;
+    }
+    portEXIT_CRITICAL(&mux);
+    return found;
+  }
+
+  // Collect the next finished lookup (call from the dmr_core task)
+  bool poll(UserLookupResult &result) {
+    portENTER_CRITICAL(&mux);
+    bool have = resultCount > 0;
+    if (have) {
+      result = results[resultHead];
+      resultHead = (resultHead + 1) % DMR_LOOKUP_QUEUE_DEPTH;
+      resultCount--;
+    }
+    portEXIT_CRITICAL(&mux);
+    return have;
+  }
+
+  UserLookupStats getStats() {
+    portENTER_CRITICAL(&mux);
+    UserLookupStats copy = stats;
+    portEXIT_CRITICAL(&mux);
+    return copy;
+  }
+};
+
+#endif // USER_LOOKUP_SERVICE_H
@@ -39,6 +39,8 @@
 
 #define DMR_PORT 62031    // BrandMeister default port
 #define LOCAL_PORT 62032  // Local UDP port for hotspot
+#define DMR_DNS_TTL 300000            // Re-resolve the DMR server name every 5 minutes (ms)
+#define DMR_DNS_RETRY_INTERVAL 5000   // Retry a failed DMR server lookup after 5 seconds (ms)
 
 // Your DMR credentials
 #define DMR_CALLSIGN "N0CALL"    // Your callsign
@@ -116,6 +118,7 @@
 #define MMDVM_RX_INVERT false   // RX signal inversion
 #define MMDVM_TX_INVERT false   // TX signal inversion
 #define MMDVM_PTT_INVERT false  // PTT signal inversion
+#define MMDVM_DUPLEX false      // Duplex MMDVM board (separate RX/TX): carry TS1 and TS2 at the same time
 #define MMDVM_TX_DELAY 20       // TX delay in milliseconds (10-50)
 #define MMDVM_RX_LEVEL 128      // RX level (0-255, 128 = 50%)
 #define MMDVM_TX_LEVEL 128      // TX level (0-255, 128 = 50%)
@@ -137,10 +140,11 @@
 
 // ===== Network Settings =====
 #define NETWORK_KEEPALIVE_INTERVAL 5000  // Keepalive interval in milliseconds
-#define NETWORK_TIMEOUT 30000            // Network timeout in milliseconds
-#define NETWORK_RECONNECT_DELAY 5000     // Delay before reconnecting
+#define NETWORK_TIMEOUT 30000            // Session dropped after this long without an MSTPONG
+#define NETWORK_PING_MISS_LIMIT 3        // ... or after this many unanswered keepalives in a row
+#define NETWORK_RECONNECT_DELAY 5000     // First reconnect backoff step (doubles per failed login)
+#define DMR_RECONNECT_BACKOFF_MAX 600000 // Longest backoff step, also used after a refused password (10 minutes)
 #define DMR_LOGIN_TIMEOUT 10000          // DMR login timeout in milliseconds (10 seconds)
-#define DMR_LOGIN_MAX_RETRIES 3          // Maximum number of login retry attempts
 
 // ===== NTP Time Settings =====
 #define NTP_SERVER1 "pool.ntp.org"    // Primary NTP server
@@ -160,19 +164,21 @@
 // #define DMR_API_URL "https://database.radioid.net/api/dmr/user/?id="  // Alternative RadioID mirror
 // #define DMR_API_URL "https://ham-digital.org/api/dmr/user/?id="       // Ham-Digital.org API
 #define DMR_API_TIMEOUT 3000              // API request timeout in milliseconds
+#define DMR_LOOKUP_QUEUE_DEPTH 8          // Pending background user lookups (oldest dropped when full)
 
 // ===== DMR Activity & History Settings =====
 #define DMR_HISTORY_SIZE 15               // Number of recent transmissions to display (shown on home page)
 #define DMR_ACTIVITY_TIMEOUT 3000         // Timeout for active transmission display in milliseconds
 #define QRZ_LOOKUP_URL "https://www.qrz.com/db/"  // QRZ.com callsign lookup URL
 
-#if defined(LILYGO_T_ETH_ELITE_ESP32S3_MMDVM) // More memory available
-#define DMR_USER_CACHE_SIZE 500            // Number of DMR user info lookups to cache
-#define DMR_CALLSIGN_CACHE_SIZE 500        // Number of callsign lookups to cache
+#if defined(LILYGO_T_ETH_ELITE_ESP32S3_MMDVM) // More memory available (8 MB PSRAM)
+#define DMR_USER_CACHE_SIZE 2500           // Number of DMR user info lookups to cache
+#define DMR_USER_CACHE_PSRAM true          // Place the cache in PSRAM when present
 #else
 #define DMR_USER_CACHE_SIZE 500            // Number of DMR user info lookups to cache
-#define DMR_CALLSIGN_CACHE_SIZE 500        // Number of callsign lookups to cache
+#define DMR_USER_CACHE_PSRAM false         // Keep the cache in internal RAM
 #endif
+#define DMR_USER_CACHE_POOL_SIZE (DMR_USER_CACHE_SIZE * 24)  // Bytes for names/cities/countries (max 65535)
 
 // ===== Debug Settings =====
 #define DEBUG_SERIAL true     // Enable serial debug output
@@ -217,10 +223,45 @@
 // ===== Advanced Settings =====
 // Buffer sizes
 #define SERIAL_RX_BUFFER_SIZE 512  // MMDVM serial RX buffer size
+#define SERIAL_TX_BUFFER_SIZE 1280 // MMDVM serial TX ring buffer, so playout writes never wait for the UART (>= 2 x MODEM_TX_QUEUE_DEPTH x 40)
 #define UDP_BUFFER_SIZE 512        // UDP buffer size
+#define UDP_DRAIN_MAX_PACKETS 16   // Network datagrams handled per core task pass at most
+#define UDP_DRAIN_BUDGET_US 4000   // ... or until this much time is spent; the rest waits for the next pass
+#define MODEM_TX_QUEUE_DEPTH 16    // DMR frames queued per slot for paced modem playout (16 x 60ms = ~1s)
+#define JITTER_MIN_DEPTH 2         // Network frames held per slot before playout (reorder window on a clean link)
+#define JITTER_MAX_DEPTH 6         // Upper bound for the adaptive jitter buffer depth (6 x 60ms)
+#define DMR_LATE_ENTRY_HEADERS 2   // Voice LC headers played before a network stream that arrives without one (1-8)
+#define MMDVM_RX_QUEUE_DEPTH 16    // Received modem frames waiting for the main loop (power of two)
+#define MMDVM_RX_RING_SIZE 1024    // Modem RX parser ring buffer in bytes (power of two)
+#define NETWORK_RX_QUEUE_DEPTH 16  // Received network datagrams waiting for the main loop (power of two)
+#define NETWORK_FRAME_POOL_SIZE 18 // 64-byte network frames: the RX queue plus the frames being released / filled (max 254)
+
+// Network receive: true = AsyncUDP callback copies each datagram into the RX queue as it
+// arrives; false = poll WiFiUDP from the core task pass (the former path, kept for latency comparison)
+#define NETWORK_RX_ASYNC true
+
+// MMDVM RX task (reads the modem UART independently of loop(), which runs on core 1)
+#define MMDVM_RX_TASK_CORE 0       // CPU core for the modem RX task
+#define MMDVM_RX_TASK_PRIORITY 5   // FreeRTOS priority (loop() runs at 1)
+
+// Task layout: the DMR core task (modem frames, network, call timers, login) runs on its own
+// core above everything but the modem RX task; loop() (web, OLED, LEDs) and the lookup, SD
+// and DNS workers share the other core at low priority
+#define DMR_CORE_TASK_CORE 0       // CPU core for the DMR core task (with the modem RX task and WiFi)
+#define DMR_CORE_TASK_PRIORITY 4   // Below the modem RX task (5), above loop() and the workers (1)
+#define DMR_CORE_TASK_STACK 8192
+#define DMR_CORE_TICK_MS 20        // Longest sleep between core passes without a frame (call timers need tens of ms)
+#define DMR_CORE_POLL_TICK_MS 2    // ... with NETWORK_RX_ASYNC false, where each pass polls the UDP socket
+#define APP_TASK_CORE 1            // CPU core for the lookup, SD database and DNS workers (loop() runs on 1)
+#define LOG_QUEUE_DEPTH 32         // Log lines from other tasks waiting for loop()
+#define LOG_LINE_MAX 160           // Longer lines are cut off
+
+// DMR FEC (DMRFEC.h): log a self-test and bursts/sec benchmark of the codecs at boot
+#define DMR_FEC_BENCHMARK false
 
 // Timeouts
 #define MMDVM_RESPONSE_TIMEOUT 1000  // Milliseconds to wait for MMDVM response
+#define MMDVM_STATUS_POLL_INTERVAL 250  // Milliseconds between modem status polls (buffer space / TX state)
 #define WIFI_CONNECT_TIMEOUT 30000   // Milliseconds to wait for WiFi connection
 
 // ===== Multi-Protocol Support =====
@@ -0,0 +1,410 @@
+/*
+ * database-converter.cpp - Host tool for the ESP32 MMDVM Hotspot user database
+ *
+ * Converts the RadioID CSV (database.csv / user.csv layout:
+ * RADIO_ID,CALLSIGN,FIRST_NAME,LAST_NAME,CITY,STATE,COUNTRY) into the compact
+ * format described in ../UserDatabaseFormat.h, and benchmarks it against the CSV.
+ *
+ *   database-converter convert <database.csv> <database.udb>
+ *   database-converter lookup  <database.udb> <dmr id>...
+ *   database-converter bench   <database.csv> <database.udb> [lookups]
+ *
+ * Build: ./make-database.sh (or g++ -O2 -std=c++17 -o database-converter database-converter.cpp)
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../UserDatabaseFormat.h"
+
+struct CsvRecord {
+  uint32_t dmrId;
+  std::string callsign;
+  std::string firstName;
+  std::string lastName;
+  std::string dict[UDB_DICT_COUNT];
+};
+
+// Deduplicated NUL-terminated strings, offset 0 = ""
+class StringPool {
+public:
+  std::vector<uint8_t> bytes;
+  std::unordered_map<std::string, uint32_t> offsets;
+
+  StringPool() {
+    bytes.push_back(0);
+    offsets[""] = 0;
+  }
+
+  uint32_t add(const std::string &s) {
+    auto it = offsets.find(s);
+    if (it != offsets.end()) return it->second;
+    uint32_t offset = bytes.size();
+    bytes.insert(bytes.end(), s.begin(), s.end());
+    bytes.push_back(0);
+    offsets[s] = offset;
+    return offset;
+  }
+};
+
+// Dictionary of pool offsets, index 0 = ""
+class Dictionary {
+public:
+  std::vector<uint32_t> entries;
+  std::unordered_map<std::string, uint32_t> indexes;
+
+  Dictionary() {
+    entries.push_back(0);
+    indexes[""] = 0;
+  }
+
+  uint32_t add(const std::string &s, StringPool &pool) {
+    auto it = indexes.find(s);
+    if (it != indexes.end()) return it->second;
+    uint32_t index = entries.size();
+    entries.push_back(pool.add(s));
+    indexes[s] = index;
+    return index;
+  }
+};
+
+static uint64_t fileSize(const char* path) {
+  struct stat st;
+  return stat(path, &st) == 0 ? (uint64_t)st.st_size : 0;
+}
+
+static double nowUs() {
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Split one CSV line (double quotes group commas, "" is a literal quote)
+static std::vector<std::string> splitCsv(const std::string &line) {
+  std::vector<std::string> fields(1);
+  bool quoted = false;
+  for (size_t i = 0; i < line.size(); i++) {
+    char c = line[i];
+    if (c == '"') {
+      if (quoted && i + 1 < line.size() && line[i + 1] == '"') {
+        fields.back() += '"';
+        i++;
+      } else {
+        quoted = !quoted;
+      }
+    } else if (c == ',' && !quoted) {
+      fields.emplace_back();
+    } else if (c != '\r' && c != '\n') {
+      fields.back() += c;
+    }
+  }
+  for (auto &f : fields) {
+    size_t start = f.find_first_not_of(' ');
+    size_t end = f.find_last_not_of(' ');
+    f = (start == std::string::npos) ? "" : f.substr(start, end - start + 1);
+    std::replace(f.begin(), f.end(), '|', ' ');  // '|' separates the fields of userInfo on the device
+  }
+  return fields;
+}
+
+static bool readCsv(const char* path, std::vector<CsvRecord> &records, uint32_t &skipped) {
+  FILE* in = fopen(path, "rb");
+  if (in == NULL) {
+    fprintf(stderr, "Cannot open %s\n", path);
+    return false;
+  }
+  std::string line;
+  char buffer[4096];
+  skipped = 0;
+  while (fgets(buffer, sizeof(buffer), in) != NULL) {
+    line = buffer;
+    while (!line.empty() && line.back() != '\n' && fgets(buffer, sizeof(buffer), in) != NULL) line += buffer;
+
+    std::vector<std::string> f = splitCsv(line);
+    char* end = NULL;
+    unsigned long id = (f.size() >= 2 && !f[0].empty()) ? strtoul(f[0].c_str(), &end, 10) : 0;
+    if (id == 0 || id > 0xFFFFFFFFUL || *end != '\0' || f[1].empty()) {
+      skipped++;  // Header line or malformed record
+      continue;
+    }
+    f.resize(7);
+    for (size_t i = 2; i < f.size(); i++) {
+      if (f[i].size() > UDB_STRING_MAX - 1) f[i].resize(UDB_STRING_MAX - 1);  // Device reads at most this much
+    }
+    CsvRecord r;
+    r.dmrId = id;
+    r.callsign = f[1].substr(0, UDB_CALLSIGN_MAX);
+    r.firstName = f[2];
+    r.lastName = f[3];
+    r.dict[UDB_DICT_CITY] = f[4];
+    r.dict[UDB_DICT_STATE] = f[5];
+    r.dict[UDB_DICT_COUNTRY] = f[6];
+    records.push_back(r);
+  }
+  fclose(in);
+  return true;
+}
+
+static int convert(const char* csvPath, const char* outPath) {
+  double start = nowUs();
+  std::vector<CsvRecord> records;
+  uint32_t skipped;
+  if (!readCsv(csvPath, records, skipped)) return 1;
+
+  std::stable_sort(records.begin(), records.end(), [](const CsvRecord &a, const CsvRecord &b) {
+    return a.dmrId < b.dmrId;
+  });
+  size_t before = records.size();
+  records.erase(std::unique(records.begin(), records.end(), [](const CsvRecord &a, const CsvRecord &b) {
+    return a.dmrId == b.dmrId;
+  }), records.end());
+  uint32_t duplicates = before - records.size();
+  if (records.empty()) {
+    fprintf(stderr, "No records in %s\n", csvPath);
+    return 1;
+  }
+
+  StringPool pool;
+  Dictionary dicts[UDB_DICT_COUNT];
+  std::vector<UDBBlockInfo> blocks;
+  std::vector<uint8_t> data;
+  uint32_t maxBlockSize = 0;
+
+  for (size_t first = 0; first < records.size(); first += UDB_RECORDS_PER_BLOCK) {
+    size_t last = std::min(records.size(), first + UDB_RECORDS_PER_BLOCK);
+    std::vector<uint8_t> block;
+    uint32_t previous = records[first].dmrId;
+    for (size_t i = first; i < last; i++) {
+      const CsvRecord &r = records[i];
+      uint8_t tmp[5];
+      block.insert(block.end(), tmp, tmp + udbPutVarint(tmp, r.dmrId - previous));
+      previous = r.dmrId;
+      block.push_back(r.callsign.size());
+      block.insert(block.end(), r.callsign.begin(), r.callsign.end());
+      uint32_t fields[2 + UDB_DICT_COUNT] = { pool.add(r.firstName), pool.add(r.lastName) };
+      for (uint8_t d = 0; d < UDB_DICT_COUNT; d++) fields[2 + d] = dicts[d].add(r.dict[d], pool);
+      for (uint32_t v : fields) block.insert(block.end(), tmp, tmp + udbPutVarint(tmp, v));
+    }
+    if (block.size() > UDB_BLOCK_SIZE_MAX) {
+      fprintf(stderr, "Block too large (%zu bytes)\n", block.size());
+      return 1;
+    }
+    UDBBlockInfo info;
+    info.firstId = records[first].dmrId;
+    info.offset = data.size();  // Relative for now
+    info.size = block.size();
+    info.count = last - first;
+    info.crc = udbCrc32(block.data(), block.size());
+    blocks.push_back(info);
+    maxBlockSize = std::max<uint32_t>(maxBlockSize, block.size());
+    data.insert(data.end(), block.begin(), block.end());
+  }
+
+  UDBHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = UDB_MAGIC;
+  header.version = UDB_VERSION;
+  header.recordsPerBlock = UDB_RECORDS_PER_BLOCK;
+  header.recordCount = records.size();
+  header.blockCount = blocks.size();
+  header.indexOffset = sizeof(UDBHeader);
+  header.dataOffset = header.indexOffset + blocks.size() * sizeof(UDBBlockInfo);
+  uint32_t offset = header.dataOffset + data.size();
+  for (uint8_t d = 0; d < UDB_DICT_COUNT; d++) {
+    header.dictOffset[d] = offset;
+    header.dictCount[d] = dicts[d].entries.size();
+    offset += dicts[d].entries.size() * sizeof(uint32_t);
+  }
+  header.poolOffset = offset;
+  header.poolSize = pool.bytes.size();
+  header.maxBlockSize = maxBlockSize;
+  header.headerCrc = udbCrc32((const uint8_t*)&header, offsetof(UDBHeader, headerCrc));
+  for (auto &b : blocks) b.offset += header.dataOffset;
+
+  FILE* out = fopen(outPath, "wb");
+  if (out == NULL) {
+    fprintf(stderr, "Cannot create %s\n", outPath);
+    return 1;
+  }
+  bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+            fwrite(blocks.data(), sizeof(UDBBlockInfo), blocks.size(), out) == blocks.size() &&
+            fwrite(data.data(), 1, data.size(), out) == data.size();
+  for (uint8_t d = 0; d < UDB_DICT_COUNT && ok; d++) {
+    ok = fwrite(dicts[d].entries.data(), sizeof(uint32_t), dicts[d].entries.size(), out) == dicts[d].entries.size();
+  }
+  ok = ok && fwrite(pool.bytes.data(), 1, pool.bytes.size(), out) == pool.bytes.size();
+  ok = (fclose(out) == 0) && ok;
+  if (!ok) {
+    fprintf(stderr, "Write to %s failed\n", outPath);
+    return 1;
+  }
+
+  uint64_t csvBytes = fileSize(csvPath);
+  uint64_t udbBytes = fileSize(outPath);
+  printf("Records:      %u (%u lines skipped, %u duplicate IDs dropped)\n", header.recordCount, skipped, duplicates);
+  printf("Blocks:       %u x %u records, largest %u bytes\n", header.blockCount, UDB_RECORDS_PER_BLOCK, maxBlockSize);
+  printf("Dictionaries: %u cities, %u states, %u countries\n", header.dictCount[UDB_DICT_CITY] - 1,
+         header.dictCount[UDB_DICT_STATE] - 1, header.dictCount[UDB_DICT_COUNTRY] - 1);
+  printf("Sections:     index %zu, blocks %zu, dictionaries %u, strings %u bytes\n", blocks.size() * sizeof(UDBBlockInfo),
+         data.size(), header.poolOffset - header.dictOffset[0], header.poolSize);
+  printf("Size:         %llu -> %llu bytes (%.1f%% of the CSV)\n", (unsigned long long)csvBytes, (unsigned long long)udbBytes,
+         csvBytes > 0 ? udbBytes * 100.0 / csvBytes : 0.0);
+  printf("Converted in  %.0f ms\n", (nowUs() - start) / 1000.0);
+  return 0;
+}
+
+// stdio source for UserDatabaseReader
+class FileSource {
+public:
+  FILE* file;
+  uint64_t bytesRead;
+
+  explicit FileSource(FILE* f) : file(f), bytesRead(0) {}
+
+  bool readAt(uint32_t offset, uint8_t* buffer, size_t length) {
+    bytesRead += length;
+    if (fseek(file, offset, SEEK_SET) != 0) return false;
+    size_t n = fread(buffer, 1, length, file);
+    if (n < length) memset(buffer + n, 0, length - n);  // Pool strings at the end of the file
+    return n > 0;
+  }
+};
+
+// Same "callsign|name|city|country" string the firmware builds
+static std::string formatUserInfo(UserDatabaseReader<FileSource> &reader, const UDBRecord &r) {
+  char name[UDB_STRING_MAX], city[UDB_STRING_MAX], country[UDB_STRING_MAX];
+  reader.readString(r.firstName, name, sizeof(name));
+  reader.readDict(UDB_DICT_CITY, r.dict[UDB_DICT_CITY], city, sizeof(city));
+  reader.readDict(UDB_DICT_COUNTRY, r.dict[UDB_DICT_COUNTRY], country, sizeof(country));
+  return std::string(r.callsign) + "|" + name + "|" + city + "|" + country;
+}
+
+static bool openReader(const char* path, FileSource &source, UserDatabaseReader<FileSource> &reader) {
+  if (source.file == NULL) {
+    fprintf(stderr, "Cannot open %s\n", path);
+    return false;
+  }
+  if (!reader.open(&source, fileSize(path))) {
+    fprintf(stderr, "%s is not a valid user database\n", path);
+    return false;
+  }
+  return true;
+}
+
+static int lookup(const char* udbPath, int count, char** ids) {
+  FileSource source(fopen(udbPath, "rb"));
+  UserDatabaseReader<FileSource> reader;
+  if (!openReader(udbPath, source, reader)) return 1;
+  for (int i = 0; i < count; i++) {
+    UDBRecord r;
+    uint32_t id = strtoul(ids[i], NULL, 10);
+    if (reader.find(id, r)) {
+      printf("%u: %s\n", id, formatUserInfo(reader, r).c_str());
+    } else {
+      printf("%u: not found\n", id);
+    }
+  }
+  return 0;
+}
+
+// CSV lookup the way database_sdcard does it: scan from the start until the ID
+static bool scanCsv(FILE* csv, uint32_t dmrId, uint64_t &bytesRead) {
+  char line[1024];
+  fseek(csv, 0, SEEK_SET);
+  while (fgets(line, sizeof(line), csv) != NULL) {
+    bytesRead += strlen(line);
+    if (strtoul(line, NULL, 10) == dmrId) return true;
+  }
+  return false;
+}
+
+static double percentile(std::vector<double> v, double p) {
+  if (v.empty()) return 0;
+  size_t rank = (size_t)(p / 100.0 * v.size());
+  if (rank >= v.size()) rank = v.size() - 1;
+  std::nth_element(v.begin(), v.begin() + rank, v.end());
+  return v[rank];
+}
+
+static int bench(const char* csvPath, const char* udbPath, uint32_t lookups) {
+  std::vector<CsvRecord> records;
+  uint32_t skipped;
+  if (!readCsv(csvPath, records, skipped) || records.empty()) return 1;
+
+  FileSource source(fopen(udbPath, "rb"));
+  UserDatabaseReader<FileSource> reader;
+  if (!openReader(udbPath, source, reader)) return 1;
+
+  // Every CSV record must round-trip
+  uint32_t mismatches = 0;
+  for (const CsvRecord &r : records) {
+    UDBRecord found;
+    std::string expected = r.callsign + "|" + r.firstName + "|" + r.dict[UDB_DICT_CITY] + "|" + r.dict[UDB_DICT_COUNTRY];
+    if (!reader.find(r.dmrId, found) || formatUserInfo(reader, found) != expected) {
+      if (mismatches++ < 5) fprintf(stderr, "Mismatch for %u\n", r.dmrId);
+    }
+  }
+
+  std::mt19937 rng(2041);
+  std::vector<double> udbTimes;
+  uint32_t readsBefore = reader.getReads();
+  uint64_t bytesBefore = source.bytesRead;
+  for (uint32_t i = 0; i < lookups; i++) {
+    const CsvRecord &r = records[rng() % records.size()];
+    double t = nowUs();
+    UDBRecord found;
+    if (reader.find(r.dmrId, found)) formatUserInfo(reader, found);
+    udbTimes.push_back(nowUs() - t);
+  }
+  uint32_t udbReads = reader.getReads() - readsBefore;
+  uint64_t udbBytes = source.bytesRead - bytesBefore;
+
+  // The linear scan is slow; a few lookups are enough
+  FILE* csv = fopen(csvPath, "rb");
+  std::vector<double> csvTimes;
+  uint64_t csvBytes = 0;
+  uint32_t csvLookups = std::min<uint32_t>(lookups, 50);
+  for (uint32_t i = 0; i < csvLookups && csv != NULL; i++) {
+    const CsvRecord &r = records[rng() % records.size()];
+    double t = nowUs();
+    scanCsv(csv, r.dmrId, csvBytes);
+    csvTimes.push_back(nowUs() - t);
+  }
+  if (csv != NULL) fclose(csv);
+
+  uint64_t csvSize = fileSize(csvPath);
+  uint64_t udbSize = fileSize(udbPath);
+  printf("Round trip:   %zu records, %u mismatches, %u CRC errors\n", records.size(), mismatches, reader.getCrcErrors());
+  printf("Size:         CSV %llu bytes, compact %llu bytes (%.1f%%)\n", (unsigned long long)csvSize,
+         (unsigned long long)udbSize, csvSize > 0 ? udbSize * 100.0 / csvSize : 0.0);
+  printf("RAM (device): %u bytes (block index, dictionaries, block buffer)\n",
+         reader.getHeader().blockCount * (uint32_t)sizeof(UDBBlockInfo) +
+         (reader.getHeader().poolOffset - reader.getHeader().dictOffset[0]) + reader.getHeader().maxBlockSize);
+  printf("Compact:      %u lookups, p50 %.1f us, p99 %.1f us, %.1f reads / %.0f bytes per lookup\n", lookups,
+         percentile(udbTimes, 50), percentile(udbTimes, 99), (double)udbReads / lookups, (double)udbBytes / lookups);
+  printf("CSV scan:     %u lookups, p50 %.1f us, p99 %.1f us, %.0f bytes per lookup\n", csvLookups,
+         percentile(csvTimes, 50), percentile(csvTimes, 99), csvLookups > 0 ? (double)csvBytes / csvLookups : 0.0);
+  return mismatches == 0 && reader.getCrcErrors() == 0 ? 0 : 1;
+}
+
+static void usage() {
+  fprintf(stderr,
+          "Usage:\n"
+          "  database-converter convert <database.csv> <database.udb>\n"
+          "  database-converter lookup  <database.udb> <dmr id>...\n"
+          "  database-converter bench   <database.csv> <database.udb> [lookups]\n");
+}
+
+int main(int argc, char** argv) {
+  if (argc >= 4 && strcmp(argv[1], "convert") == 0) return convert(argv[2], argv[3]);
+  if (argc >= 4 && strcmp(argv[1], "lookup") == 0) return lookup(argv[2], argc - 3, argv + 3);
+  if (argc >= 4 && strcmp(argv[1], "bench") == 0) return bench(argv[2], argv[3], argc >= 5 ? strtoul(argv[4], NULL, 10) : 10000);
+  usage();
+  return 2;
+}
@@ -5,6 +5,13 @@
 
 #define DL_LED_PIN 38  // GPIO 38 for download progress indication
 
+// Download: network reads and SD writes overlap through two buffers
+#define DL_BUFFER_SIZE 8192
+#define DL_BUFFER_COUNT 2
+#define DL_MAX_ATTEMPTS 5        // Connections per download (resumed with HTTP Range)
+#define DL_READ_TIMEOUT 15000    // ms without data before reconnecting
+#define DL_RETRY_DELAY 2000      // ms before the first retry (doubles each attempt)
+
 // Simple web server
 WiFiServer server(80);
 
@@ -28,6 +35,76 @@ const char* fileURL = "https://raw.githubusercontent.com/javastraat/esp32_mmdvm_
 //https://raw.githubusercontent.com/javastraat/esp32_mmdvm_hotspot/refs/heads/main/database.csv
 const char* databaseDir = "/database";
 const char* destFile = "/database/database.csv";
+const char* partFile = "/database/database.csv.part";      // Download in progress
+const char* backupFile = "/database/database.csv.bak";     // Old database while swapping
+const char* etagFile = "/database/database.etag";          // ETag of destFile
+const char* partEtagFile = "/database/database.part.etag"; // ETag of partFile
+const char* indexFile = "/database/database.idx";          // Lookup index used by the hotspot firmware
+const char* indexTempFile = "/database/database.idx.tmp";
+
+// Binary index, same layout as SDUserDatabase.h in the hotspot firmware:
+// 512-byte header block, then { uint32 DMR ID, uint32 line offset } sorted by ID
+#define INDEX_MAGIC 0x58444944  // "DIDX"
+#define INDEX_VERSION 1
+#define INDEX_HEADER_SIZE 512
+#define INDEX_BLOCK_ENTRIES 64
+
+struct IndexEntry {
+  uint32_t dmrId;
+  uint32_t offset;
+};
+
+struct IndexHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t entrySize;
+  uint32_t count;
+  uint32_t csvSize;
+  uint32_t csvTime;
+  uint32_t buildMs;
+};
+
+// Streaming index builder, fed with the CSV bytes as they are written
+struct IndexBuilder {
+  File out;
+  IndexEntry block[INDEX_BLOCK_ENTRIES];
+  uint32_t fill;
+  uint32_t entries;
+  uint32_t pos;        // CSV bytes seen
+  uint32_t lineStart;
+  uint32_t id;
+  uint32_t lastId;
+  uint8_t digits;
+  bool inId;
+  bool sorted;
+  bool ok;
+} indexBuilder;
+
+struct DownloadBuffer {
+  uint8_t data[DL_BUFFER_SIZE];
+  size_t length;
+};
+
+DownloadBuffer dlBuffers[DL_BUFFER_COUNT];
+QueueHandle_t dlFreeQueue = NULL;   // Buffers the network side can fill
+QueueHandle_t dlFullQueue = NULL;   // Buffers waiting for the SD writer (NULL = stop)
+TaskHandle_t dlWriterHandle = NULL;
+TaskHandle_t dlWaitingTask = NULL;
+File dlPart;                        // Owned by the writer task while it runs
+volatile bool dlWriteOk = true;
+volatile uint32_t dlWriteMs = 0;
+
+// Result of the last download, shown on the web page
+struct DownloadStats {
+  String result;
+  uint32_t bytes;         // Downloaded in this refresh (excluding resumed data)
+  uint32_t fileSize;
+  uint32_t networkMs;
+  uint32_t sdWriteMs;
+  uint32_t totalMs;       // Whole refresh incl. index and file swap
+  uint32_t resumes;       // Reconnects that continued with HTTP Range
+  uint32_t indexEntries;
+} lastDownload = { "No download yet", 0, 0, 0, 0, 0, 0, 0 };
 
 
 SPIClass sdSPI(HSPI);
@@ -268,49 +345,352 @@ void setup() {
   Serial.println(WiFi.localIP());
 }
 
-void performDownload() {
-  Serial.println("=== Download requested ===");
+// ===== Streaming index =====
+
+void indexReset() {
+  if (indexBuilder.out) indexBuilder.out.close();
+  indexBuilder.fill = 0;
+  indexBuilder.entries = 0;
+  indexBuilder.pos = 0;
+  indexBuilder.lineStart = 0;
+  indexBuilder.id = 0;
+  indexBuilder.lastId = 0;
+  indexBuilder.digits = 0;
+  indexBuilder.inId = true;
+  indexBuilder.sorted = true;
+  indexBuilder.out = SD.open(indexTempFile, FILE_WRITE);
+  uint8_t zero[INDEX_HEADER_SIZE] = {0};
+  indexBuilder.ok = indexBuilder.out && indexBuilder.out.write(zero, sizeof(zero)) == sizeof(zero);
+}
+
+// Record { id, line offset } for every line that starts with a DMR ID
+void indexFeed(const uint8_t* data, size_t length) {
+  IndexBuilder &b = indexBuilder;
+  if (!b.ok) return;
+  for (size_t i = 0; i < length; i++) {
+    uint8_t c = data[i];
+    if (c == '\n') {
+      b.lineStart = b.pos + i + 1;
+      b.id = 0;
+      b.digits = 0;
+      b.inId = true;
+      continue;
+    }
+    if (!b.inId) continue;
+    if (c >= '0' && c <= '9' && b.digits < 9) {
+      b.id = b.id * 10 + (c - '0');
+      b.digits++;
+      continue;
+    }
+    b.inId = false;
+    if (c != ',' || b.id == 0) continue;  // Header or malformed line
+
+    if (b.id <= b.lastId) b.sorted = false;
+    b.lastId = b.id;
+    b.block[b.fill].dmrId = b.id;
+    b.block[b.fill].offset = b.lineStart;
+    b.entries++;
+    if (++b.fill == INDEX_BLOCK_ENTRIES) {
+      b.ok = b.out.write((uint8_t*)b.block, sizeof(b.block)) == sizeof(b.block);
+      b.fill = 0;
+    }
+  }
+  b.pos += length;
+}
+
+// Rebuild the builder state for a partial download left by an earlier session
+bool indexCatchUp(const char* path) {
+  indexReset();
+  File in = SD.open(path);
+  if (!in) return false;
+  DownloadBuffer &buf = dlBuffers[0];
+  int n;
+  while ((n = in.read(buf.data, DL_BUFFER_SIZE)) > 0) {
+    indexFeed(buf.data, n);
+  }
+  in.close();
+  return indexBuilder.ok;
+}
+
+// Write the header and install the index. An unsorted CSV is left to the
+// hotspot, which sorts while building its own index.
+bool indexFinish(uint32_t buildMs) {
+  IndexBuilder &b = indexBuilder;
+  if (b.ok && b.fill > 0) {
+    b.ok = b.out.write((uint8_t*)b.block, b.fill * sizeof(IndexEntry)) == b.fill * sizeof(IndexEntry);
+  }
+  if (b.out) b.out.close();
+  if (!b.ok || !b.sorted || b.entries == 0) {
+    SD.remove(indexTempFile);
+    return false;
+  }
+
+  File csv = SD.open(destFile);
+  if (!csv) return false;
+  IndexHeader header;
+  header.magic = INDEX_MAGIC;
+  header.version = INDEX_VERSION;
+  header.entrySize = sizeof(IndexEntry);
+  header.count = b.entries;
+  header.csvSize = csv.size();
+  header.csvTime = (uint32_t)csv.getLastWrite();
+  header.buildMs = buildMs > 0 ? buildMs : 1;
+  csv.close();
+
+  File out = SD.open(indexTempFile, "r+");
+  bool ok = out && out.seek(0) && out.write((uint8_t*)&header, sizeof(header)) == sizeof(header);
+  if (out) out.close();
+  SD.remove(indexFile);
+  return ok && SD.rename(indexTempFile, indexFile);
+}
 
+// ===== Download =====
+
+String readTextFile(const char* path) {
+  File f = SD.open(path);
+  if (!f) return "";
+  String text = f.readString();
+  f.close();
+  text.trim();
+  return text;
+}
+
+void writeTextFile(const char* path, const String &text) {
+  File f = SD.open(path, FILE_WRITE);
+  if (f) {
+    f.print(text);
+    f.close();
+  }
+}
+
+// SD writer task: writes filled buffers to the part file and feeds the index
+void sdWriterTask(void* param) {
+  DownloadBuffer* buf;
+  while (xQueueReceive(dlFullQueue, &buf, portMAX_DELAY) == pdTRUE && buf != NULL) {
+    unsigned long start = millis();
+    if (dlWriteOk && dlPart.write(buf->data, buf->length) != buf->length) {
+      dlWriteOk = false;
+    }
+    dlWriteMs += millis() - start;
+    indexFeed(buf->data, buf->length);
+    xQueueSend(dlFreeQueue, &buf, portMAX_DELAY);
+  }
+  dlPart.close();
+  dlWriterHandle = NULL;
+  xTaskNotifyGive(dlWaitingTask);
+  vTaskDelete(NULL);
+}
+
+bool startWriter(const char* mode) {
+  dlPart = SD.open(partFile, mode);
+  if (!dlPart) return false;
+  dlWriteOk = true;
+  dlWaitingTask = xTaskGetCurrentTaskHandle();
+  xQueueReset(dlFreeQueue);
+  xQueueReset(dlFullQueue);
+  for (int i = 0; i < DL_BUFFER_COUNT; i++) {
+    DownloadBuffer* buf = &dlBuffers[i];
+    xQueueSend(dlFreeQueue, &buf, 0);
+  }
+  // Core 0: the network side runs in loop() on core 1
+  return xTaskCreatePinnedToCore(sdWriterTask, "SdWriter", 4096, NULL, 2, &dlWriterHandle, 0) == pdPASS;
+}
+
+// Let the writer finish everything queued, then stop it
+void stopWriter() {
+  if (dlWriterHandle == NULL) return;
+  DownloadBuffer* stop = NULL;
+  xQueueSend(dlFullQueue, &stop, portMAX_DELAY);
+  ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+// One connection. Returns the HTTP code; received counts bytes handed to the writer.
+int downloadAttempt(uint32_t &offset, int32_t &total, uint32_t &received) {
   HTTPClient http;
+  const char* headerKeys[] = { "ETag", "Content-Range" };
   http.begin(fileURL);
-  int httpCode = http.GET();
+  http.setTimeout(DL_READ_TIMEOUT);
+  http.collectHeaders(headerKeys, 2);
+
+  String partEtag = readTextFile(partEtagFile);
+  String etag = readTextFile(etagFile);
+  if (offset > 0) {
+    http.addHeader("Range", "bytes=" + String(offset) + "-");
+    if (partEtag.length() > 0) http.addHeader("If-Range", partEtag);  // Full file (200) if it changed
+  } else if (etag.length() > 0 && SD.exists(destFile)) {
+    http.addHeader("If-None-Match", etag);
+  }
 
+  int httpCode = http.GET();
+  if (httpCode == HTTP_CODE_OK && offset > 0) {
+    // Range not honoured or the file changed: start over
+    Serial.println("Server sent the whole file, restarting download");
+    stopWriter();
+    offset = 0;
+    indexReset();
+    if (!startWriter(FILE_WRITE)) {
+      http.end();
+      return -1;
+    }
+  }
   if (httpCode == HTTP_CODE_OK) {
-    // Delete old file if exists
-    if (SD.exists(destFile)) {
-      SD.remove(destFile);
-      Serial.println("Removed old database file");
+    total = http.getSize();
+    writeTextFile(partEtagFile, http.header("ETag"));
+  } else if (httpCode == HTTP_CODE_PARTIAL_CONTENT) {
+    // Content-Range: bytes <first>-<last>/<total>
+    String range = http.header("Content-Range");
+    int dash = range.indexOf('-');
+    int slash = range.indexOf('/');
+    if (dash < 0 || slash < 0 || (uint32_t)range.substring(6, dash).toInt() != offset) {
+      Serial.println("Unexpected Content-Range: " + range);
+      http.end();
+      return -1;
     }
+    total = range.substring(slash + 1).toInt();
+  } else {
+    http.end();
+    return httpCode;
+  }
 
-    File outFile = SD.open(destFile, FILE_WRITE);
-    if (!outFile) {
-      Serial.println("FAILED: Couldn't create file on SD!");
-      http.end();
-      return;
+  WiFiClient* stream = http.getStreamPtr();
+  unsigned long lastData = millis();
+  DownloadBuffer* buf = NULL;
+  while (total >= 0 && offset < (uint32_t)total) {
+    if (buf == NULL) {
+      if (xQueueReceive(dlFreeQueue, &buf, pdMS_TO_TICKS(DL_READ_TIMEOUT)) != pdTRUE) break;  // SD stalled
+      buf->length = 0;
+    }
+    size_t available = stream->available();
+    if (available == 0) {
+      if (!stream->connected() || millis() - lastData > DL_READ_TIMEOUT) break;
+      vTaskDelay(1);
+      continue;
     }
-    Serial.println("File opened successfully!");
+    size_t space = DL_BUFFER_SIZE - buf->length;
+    int n = stream->read(buf->data + buf->length, available < space ? available : space);
+    if (n <= 0) continue;
+    lastData = millis();
+    buf->length += n;
+    offset += n;
+    received += n;
+    if (buf->length == DL_BUFFER_SIZE || (total >= 0 && offset >= (uint32_t)total)) {
+      xQueueSend(dlFullQueue, &buf, portMAX_DELAY);
+      buf = NULL;
+    }
+  }
+  if (buf != NULL) {
+    if (buf->length > 0) {
+      xQueueSend(dlFullQueue, &buf, portMAX_DELAY);
+    } else {
+      xQueueSend(dlFreeQueue, &buf, 0);
+    }
+  }
+  http.end();
+  return httpCode;
+}
 
-    // Start blinking LED
-    downloadActive = true;
-    xTaskCreatePinnedToCore(blinkTask, "BlinkTask", 1024, NULL, 1, &blinkTaskHandle, 1);
+// Download into partFile, resuming with HTTP Range after a dropped connection,
+// then swap it in and install the index built while streaming
+void performDownload() {
+  Serial.println("=== Download requested ===");
+  unsigned long refreshStart = millis();
 
-    unsigned long downloadStart = millis();
-    int written = http.writeToStream(&outFile);
-    unsigned long downloadDuration = millis() - downloadStart;
+  if (dlFreeQueue == NULL) {
+    dlFreeQueue = xQueueCreate(DL_BUFFER_COUNT, sizeof(DownloadBuffer*));
+    dlFullQueue = xQueueCreate(DL_BUFFER_COUNT + 1, sizeof(DownloadBuffer*));
+  }
+
+  // Continue a partial download from an earlier session if we know its ETag
+  uint32_t offset = 0;
+  File existing = SD.open(partFile);
+  if (existing && readTextFile(partEtagFile).length() > 0) {
+    offset = existing.size();
+  }
+  if (existing) existing.close();
+  if (offset > 0 && indexCatchUp(partFile)) {
+    Serial.printf("Resuming partial download at %u bytes\n", (unsigned)offset);
+  } else {
+    offset = 0;
+    indexReset();
+  }
 
-    // Stop blinking LED
-    downloadActive = false;
-    while (blinkTaskHandle != NULL) {
-      vTaskDelay(10 / portTICK_PERIOD_MS);
+  if (!startWriter(offset > 0 ? FILE_APPEND : FILE_WRITE)) {
+    Serial.println("FAILED: Couldn't create file on SD!");
+    lastDownload.result = "SD write failed";
+    downloadRequested = false;
+    return;
+  }
+
+  downloadActive = true;
+  xTaskCreatePinnedToCore(blinkTask, "BlinkTask", 1024, NULL, 1, &blinkTaskHandle, 1);
+
+  int32_t total = -1;
+  uint32_t received = 0;
+  uint32_t resumes = 0;
+  int httpCode = 0;
+  bool complete = false;
+  dlWriteMs = 0;
+  unsigned long downloadStart = millis();
+  for (int attempt = 0; attempt < DL_MAX_ATTEMPTS && !complete; attempt++) {
+    if (attempt > 0) {
+      Serial.printf("Connection lost at %u bytes, retrying...\n", (unsigned)offset);
+      vTaskDelay(pdMS_TO_TICKS(DL_RETRY_DELAY << (attempt - 1)));
+      resumes++;
     }
+    httpCode = downloadAttempt(offset, total, received);
+    if (httpCode == HTTP_CODE_NOT_MODIFIED) break;
+    if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_PARTIAL_CONTENT) {
+      if (total < 0) break;  // No Content-Length: can't tell a complete file from a dropped one
+      complete = offset >= (uint32_t)total;
+    }
+  }
+  uint32_t networkMs = millis() - downloadStart;
+  stopWriter();
 
-    outFile.close();
-    Serial.printf("SUCCESS! Downloaded %d bytes in %lu ms\n", written, downloadDuration);
+  downloadActive = false;
+  while (blinkTaskHandle != NULL) {
+    vTaskDelay(10 / portTICK_PERIOD_MS);
+  }
+
+  lastDownload.bytes = received;
+  lastDownload.networkMs = networkMs;
+  lastDownload.sdWriteMs = dlWriteMs;
+  lastDownload.resumes = resumes;
+
+  if (httpCode == HTTP_CODE_NOT_MODIFIED) {
+    SD.remove(partFile);
+    SD.remove(indexTempFile);
+    lastDownload.result = "Up to date (not modified)";
+  } else if (!complete || !dlWriteOk) {
+    if (indexBuilder.out) indexBuilder.out.close();
+    lastDownload.result = !dlWriteOk ? "SD write failed" : "Incomplete (" + String(offset) + " bytes kept, resumes next time)";
+    Serial.print("Download failed: ");
+    Serial.println(httpCode > 0 ? "HTTP " + String(httpCode) : HTTPClient::errorToString(httpCode));
   } else {
-    Serial.print("HTTP GET failed: ");
-    Serial.println(http.errorToString(httpCode));
+    // Swap in the new file; the old one survives until the new one is in place
+    SD.remove(backupFile);
+    if (SD.exists(destFile)) SD.rename(destFile, backupFile);
+    if (SD.rename(partFile, destFile)) {
+      SD.remove(backupFile);
+      writeTextFile(etagFile, readTextFile(partEtagFile));
+      SD.remove(partEtagFile);
+      unsigned long indexStart = millis();
+      bool indexed = indexFinish(millis() - downloadStart);
+      lastDownload.indexEntries = indexed ? indexBuilder.entries : 0;
+      lastDownload.fileSize = offset;
+      lastDownload.result = indexed ? "OK" : "OK (index built by the hotspot)";
+      Serial.printf("Index: %u entries, finalized in %lu ms\n", (unsigned)indexBuilder.entries, millis() - indexStart);
+    } else {
+      SD.rename(backupFile, destFile);
+      lastDownload.result = "Could not replace the database file";
+    }
   }
-  http.end();
+  lastDownload.totalMs = millis() - refreshStart;
+
+  Serial.printf("%s: %u bytes in %lu ms (%.1f KB/s network, SD %u ms), refresh %lu ms, %u resumes\n",
+                lastDownload.result.c_str(), (unsigned)received, (unsigned long)networkMs,
+                networkMs > 0 ? received / 1.024 / networkMs : 0.0, (unsigned)dlWriteMs,
+                (unsigned long)lastDownload.totalMs, (unsigned)resumes);
   downloadRequested = false;
 }
 
@@ -380,6 +760,15 @@ void loop() {
                 dbFile.close();
               }
             }
+            client.print("<p>Last download: ");
+            client.print(lastDownload.result);
+            client.println("</p>");
+            if (lastDownload.networkMs > 0) {
+              client.printf("<p>%u bytes in %u ms (%.1f KB/s), SD writes %u ms, %u resumes</p>\n",
+                            (unsigned)lastDownload.bytes, (unsigned)lastDownload.networkMs, lastDownload.bytes / 1.024 / lastDownload.networkMs,
+                            (unsigned)lastDownload.sdWriteMs, (unsigned)lastDownload.resumes);
+              client.printf("<p>Refresh time: %u ms, index: %u entries</p>\n", (unsigned)lastDownload.totalMs, (unsigned)lastDownload.indexEntries);
+            }
             client.println("<button onclick=\"location.href='/download'\">Download Database from GitHub</button>");
             client.println("</div>");
 
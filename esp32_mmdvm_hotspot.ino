@@ -17,7 +17,7 @@
  *
  * Libraries needed:
  * - WiFi (built-in)
- * - WiFiUDP (built-in)
+ * - WiFiUDP / AsyncUDP (built-in)
  * - WebServer (built-in)
  * - ESPmDNS (built-in)
  */
@@ -35,6 +35,21 @@
 #include "config.h"
 #include "webpages.h"
 #include "RGBLedController.h"
+#include "ModemTxQueue.h"
+#include "MMDVMStatus.h"
+#include "MMDVMSerialReader.h"
+#include "DMRServerResolver.h"
+#include "DMRUplink.h"
+#include "DMREmbeddedLC.h"
+#include "DMRTalkerAlias.h"
+#include "UDPDrainStats.h"
+#include "DMRNetworkSocket.h"
+#include "DMRSessionSupervisor.h"
+#include "DMRStateLock.h"
+#include "TaskMonitor.h"
+#include "AllocationCounter.h"
+#include "UserLookupService.h"
+#include "UserCache.h"
 
 // OLED Display Support (runtime enable/disable)
 #include <Wire.h>
@@ -51,12 +66,16 @@
 static bool eth_connected = false;
 #include <SPI.h>
 #include <SD.h>
+#include "SDUserDatabase.h"
 #endif  // LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
 
 // SD Card pins are defined in config.h
 SPIClass sdSPI(HSPI);  // Use HSPI for SD card
 bool sdCardAvailable = false;
 uint8_t sdCardType = 0;  // Cached SD card type
+#ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
+SDUserDatabase userDatabase;  // Offline user info from the radioid CSV on the SD card
+#endif
 
 // ESP32-S3 USB Serial configuration
 #ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
@@ -97,6 +116,18 @@ String dmr_location = DMR_LOCATION;
 String dmr_description = DMR_DESCRIPTION;
 String dmr_url = DMR_URL;
 
+// Login settings as the DMR core task uses them: copied from the Strings above under
+// DMRStateLock when a login run starts, because the web handlers reassign those on core 1
+struct DMRLoginConfig {
+  char server[DMR_DNS_HOST_MAX];
+  char callsign[9];      // RPTC field widths (+ terminator)
+  char password[65];
+  char location[21];
+  char description[20];
+  char url[125];
+};
+DMRLoginConfig dmrLogin;
+
 // Hostname setting
 String device_hostname = MDNS_HOSTNAME;
 
@@ -131,8 +162,31 @@ String web_password = WEB_PASSWORD;
 // MMDVM Wakeup Serial (GPIO 13 keeps modem active)
 HardwareSerial MMDVMWakeup(1);
 bool mmdvmWakeupActive = false;
-bool dmrTxActive = false;  // Track if modem is in DMR TX mode
-unsigned long lastDMRFrameTime = 0;
+bool dmrTxActive = false;  // Modem is in DMR TX mode (CMD_DMR_START sent; one flag for both slots)
+
+// Network->modem TX state per timeslot. A slot is ACTIVE while frames are queued for it,
+// ENDING once its TERM_LC is queued, and IDLE when that has played out (or frames stopped).
+// The modem TX starts with the first busy slot and stops when both are idle.
+enum class SLOT_TX : uint8_t { IDLE, ACTIVE, ENDING };
+struct DMRSlotTx {
+  SLOT_TX state;
+  unsigned long lastFrameTime;  // millis() of the last network frame queued for the slot
+  uint32_t dstId;               // Announced in the short LC (duplex)
+  bool isGroup;
+};
+DMRSlotTx slotTx[2] = {{SLOT_TX::IDLE, 0, 0, true}, {SLOT_TX::IDLE, 0, 0, true}};
+ModemTxQueue modemTxQueue;  // Paced network->modem DMR frame playout (60 ms TDMA clock)
+#if SERIAL_TX_BUFFER_SIZE < MODEM_TX_UART_BUFFER_MIN
+#error "SERIAL_TX_BUFFER_SIZE must hold both TX queues (MODEM_TX_UART_BUFFER_MIN)"
+#endif
+MMDVMStatus modemStatus = {};  // Last decoded CMD_GET_STATUS reply (polled every MMDVM_STATUS_POLL_INTERVAL ms)
+uint8_t modemProtocolVersion = 1;  // MMDVM serial protocol version (from CMD_GET_VERSION)
+unsigned long lastStatusPoll = 0;
+MMDVMSerialReader modemReader;  // UART reader task: assembles modem frames off the loop() core
+DMRServerResolver dmrResolver;  // Cached DNS lookup of dmr_server (refreshed in the background)
+UserLookupService userLookup;   // radioid.net lookups in a worker task (never blocks handleNetwork)
+DMRUplink dmrUplink;            // RF->network DMRD encoder (bursts received by the modem)
+uint8_t dmrUplinkPacket[DMRD_PACKET_LENGTH];  // Preallocated DMRD packet for the uplink
 
 // ===== Protocol Constants =====
 #define MMDVM_FRAME_START 0xE0
@@ -159,7 +213,8 @@ unsigned long lastDMRFrameTime = 0;
 #define DMR_SLOT2 0x01
 
 // ===== Global Variables =====
-WiFiUDP udp;
+DMRNetworkSocket dmrSocket;  // UDP to the DMR master (callback-driven receive, see NETWORK_RX_ASYNC)
+DMRSessionSupervisor dmrSession;  // Keepalive loss detection and login retries with backoff
 WebServer server(80);
 Preferences preferences;
 bool wifiConnected = false;
@@ -168,9 +223,6 @@ bool mmdvmReady = false;
 bool dmrLoggedIn = false;
 uint32_t currentTalkgroup = 0;
 String dmrLoginStatus = "Not Connected";
-uint8_t rxBuffer[512];
-uint8_t txBuffer[512];
-int rxBufferPtr = 0;
 
 // DMR Network State Machine
 enum class DMR_STATE {
@@ -183,7 +235,6 @@ enum class DMR_STATE {
 DMR_STATE dmrState = DMR_STATE::DISCONNECTED;
 uint8_t dmrSalt[4];
 unsigned long lastLoginAttempt = 0;
-int loginAttempts = 0;
 
 // RGB LED Status Indicator
 #if ENABLE_RGB_LED
@@ -348,16 +399,49 @@ static const unsigned char PROGMEM icon_dmr[] = {
 String serialLog[SERIAL_LOG_SIZE];
 int serialLogIndex = 0;
 
+// Lines logged from tasks other than loop() go through a queue; loop() writes them to USB
+// serial and the web buffer, so the DMR core task never waits on Serial or the String ring
+struct LogLine {
+  bool toSerial;
+  bool toWeb;
+  char text[LOG_LINE_MAX];
+};
+QueueHandle_t logQueue = NULL;
+uint32_t logLinesDropped = 0;  // Queue was full
+
+// Task layout (see loop() and dmrCoreTask())
+TaskHandle_t uiTaskHandle = NULL;       // Arduino loopTask
+TaskHandle_t dmrCoreTaskHandle = NULL;
+TaskMonitor taskMonitor;
+AllocationCounter allocationCounter;  // Heap allocations per DMRD frame in the core task
+
+#if ALLOCATION_COUNTER_HOOKS
+// ESP-IDF heap hooks (one definition each) feeding AllocationCounter
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t caps) {
+  if (allocationCounterTask != NULL && !xPortInIsrContext() && xTaskGetCurrentTaskHandle() == allocationCounterTask) {
+    allocationCounterCount++;
+  }
+}
+
+extern "C" void IRAM_ATTR esp_heap_trace_free_hook(void* ptr) {
+}
+#endif
+uint8_t uiTaskId = 0;
+uint8_t coreTaskId = 0;
+volatile bool oledRefreshPending = false;  // Set by the core task, redrawn by loop()
+
 unsigned long lastKeepalive = 0;
 
 // DMR Activity Tracking (struct defined in home.h)
 // Track up to 2 simultaneous transmissions (one per slot)
 DMRActivity dmrActivity[2] = {
-  {0, 0, 1, true, "", "", "", "", "", 0, 0, false},
-  {0, 0, 2, true, "", "", "", "", "", 0, 0, false}
+  {0, 0, 1, true, DMR_FRAME_TYPE::UNKNOWN, "", "", "", "", 0, 0, false},
+  {0, 0, 2, true, DMR_FRAME_TYPE::UNKNOWN, "", "", "", "", 0, 0, false}
 };
 
 // DMR Transmission Tracking (for consolidated log output)
+// A network call is one DMRD stream ID; it ends on TERM_LC, a new stream ID on the
+// slot, or DMR_ACTIVITY_TIMEOUT without frames (lost terminator)
 struct DMRTransmission {
   uint32_t srcId;
   uint32_t dstId;
@@ -366,34 +450,37 @@ struct DMRTransmission {
   uint8_t startSeq;
   uint8_t lastSeq;
   bool active;
-  String frameType;
+  DMR_FRAME_TYPE frameType;
+  uint32_t streamId;
+  uint32_t endedStreamId;   // Last stream closed by TERM_LC; its late frames are ignored
+  unsigned long startTime;  // millis() of the first frame
+  unsigned long lastTime;   // millis() of the latest frame
+  uint32_t frames;
+  bool lateEntry;           // Stream started without a voice LC header; not identified by the embedded LC yet
 };
-DMRTransmission currentTx[2] = {{0, 0, 0, true, 0, 0, false, ""}, {0, 0, 0, true, 0, 0, false, ""}};
+DMRTransmission currentTx[2] = {{0, 0, 0, true, 0, 0, false, DMR_FRAME_TYPE::UNKNOWN, 0, 0, 0, 0, 0, false},
+                                {0, 0, 0, true, 0, 0, false, DMR_FRAME_TYPE::UNKNOWN, 0, 0, 0, 0, 0, false}};
+DMREmbeddedLC netEmbeddedLC[2];  // Per-slot embedded LC assembly of network voice bursts
+UDPDrainStats udpDrainStats = {};  // Datagrams queued at the start of each handleNetwork() pass
+uint32_t dmrHeadersSynthesized = 0;  // Network streams that started without a voice LC header
+DMRTalkerAlias netTalkerAlias[2];    // Per-slot talker alias assembly (embedded LC FLCO 4-7)
+uint32_t talkerAliasDecoded = 0;     // Talker aliases completed
+uint32_t talkerAliasLookupsSaved = 0;  // ... that named the station before any lookup result
 
 // DMR Transmission History (for Recent Activity display)
 // struct DMRHistory is defined in webpages.h/home.h
 DMRHistory dmrHistory[DMR_HISTORY_SIZE];
 int dmrHistoryIndex = 0;
-void addDMRHistory(uint32_t srcId, String srcCallsign, String srcName, String srcLocation, uint32_t dstId, bool isGroup, uint32_t duration, uint8_t ber, uint8_t rssi, uint8_t slotNo);
-
-// DMR User Information Lookup Cache
-struct UserInfoCache {
-  uint32_t dmrId;
-  String callsign;
-  String userInfo;  // Format: "callsign|name|city|country"
-  unsigned long timestamp;
-};
-UserInfoCache userCache[DMR_USER_CACHE_SIZE];
-int userCacheIndex = 0;
-
-// Legacy callsign cache for backward compatibility
-struct CallsignCache {
-  uint32_t dmrId;
-  String callsign;
-  unsigned long timestamp;
-};
-CallsignCache callsignCache[DMR_CALLSIGN_CACHE_SIZE];
-int callsignCacheIndex = 0;
+void addDMRHistory(uint32_t srcId, String srcCallsign, String srcName, String srcLocation, uint32_t dstId, bool isGroup, uint32_t durationMs, uint8_t ber, uint8_t rssi, uint8_t slotNo);
+void endDMRTransmission(int slotIndex, const char* reason);
+void startSlotTx(uint8_t slotNo, uint32_t dstId, bool isGroup, const char* callsign);
+void endSlotTx(uint8_t slotNo);
+void sendDMRShortLC();
+bool applyEmbeddedLC(int slotIndex, const uint8_t* lc);
+void applyTalkerAlias(int slotIndex);
+
+// DMR User Information Lookup Cache (hash indexed, allocated in setup())
+UserCache userCache;
 
 // Store alternate WiFi credentials
 // Alternate WiFi Networks (up to 5) - labels from config.h
@@ -462,27 +549,44 @@ void loadConfig();
 void saveConfig();
 void handleMMDVMSerial();
 void handleNetwork();
-void sendMMDVMCommand(uint8_t cmd, uint8_t* data, uint16_t length);
+void processNetworkPacket(uint8_t* packet, int len);
+void sendMMDVMFrame(uint8_t* frame, uint8_t cmd, uint8_t length);
+void sendMMDVMCommand(uint8_t cmd);
 void writeDMRStart(bool tx, String callsign = "");
 void sendFrequency(uint32_t rxFreq, uint32_t txFreq, uint8_t rfPower);
-void processMMDVMFrame();
+void processMMDVMFrame(const MMDVMFrameView &frame);
+void endRFCall(uint8_t slotNo, const char* reason);
 void updateStatusLED();
 void setLEDMode(LED_MODE mode);
 void sendDMRKeepalive();
 void connectToDMRNetwork();
+void dropDMRSession(DMR_SESSION_EVENT event);
 void sendDMRAuth();
 void sendDMRConfig();
+bool sendToMaster(const uint8_t* data, size_t length);
 void logSerial(String message);
 void logSerialVerbose(String message);
+void appendLog(const String &message, bool toSerial, bool toWeb);
+void drainLogQueue();
+void dmrCoreTask(void* arg);
+void dmrCoreService();
 String lookupCallsign(uint32_t dmrId);
 String lookupCallsignAPI(uint32_t dmrId);
 String lookupUserInfo(uint32_t dmrId);
 String lookupUserInfoAPI(uint32_t dmrId);
-String getCachedCallsign(uint32_t dmrId);
+String fetchUserInfoAPI(uint32_t dmrId, int &httpCode);
+String fetchUserInfo(uint32_t dmrId, int &httpCode);
+void processUserLookups();
+#ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
+void reportUserDatabase();
+#endif
+void copyStationField(char* field, size_t size, const String &text, int from, int to);
+void applyUserInfo(DMRActivity &activity, const String &userInfo);
+String getActivityLocation(const DMRActivity &activity);
+void logStationInfo(const DMRActivity &activity, uint32_t srcId);
 String getCachedUserInfo(uint32_t dmrId);
-void cacheCallsign(uint32_t dmrId, String callsign);
 void cacheUserInfo(uint32_t dmrId, String userInfo);
-void addDMRHistory(uint32_t srcId, String srcCallsign, String srcName, String srcLocation, uint32_t dstId, bool isGroup, uint32_t duration, uint8_t ber, uint8_t rssi, uint8_t slotNo);
+void addDMRHistory(uint32_t srcId, String srcCallsign, String srcName, String srcLocation, uint32_t dstId, bool isGroup, uint32_t durationMs, uint8_t ber, uint8_t rssi, uint8_t slotNo);
 
 #ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
 // Helper functions for status page
@@ -498,6 +602,12 @@ uint8_t getSDCardType();
 
 // Web handlers are defined in webpages.h
 
+#if DMR_FEC_BENCHMARK
+static uint64_t fecBenchmarkClock() {
+  return (uint64_t)esp_timer_get_time();
+}
+#endif
+
 void setup() {
 #ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
   // ESP32-S3 USB CDC (native USB support)
@@ -512,6 +622,10 @@ void setup() {
   delay(1000);
 #endif
 
+  // setup() and loop() run in the Arduino loopTask; other tasks log through the queue
+  uiTaskHandle = xTaskGetCurrentTaskHandle();
+  logQueue = xQueueCreate(LOG_QUEUE_DEPTH, sizeof(LogLine));
+
   logSerial("\n\n=== ESP32 MMDVM Hotspot ===");
   logSerial("Initializing...");
 
@@ -547,8 +661,24 @@ void setup() {
   if (enable_oled) {
     updateBootStatus("Init MMDVM...");
   }
+  MMDVM_SERIAL.setRxBufferSize(SERIAL_RX_BUFFER_SIZE);
+  MMDVM_SERIAL.setTxBufferSize(SERIAL_TX_BUFFER_SIZE);  // TX playout runs in the esp_timer task and must not block
   MMDVM_SERIAL.begin(SERIAL_BAUD, SERIAL_8N1, RX_PIN, TX_PIN);
   logSerial("MMDVM Serial initialized");
+  if (modemTxQueue.begin(MMDVM_SERIAL)) {
+    logSerial("MMDVM TX queue started (" + String(MODEM_TX_QUEUE_DEPTH) + " frames/slot, 60 ms playout)");
+  } else {
+    logSerial("ERROR: Could not start MMDVM TX playout timer!");
+  }
+  dmrUplink.begin(dmr_essid > 0 ? dmr_id * 100 + dmr_essid : dmr_id, esp_random());
+#if DMR_FEC_BENCHMARK
+  {
+    DMRFECBenchmark fec = dmrFecBenchmark(fecBenchmarkClock, 2000);
+    logSerial(String("DMR FEC self-test ") + (fec.selfTestOk ? "OK" : "FAILED") +
+              ": header decode " + String(fec.headerDecodesPerSec) + "/s, encode " + String(fec.headerEncodesPerSec) +
+              "/s, EMB decode " + String(fec.embDecodesPerSec) + "/s");
+  }
+#endif
 
   // Initialize SD Card
 #ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
@@ -580,6 +710,11 @@ void setup() {
       logSerial("Created /cache directory");
     }
 
+    // Load (or build) the user database index in the background
+    if (!userDatabase.begin()) {
+      logSerial("ERROR: Could not start user database task!");
+    }
+
     // Test: Read owner.txt if it exists
     if (SD.exists("/owner.txt")) {
       logSerial("Found /owner.txt on SD card, reading contents:");
@@ -691,9 +826,33 @@ void setup() {
     }
   }
 
+  // Resolve the DMR master in the background while the modem initializes
+  if (dmrResolver.begin()) {
+    dmrResolver.setHost(dmr_server.c_str());
+  } else {
+    logSerial("ERROR: Could not start DMR server resolver task!");
+  }
+  if (userCache.begin(DMR_USER_CACHE_SIZE, DMR_USER_CACHE_POOL_SIZE, DMR_USER_CACHE_PSRAM)) {
+    UserCacheStats cacheStats = userCache.getStats();
+    logSerial("User cache: " + String(cacheStats.capacity) + " entries, " + String(cacheStats.bytes / 1024.0, 1) + " KB" +
+              (cacheStats.psram ? " (PSRAM)" : ""));
+  } else {
+    logSerial("ERROR: Could not allocate user cache!");
+  }
+  if (!userLookup.begin(fetchUserInfo)) {
+    logSerial("ERROR: Could not start user lookup task!");
+  }
+
   // Initialize MMDVM
   setupMMDVM();
 
+  // From here on all modem reads go through the reader task
+  if (modemReader.begin(MMDVM_SERIAL)) {
+    logSerial("MMDVM RX task started on core " + String(MMDVM_RX_TASK_CORE));
+  } else {
+    logSerial("ERROR: Could not start MMDVM RX task!");
+  }
+
   // Connect to Networks (based on enabled modes)
   if (wifiConnected) {
     // DMR Network Connection
@@ -769,9 +928,36 @@ void setup() {
   if (enable_oled) {
     updateOLEDStatus();
   }
+
+  // Voice path: modem frames and network datagrams wake the core task directly
+  if (xTaskCreatePinnedToCore(dmrCoreTask, "dmr_core", DMR_CORE_TASK_STACK, NULL, DMR_CORE_TASK_PRIORITY,
+                              &dmrCoreTaskHandle, DMR_CORE_TASK_CORE) == pdPASS) {
+    modemReader.setConsumer(dmrCoreTaskHandle);
+    dmrSocket.setConsumer(dmrCoreTaskHandle);
+    allocationCounter.watch(dmrCoreTaskHandle);
+    logSerial("DMR core task started on core " + String(DMR_CORE_TASK_CORE));
+  } else {
+    logSerial("ERROR: Could not start DMR core task!");
+  }
+
+  // Status page: CPU load of the two service loops, stack high-water marks of all tasks
+  coreTaskId = taskMonitor.add("dmr_core", dmrCoreTaskHandle, DMR_CORE_TASK_CORE);
+  uiTaskId = taskMonitor.add("loopTask", uiTaskHandle, ARDUINO_RUNNING_CORE);
+  taskMonitor.add("mmdvm_rx", NULL, MMDVM_RX_TASK_CORE);
+  taskMonitor.add("async_udp", NULL, -1);
+  taskMonitor.add("user_lookup", NULL, APP_TASK_CORE);
+  taskMonitor.add("dmr_dns", NULL, APP_TASK_CORE);
+#ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
+  taskMonitor.add("user_db", NULL, APP_TASK_CORE);
+#endif
 }
 
+// UI task (Arduino loopTask, core 1, priority 1): buttons, LEDs, web server, log output
+// and OLED. Everything on the voice path runs in dmrCoreTask(), so a slow page, an OLED
+// I2C transfer or SD access here no longer delays frames.
 void loop() {
+  int64_t passStart = esp_timer_get_time();
+
   // MMDVM wakeup serial on GPIO 13 stays open (no need to send more data after initial wakeup)
   // Just keeping the UART port active is enough to keep the modem awake
   
@@ -798,10 +984,13 @@ void loop() {
   // Handle web server
   server.handleClient();
 
-  // Handle MMDVM serial communication
-  handleMMDVMSerial();
+  // Log lines queued by the other tasks
+  drainLogQueue();
+
+#ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
+  reportUserDatabase();
+#endif
 
-  // Check for DMR activity timeout and update OLED display
   unsigned long currentMillis = millis();
 
   // Handle network toggle on separate timer (always 5 seconds)
@@ -810,11 +999,8 @@ void loop() {
     // Determine max cycle value based on connections
     bool hasWifi = wifiConnected;
     bool hasEth = false;
-#ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
-    bool hasEth = false;
 #ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
     hasEth = eth_connected;
-#endif
 #endif
 
     int maxCycle = 1; // Default: 2 states (network + callsign)
@@ -838,44 +1024,76 @@ void loop() {
     bool anyDMRActive = dmrActivity[0].active || dmrActivity[1].active;
     unsigned long oledInterval = anyDMRActive ? OLED_UPDATE_INTERVAL_ACTIVE : OLED_UPDATE_INTERVAL;
 
-    if (currentMillis - lastOLEDUpdate >= oledInterval) {
+    if (oledRefreshPending || currentMillis - lastOLEDUpdate >= oledInterval) {
+      oledRefreshPending = false;
       updateOLEDStatus();
       lastOLEDUpdate = currentMillis;
     }
   }
-  // Reset DMR TX mode if no frames received for 200ms
-  if (dmrTxActive && (currentMillis - lastDMRFrameTime > 200)) {
-    writeDMRStart(false, "");  // Exit TX mode
-    dmrTxActive = false;
+
+  taskMonitor.record(uiTaskId, passStart);
+
+  // Small delay to prevent watchdog issues
+  delay(1);
+}
+
+// DMR core task (DMR_CORE_TASK_CORE, DMR_CORE_TASK_PRIORITY): modem frames, network
+// datagrams, call timers, login and keepalives. Woken by the modem reader and the network
+// socket as soon as they have a frame; the timeout keeps the timers running. The polled
+// network path is not woken by datagrams, so it keeps the short tick.
+void dmrCoreTask(void* arg) {
+  const TickType_t tick = pdMS_TO_TICKS(NETWORK_RX_ASYNC ? DMR_CORE_TICK_MS : DMR_CORE_POLL_TICK_MS);
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, tick);
+    int64_t passStart = esp_timer_get_time();
+    dmrCoreService();  // Takes DMRStateLock only around the dashboard state updates
+    taskMonitor.record(coreTaskId, passStart);
+  }
+}
+
+void dmrCoreService() {
+  // Handle MMDVM serial communication
+  handleMMDVMSerial();
+
+  // Fill in station details from finished background lookups
+  processUserLookups();
+
+  unsigned long currentMillis = millis();
+
+  // Poll modem status (mode, TX state, overflows, free buffer space) like MMDVMHost
+  if (mmdvmReady && (currentMillis - lastStatusPoll >= MMDVM_STATUS_POLL_INTERVAL)) {
+    sendMMDVMCommand(CMD_GET_STATUS);
+    modemStatus.polls++;
+    lastStatusPoll = currentMillis;
   }
 
-  for (int i = 0; i < 2; i++) {
-    // Check if DMR activity has timed out and add to history before deactivating
-    if (dmrActivity[i].active && (currentMillis - dmrActivity[i].lastUpdate > DMR_ACTIVITY_TIMEOUT)) {
-      // Add to history when activity times out (transmission ended)
-      if (dmrActivity[i].srcId > 0) {
-        uint32_t duration = (currentMillis - dmrActivity[i].startTime) / 1000;
-        String location = "";
-        if (dmrActivity[i].srcCity.length() > 0 || dmrActivity[i].srcCountry.length() > 0) {
-          if (dmrActivity[i].srcCity.length() > 0) location += dmrActivity[i].srcCity;
-          if (dmrActivity[i].srcCity.length() > 0 && dmrActivity[i].srcCountry.length() > 0) location += ", ";
-          if (dmrActivity[i].srcCountry.length() > 0) location += dmrActivity[i].srcCountry;
-        }
-        addDMRHistory(dmrActivity[i].srcId, dmrActivity[i].srcCallsign, dmrActivity[i].srcName, location,
-                     dmrActivity[i].dstId, dmrActivity[i].isGroup, duration, 0, 0, dmrActivity[i].slotNo);
-      }
-      dmrActivity[i].active = false;
+  // A slot goes idle once its queue has drained. After TERM_LC that is one frame after the
+  // terminator was played; otherwise (terminator lost) after 200ms without frames.
+  for (uint8_t slotNo = 1; slotNo <= 2; slotNo++) {
+    DMRSlotTx &stx = slotTx[slotNo - 1];
+    if (stx.state == SLOT_TX::IDLE || !modemTxQueue.isEmpty(slotNo)) {
+      continue;
     }
-    
-    // Also check transmission timeout and log the end
-    if (currentTx[i].active && (currentMillis - dmrActivity[i].lastUpdate > DMR_ACTIVITY_TIMEOUT)) {
-      if (currentTx[i].lastSeq > currentTx[i].startSeq) {
-        String txSummary = "[SERVER] DMR: Slot" + String(currentTx[i].slotNo) + " Seq=" + String(currentTx[i].startSeq) + "-" + String(currentTx[i].lastSeq) + 
-                          " " + String(currentTx[i].srcId) + "->" + (currentTx[i].isGroup ? "TG" : "") + String(currentTx[i].dstId) +
-                          " [END]";
-        logSerial(txSummary);
-      }
-      currentTx[i].active = false;
+    unsigned long sincePlayout = currentMillis - modemTxQueue.lastPlayout(slotNo);
+    bool terminated = (stx.state == SLOT_TX::ENDING) && (sincePlayout >= 60);
+    bool stalled = (currentMillis - stx.lastFrameTime > 200) && (sincePlayout > 200);
+    if (terminated || stalled) {
+      endSlotTx(slotNo);
+    }
+  }
+
+  // RF calls that stopped without a terminator or lost carrier report
+  uint8_t rfEnded = dmrUplink.expire(currentMillis);
+  for (uint8_t slotNo = 1; slotNo <= 2; slotNo++) {
+    if (rfEnded & (1 << (slotNo - 1))) {
+      endRFCall(slotNo, "TIMEOUT");
+    }
+  }
+
+  // Calls whose terminator never arrived
+  for (int i = 0; i < 2; i++) {
+    if (currentTx[i].active && (currentMillis - currentTx[i].lastTime > DMR_ACTIVITY_TIMEOUT)) {
+      endDMRTransmission(i, "TIMEOUT");
     }
   }
 
@@ -883,45 +1101,34 @@ void loop() {
   if (wifiConnected) {
     handleNetwork();
 
-    // Check for DMR login timeout and retry if needed
-    if (mode_dmr_enabled && !dmrLoggedIn && wifiConnected) {
+    // Login step without an answer: try again after the backoff
+    if (mode_dmr_enabled && !dmrLoggedIn) {
       if (dmrState == DMR_STATE::WAITING_LOGIN ||
           dmrState == DMR_STATE::WAITING_AUTH ||
           dmrState == DMR_STATE::WAITING_CONFIG) {
-
         if (currentMillis - lastLoginAttempt >= DMR_LOGIN_TIMEOUT) {
-          if (loginAttempts < DMR_LOGIN_MAX_RETRIES) {
-            loginAttempts++;
-            logSerial("DMR login timeout - retrying (" + String(loginAttempts) + "/" + String(DMR_LOGIN_MAX_RETRIES) + ")");
-            dmrLoginStatus = "Retrying... (" + String(loginAttempts) + "/" + String(DMR_LOGIN_MAX_RETRIES) + ")";
-            connectToDMRNetwork();
-            lastLoginAttempt = currentMillis;
-            if (enable_oled) {
-              updateOLEDStatus(); // Update display to show retry status
-            }
-          } else {
-            logSerial("DMR login failed after " + String(DMR_LOGIN_MAX_RETRIES) + " attempts");
-            dmrLoginStatus = "Login Failed";
-            dmrState = DMR_STATE::DISCONNECTED;
-            if (enable_oled) {
-              updateOLEDStatus(); // Update display to show failure
-            }
-          }
+          dropDMRSession(DMR_SESSION_EVENT::LOGIN_TIMEOUT);
         }
+      } else if (dmrState == DMR_STATE::DISCONNECTED && dmrSession.retryDue(currentMillis)) {
+        dmrResolver.refresh();  // Master may have moved
+        connectToDMRNetwork();
+        oledRefreshPending = true;  // Show the retry status
       }
     }
 
     // Send keepalive packets only if DMR mode is enabled and connected
     if (mode_dmr_enabled && dmrLoggedIn) {
       if (currentMillis - lastKeepalive >= NETWORK_KEEPALIVE_INTERVAL) {
-        sendDMRKeepalive();
         lastKeepalive = currentMillis;
+        if (dmrSession.ping(currentMillis)) {
+          sendDMRKeepalive();
+        } else {
+          dropDMRSession(DMR_SESSION_EVENT::PONG_TIMEOUT);
+        }
       }
     }
   }
 
-  // Small delay to prevent watchdog issues
-  delay(1);
 }
 
 void setupWiFi() {
@@ -959,7 +1166,7 @@ void setupWiFi() {
     logSerial("IP Address: " + WiFi.localIP().toString());
 
     // Start UDP
-    udp.begin(LOCAL_PORT);
+    dmrSocket.begin(LOCAL_PORT);
   } else {
     logSerial("\nWiFi Connection Failed!");
 
@@ -987,7 +1194,7 @@ void setupWiFi() {
 #endif
           logSerial("\nWiFi Connected [" + wifiNetworks[i].label + "]!");
           logSerial("IP Address: " + WiFi.localIP().toString());
-          udp.begin(LOCAL_PORT);
+          dmrSocket.begin(LOCAL_PORT);
           return;
         }
       }
@@ -1042,7 +1249,7 @@ void WiFiEvent(arduino_event_id_t event) {
 #endif
 
       // Start UDP for DMR network
-      udp.begin(LOCAL_PORT);
+      dmrSocket.begin(LOCAL_PORT);
       logSerial("UDP started on port " + String(LOCAL_PORT));
       break;
     case ARDUINO_EVENT_ETH_DISCONNECTED:
@@ -1134,6 +1341,7 @@ void setupMMDVM() {
 
         if (wakeRxPtr >= frameLength) {
           if (wakeRxPtr >= 3 && wakeRxBuffer[2] == CMD_GET_VERSION && wakeRxPtr > 4) {
+            modemProtocolVersion = wakeRxBuffer[3];
             modemFirmwareVersion = ""; // Clear existing version
             for (int j = 4; j < wakeRxPtr && wakeRxBuffer[j] != 0x00; j++) {
               if (wakeRxBuffer[j] >= 32 && wakeRxBuffer[j] < 127) {
@@ -1165,7 +1373,7 @@ void setupMMDVM() {
   // If we didn't get version from wakeup, try main UART
   if (!versionFromWakeup) {
     logSerial("Requesting modem firmware version on main UART...");
-    sendMMDVMCommand(CMD_GET_VERSION, NULL, 0);
+    sendMMDVMCommand(CMD_GET_VERSION);
     MMDVM_SERIAL.flush();
 
     // Wait for version response
@@ -1190,6 +1398,7 @@ void setupMMDVM() {
           if (tempRxPtr >= frameLength) {
             // Check if this is a version response
             if (tempRxPtr >= 3 && tempRxBuffer[2] == CMD_GET_VERSION) {
+              if (tempRxPtr > 3) modemProtocolVersion = tempRxBuffer[3];
               modemFirmwareVersion = ""; // Clear existing version
               for (int i = 4; i < tempRxPtr && tempRxBuffer[i] != 0x00; i++) {
                 if (tempRxBuffer[i] >= 32 && tempRxBuffer[i] < 127) {
@@ -1223,11 +1432,12 @@ void setupMMDVM() {
   delay(100);
 
   // Set configuration (must be at least 23 bytes per firmware)
-  uint8_t config[23];
-  memset(config, 0, sizeof(config));
+  uint8_t frame[MMDVM_FRAME_HEADROOM + 23];
+  uint8_t* config = &frame[MMDVM_FRAME_HEADROOM];  // Payload, built in place behind the header
+  memset(config, 0, 23);
 
   // Byte 0: Flags (bit 7=simplex, bit 4=debug, bit 3=YSF low dev)
-  config[0] = 0x80;  // Simplex mode
+  config[0] = MMDVM_DUPLEX ? 0x00 : 0x80;  // Simplex, or duplex (both timeslots)
 
   // Byte 1: Mode enables (bitfield)
   uint8_t modeEnables = 0x00;
@@ -1286,7 +1496,7 @@ void setupMMDVM() {
   logSerial("Config byte[1] (mode enables): 0x" + String(modeEnables, HEX) +
             " byte[3] (state): 0x" + String(modemState, HEX));
   logSerial("Setting modem configuration (Mode: " + modeStr + ", Color Code: " + String(dmr_color_code) + ")...");
-  sendMMDVMCommand(CMD_SET_CONFIG, config, 23);
+  sendMMDVMFrame(frame, CMD_SET_CONFIG, 23);
   delay(200);  // Give modem time to configure and set mode
 
   // Note: Mode is set within CMD_SET_CONFIG (byte 3), no need for separate CMD_SET_MODE
@@ -1294,7 +1504,7 @@ void setupMMDVM() {
 
   // Only mark modem as ready if we successfully received firmware version
   if (modemFirmwareVersion != "Unknown" && modemFirmwareVersion.length() > 0) {
-    logSerial("MMDVM Initialized - Modem Ready");
+    logSerial("MMDVM Initialized - Modem Ready (protocol v" + String(modemProtocolVersion) + ")");
     mmdvmReady = true;
   } else {
     logSerial("MMDVM Initialized - WARNING: No modem firmware version detected!");
@@ -1302,17 +1512,17 @@ void setupMMDVM() {
   }
 }
 
-void sendMMDVMCommand(uint8_t cmd, uint8_t* data, uint16_t length) {
-  uint8_t buffer[512];
-  buffer[0] = MMDVM_FRAME_START;
-  buffer[1] = length + 3;  // Length includes START, LEN, and CMD
-  buffer[2] = cmd;
-
-  if (data != NULL && length > 0) {
-    memcpy(&buffer[3], data, length);
-  }
+// Write one command to the modem in a single UART write (so it can't interleave with
+// the TX queue's frames). The payload (length bytes) is already at
+// frame[MMDVM_FRAME_HEADROOM]; the header is built in front of it.
+void sendMMDVMFrame(uint8_t* frame, uint8_t cmd, uint8_t length) {
+  MMDVM_SERIAL.write(frame, mmdvmFrameBuild(frame, cmd, length));
+}
 
-  MMDVM_SERIAL.write(buffer, length + 3);
+// Command without payload
+void sendMMDVMCommand(uint8_t cmd) {
+  uint8_t frame[MMDVM_FRAME_HEADROOM];
+  sendMMDVMFrame(frame, cmd, 0);
 }
 
 void sendFrequency(uint32_t rxFreq, uint32_t txFreq, uint8_t rfPower) {
@@ -1322,7 +1532,8 @@ void sendFrequency(uint32_t rxFreq, uint32_t txFreq, uint8_t rfPower) {
   // data[5-8]:  TX frequency in Hz (little-endian)
   // data[9]:    RF power level (0-255)
   // data[10-13]: POCSAG TX frequency in Hz (little-endian)
-  uint8_t freqData[14];
+  uint8_t frame[MMDVM_FRAME_HEADROOM + 14];
+  uint8_t* freqData = &frame[MMDVM_FRAME_HEADROOM];
 
   // Byte 0: Mode/flags (unused, set to 0)
   freqData[0] = 0x00;
@@ -1348,7 +1559,7 @@ void sendFrequency(uint32_t rxFreq, uint32_t txFreq, uint8_t rfPower) {
   freqData[12] = (txFreq >> 16) & 0xFF;
   freqData[13] = (txFreq >> 24) & 0xFF;
 
-  sendMMDVMCommand(CMD_SET_FREQ, freqData, 14);
+  sendMMDVMFrame(frame, CMD_SET_FREQ, 14);
 
   logSerial("Frequency set - RX: " + String(rxFreq) + " Hz, TX: " + String(txFreq) + " Hz, Power: " + String(rfPower));
 }
@@ -1372,45 +1583,78 @@ void writeDMRStart(bool tx, String callsign) {
   logSerial(logMsg);
 }
 
-void handleMMDVMSerial() {
-  while (MMDVM_SERIAL.available()) {
-    uint8_t byte = MMDVM_SERIAL.read();
-
-    if (rxBufferPtr == 0 && byte != MMDVM_FRAME_START) {
-      continue;  // Wait for frame start
-    }
-
-    rxBuffer[rxBufferPtr++] = byte;
-
-    // Check if we have enough bytes to read length
-    if (rxBufferPtr >= 2) {
-      uint8_t frameLength = rxBuffer[1];
+// A slot starts carrying network traffic. The modem enters TX with the first busy slot;
+// in duplex the short LC (CACH) announces the call on the slot.
+void startSlotTx(uint8_t slotNo, uint32_t dstId, bool isGroup, const char* callsign) {
+  DMRSlotTx &stx = slotTx[slotNo - 1];
+  stx.state = SLOT_TX::ACTIVE;
+  stx.dstId = dstId;
+  stx.isGroup = isGroup;
+  if (MMDVM_DUPLEX) {
+    sendDMRShortLC();
+  }
+  if (!dmrTxActive) {
+    writeDMRStart(true, callsign);
+    dmrTxActive = true;
+  }
+}
 
-      // Check if we have a complete frame
-      if (rxBufferPtr >= frameLength) {
-        processMMDVMFrame();
-        rxBufferPtr = 0;
-      }
-    }
+// A slot has played out; the modem leaves TX when no slot is busy any more
+void endSlotTx(uint8_t slotNo) {
+  slotTx[slotNo - 1].state = SLOT_TX::IDLE;
+  if (MMDVM_DUPLEX) {
+    sendDMRShortLC();
+  }
+  if (dmrTxActive && slotTx[0].state == SLOT_TX::IDLE && slotTx[1].state == SLOT_TX::IDLE) {
+    writeDMRStart(false, "");  // Exit TX mode
+    dmrTxActive = false;
+#if ENABLE_RGB_LED
+    rgbLed.setStatus(RGBLedStatus::IDLE_CONNECTED);
+#endif
+  }
+}
 
-    // Prevent buffer overflow
-    if (rxBufferPtr >= sizeof(rxBuffer)) {
-      rxBufferPtr = 0;
+// Activity update short LC for the CACH (as MMDVMHost's CDMRSlot::setShortLC): per slot the
+// activity (group / private voice) and an 8-bit hash (CRC-8) of the destination ID
+void sendDMRShortLC() {
+  uint8_t lc[5] = { 0x01, 0x00, 0x00, 0x00, 0x00 };  // SLCO 1: activity update
+  for (uint8_t s = 0; s < 2; s++) {
+    const DMRSlotTx &stx = slotTx[s];
+    if (stx.state == SLOT_TX::IDLE || stx.dstId == 0) {
+      continue;
     }
+    uint8_t id[3] = { (uint8_t)(stx.dstId >> 16), (uint8_t)(stx.dstId >> 8), (uint8_t)stx.dstId };
+    uint8_t activity = stx.isGroup ? 0x08 : 0x09;
+    lc[1] |= (s == 0) ? (uint8_t)(activity << 4) : activity;
+    lc[2 + s] = dmrCRC8(id, 3);
   }
+  lc[4] = dmrCRC8(lc, 4);
+
+  uint8_t frame[MMDVM_FRAME_HEADROOM + 9];
+  dmrShortLCEncode(lc, &frame[MMDVM_FRAME_HEADROOM]);
+  sendMMDVMFrame(frame, CMD_DMR_SHORTLC, 9);
 }
 
-void processMMDVMFrame() {
-  if (rxBufferPtr < 3) return;
+// Dispatch frames assembled by the MMDVM reader task
+void handleMMDVMSerial() {
+  const MMDVMFrameView* frame;
+  while ((frame = modemReader.next()) != NULL) {
+    processMMDVMFrame(*frame);
+    modemReader.release(frame);
+  }
+}
 
-  uint8_t cmd = rxBuffer[2];
+void processMMDVMFrame(const MMDVMFrameView &frame) {
+  uint8_t cmd = frame.command();
+  const uint8_t* payload = frame.payload();
+  uint16_t length = frame.payloadLength();
 
   switch (cmd) {
     case CMD_GET_VERSION:
       {
         String version = "MMDVM Version: ";
-        for (int i = 3; i < rxBufferPtr; i++) {
-          version += (char)rxBuffer[i];
+        for (int i = 0; i < length; i++) {
+          version += (char)payload[i];
         }
         logSerial(version);
       }
@@ -1418,8 +1662,28 @@ void processMMDVMFrame() {
 
     case CMD_GET_STATUS:
       {
-        String status = "MMDVM Status - Mode: " + String(rxBuffer[3]) + " TX: " + String(rxBuffer[4]) + " Overflow: " + String(rxBuffer[7]);
-        logSerial(status);
+        uint8_t lastMode = modemStatus.mode;
+        bool lastTx = modemStatus.tx;
+        bool wasValid = modemStatus.valid;
+        if (!parseMMDVMStatus(payload, length, modemProtocolVersion, modemStatus)) {
+          logSerial("MMDVM Status - short reply (" + String(frame.length) + " bytes)");
+          break;
+        }
+
+        // Free DMR buffer space drives the TX queue playout
+        if (mode_dmr_enabled) {
+          modemTxQueue.setModemSpace(modemStatus.dmrSpace1, modemStatus.dmrSpace2, MMDVM_DUPLEX);  // Simplex: dmrSpace2 is the DMO buffer
+        }
+
+        if (!wasValid || modemStatus.mode != lastMode || modemStatus.tx != lastTx) {
+          logSerialVerbose("MMDVM Status - Mode: " + String(getMMDVMModeName(modemStatus.mode)) +
+                           " TX: " + String(modemStatus.tx ? "ON" : "OFF") +
+                           " DMR space: " + String(modemStatus.dmrSpace1) + "/" + String(modemStatus.dmrSpace2));
+        }
+        if (modemStatus.rxOverflow || modemStatus.txOverflow || modemStatus.adcOverflow || modemStatus.dacOverflow) {
+          logSerial("MMDVM Status - Overflow:" + String(modemStatus.rxOverflow ? " RX" : "") + String(modemStatus.txOverflow ? " TX" : "") +
+                    String(modemStatus.adcOverflow ? " ADC" : "") + String(modemStatus.dacOverflow ? " DAC" : ""));
+        }
       }
       break;
 
@@ -1431,9 +1695,9 @@ void processMMDVMFrame() {
     case CMD_NAK:
       // Modem rejected a command
       // NAK format: [START] [LEN] [NAK=0x7F] [CMD_REJECTED] [ERROR_CODE]
-      if (rxBufferPtr >= 5) {
-        uint8_t rejectedCmd = rxBuffer[3];
-        uint8_t reason = rxBuffer[4];
+      if (length >= 2) {
+        uint8_t rejectedCmd = payload[0];
+        uint8_t reason = payload[1];
         String cmdStr;
         switch (rejectedCmd) {
           case CMD_GET_VERSION: cmdStr = "GET_VERSION"; break;
@@ -1451,19 +1715,19 @@ void processMMDVMFrame() {
           case 2: reasonStr = "Wrong Mode"; break;
           case 3: reasonStr = "Command Too Long"; break;
           case 4: reasonStr = "Data Incorrect"; break;
-          case 5: reasonStr = "Not Enough Buffer Space"; break;
+          case 5: reasonStr = "Not Enough Buffer Space"; modemStatus.nakNoSpace++; break;
           default: reasonStr = "Unknown (" + String(reason) + ")"; break;
         }
         logSerial("MMDVM NAK - Command: " + cmdStr + ", Reason: " + reasonStr);
-      } else if (rxBufferPtr >= 4) {
-        uint8_t reason = rxBuffer[3];
+      } else if (length >= 1) {
+        uint8_t reason = payload[0];
         String reasonStr;
         switch (reason) {
           case 1: reasonStr = "Invalid Command"; break;
           case 2: reasonStr = "Wrong Mode"; break;
           case 3: reasonStr = "Command Too Long"; break;
           case 4: reasonStr = "Data Incorrect"; break;
-          case 5: reasonStr = "Not Enough Buffer Space"; break;
+          case 5: reasonStr = "Not Enough Buffer Space"; modemStatus.nakNoSpace++; break;
           default: reasonStr = "Unknown (" + String(reason) + ")"; break;
         }
         logSerial("MMDVM NAK - Reason: " + reasonStr);
@@ -1474,24 +1738,41 @@ void processMMDVMFrame() {
 
     case CMD_DMR_DATA1:
     case CMD_DMR_DATA2:
-      // DMR data received from MMDVM - forward to network (TRANSMITTING)
-      if (wifiConnected) {
-        // Extract DMR frame and send to network
-        uint16_t dataLen = rxBufferPtr - 3;
-        udp.beginPacket(dmr_server.c_str(), dmr_port);
-        udp.write(&rxBuffer[3], dataLen);
-        udp.endPacket();
-
-        logSerial("DMR data forwarded to network");
-        digitalWrite(COS_LED_PIN, HIGH);
-#if ENABLE_RGB_LED
-        rgbLed.setStatus(RGBLedStatus::TRANSMITTING);
-#endif
-        delay(50);
-        digitalWrite(COS_LED_PIN, LOW);
+      // DMR burst received over RF - encode as DMRD and forward to network (TRANSMITTING)
+      {
+        uint8_t slotNo = (cmd == CMD_DMR_DATA1) ? 1 : 2;
+        bool endedCall = false;
+        dmrUplink.setRepeaterId(dmr_essid > 0 ? dmr_id * 100 + dmr_essid : dmr_id);
+        if (!dmrUplink.encode(slotNo, payload, length, millis(), dmrUplinkPacket, endedCall)) {
+          break;
+        }
+
+        const DMRUplinkCall &call = dmrUplink.getCall(slotNo);
+        if (call.packets == 1) {
+          logSerial("[RF] DMR: Slot" + String(slotNo) + " " + String(call.srcId) + "->" + (call.privateCall ? "" : "TG") +
+                    String(call.dstId) + " [START" + (call.lateEntry ? " LATE ENTRY" : "") + "] Stream=" + String(call.streamId, HEX));
+          digitalWrite(COS_LED_PIN, HIGH);
 #if ENABLE_RGB_LED
-        rgbLed.setStatus(RGBLedStatus::IDLE_CONNECTED);
+          rgbLed.setStatus(RGBLedStatus::TRANSMITTING);
 #endif
+        }
+
+        if (wifiConnected && dmrLoggedIn) {
+          bool sent = sendToMaster(dmrUplinkPacket, DMRD_PACKET_LENGTH);
+          dmrUplink.recordSend(sent, (uint32_t)(esp_timer_get_time() - frame.timestamp));
+        }
+
+        if (endedCall) {
+          endRFCall(slotNo, "TERM_LC");
+        }
+      }
+      break;
+
+    case CMD_DMR_LOST1:
+    case CMD_DMR_LOST2:
+      // Carrier lost on RF without a terminator
+      if (dmrUplink.lost((cmd == CMD_DMR_LOST1) ? 1 : 2)) {
+        endRFCall((cmd == CMD_DMR_LOST1) ? 1 : 2, "LOST");
       }
       break;
 
@@ -1501,347 +1782,477 @@ void processMMDVMFrame() {
   }
 }
 
+// Log the end of an RF call and release the COS / RGB indication once no slot is receiving
+void endRFCall(uint8_t slotNo, const char* reason) {
+  const DMRUplinkCall &call = dmrUplink.getCall(slotNo);
+  logSerial("[RF] DMR: Slot" + String(slotNo) + " " + String(call.srcId) + "->" + (call.privateCall ? "" : "TG") +
+            String(call.dstId) + " [END " + String(reason) + "] " + String(call.packets) + " frames, " +
+            String(call.lastMs - call.startMs) + " ms");
+  if (!dmrUplink.isActive()) {
+    digitalWrite(COS_LED_PIN, LOW);
+#if ENABLE_RGB_LED
+    rgbLed.setStatus(RGBLedStatus::IDLE_CONNECTED);
+#endif
+  }
+}
+
+// Dispatch the datagrams received since the last pass, up to UDP_DRAIN_MAX_PACKETS
+// or UDP_DRAIN_BUDGET_US, so a burst from the master is not spread over several core task
+// passes. Whatever is left over is picked up on the next pass, which runs straight away.
 void handleNetwork() {
-  int packetSize = udp.parsePacket();
-  if (packetSize) {
-    uint8_t packet[512];
-    int len = udp.read(packet, sizeof(packet));
-
-    if (len > 0) {
-      // Check if this is a keepalive packet first (for conditional logging)
-      bool isKeepalive = (memcmp(packet, "MSTPONG", 7) == 0 && len >= 7);
-      bool isDMRData = (memcmp(packet, "DMRD", 4) == 0 && len >= 55);
-
-      // Only log hex dump for non-DMR data packets (DMR gets decoded below)
-      if (!isDMRData) {
-        String hexDump = "RX [" + String(len) + "]: ";
-        for (int i = 0; i < min(len, 16); i++) {
-          if (packet[i] < 0x10) hexDump += "0";
-          hexDump += String(packet[i], HEX);
-          hexDump += " ";
-        }
+  unsigned long startUs = micros();
+  uint16_t drained = 0;
+  bool budgetHit = false;
+  dmrSocket.poll();  // Polled receive only (NETWORK_RX_ASYNC false)
+  uint16_t pending = dmrSocket.pending();
+  NetworkFrame* frame;
+  while ((frame = dmrSocket.next()) != NULL) {
+    processNetworkPacket(frame->data, frame->length);
+    dmrSocket.release(frame);
+    drained++;
+    if (drained >= UDP_DRAIN_MAX_PACKETS || (micros() - startUs) >= UDP_DRAIN_BUDGET_US) {
+      budgetHit = (dmrSocket.next() != NULL);  // Only if something is left for the next pass
+      if (budgetHit) xTaskNotifyGive(dmrCoreTaskHandle);  // No new datagram may come to wake it
+      break;
+    }
+  }
+  if (drained > 0) {
+    udpDrainRecord(udpDrainStats, pending, drained, budgetHit, micros() - startUs);
+  }
+}
 
-        // Use verbose logging for keepalive packets (always USB, conditionally web)
-        if (isKeepalive) {
-          logSerialVerbose(hexDump);
-        } else {
-          logSerial(hexDump);
-        }
-      }
+// Handle one datagram from the master
+void processNetworkPacket(uint8_t* packet, int len) {
+  // Check if this is a keepalive packet first (for conditional logging)
+  bool isKeepalive = (memcmp(packet, "MSTPONG", 7) == 0 && len >= 7);
+  bool isDMRData = DmrdView::valid(packet, len);
+
+  // Only log hex dump for non-DMR data packets (DMR gets decoded below)
+  if (!isDMRData) {
+    String hexDump = "RX [" + String(len) + "]: ";
+    for (int i = 0; i < min(len, 16); i++) {
+      if (packet[i] < 0x10) hexDump += "0";
+      hexDump += String(packet[i], HEX);
+      hexDump += " ";
+    }
 
-      // Check for BrandMeister responses (binary comparison)
-      if (len >= 4) {
-        // Check for negative acknowledgment (MSTNAK)
-        if (memcmp(packet, "MSTNAK", 6) == 0 && len >= 6) {
-          dmrLoggedIn = false;
-          dmrLoginStatus = "Login Failed";
-
-          // Log which stage failed
-          String stageMsg = "BrandMeister NAK at stage: ";
-          switch (dmrState) {
-            case DMR_STATE::WAITING_LOGIN: stageMsg += "LOGIN"; break;
-            case DMR_STATE::WAITING_AUTH: stageMsg += "AUTH"; break;
-            case DMR_STATE::WAITING_CONFIG: stageMsg += "CONFIG"; break;
-            default: stageMsg += "UNKNOWN";
-          }
-          logSerial(stageMsg);
-          logSerial("STOPPING - Please check configuration and reboot");
+    // Use verbose logging for keepalive packets (always USB, conditionally web)
+    if (isKeepalive) {
+      logSerialVerbose(hexDump);
+    } else {
+      logSerial(hexDump);
+    }
+  }
 
-          // Stop trying to prevent ban
-          dmrState = DMR_STATE::DISCONNECTED;
-        }
-        // Check for login acknowledgment (RPTACK)
-        else if (memcmp(packet, "RPTACK", 6) == 0 && len >= 10) {
-          // RPTACK response includes salt for password authentication
-          memcpy(dmrSalt, packet + 6, 4);
-
-          // Debug: Show salt
-          String saltHex = "Salt: ";
-          for (int i = 0; i < 4; i++) {
-            if (dmrSalt[i] < 0x10) saltHex += "0";
-            saltHex += String(dmrSalt[i], HEX);
-          }
-          logSerial(saltHex);
-
-          switch (dmrState) {
-            case DMR_STATE::WAITING_LOGIN:
-              logSerial("Login ACK received (state: WAITING_LOGIN), sending auth...");
-              dmrState = DMR_STATE::WAITING_AUTH;
-              sendDMRAuth();
-              break;
-            case DMR_STATE::WAITING_AUTH:
-              logSerial("Auth ACK received (state: WAITING_AUTH), sending config...");
-              dmrState = DMR_STATE::WAITING_CONFIG;
-              sendDMRConfig();
-              break;
-            case DMR_STATE::WAITING_CONFIG:
-              logSerial("Config ACK - CONNECTED!");
-              dmrLoggedIn = true;
-              dmrLoginStatus = "Connected";
-              dmrState = DMR_STATE::CONNECTED;
-              loginAttempts = 0; // Reset retry counter on successful login
-              logSerial("DMR Network fully connected and operational!");
-
-              // Force immediate OLED update to show connected status
-              if (enable_oled) {
-                updateOLEDStatus();
-                lastOLEDUpdate = millis(); // Reset timer
-              }
-              break;
-            case DMR_STATE::DISCONNECTED:
-              // Don't retry after NAK to prevent bans
-              logSerial("RPTACK received but in DISCONNECTED state - ignoring");
-              break;
-            default:
-              logSerial("RPTACK received in unexpected state: " + String((int)dmrState));
-              break;
+  // Check for BrandMeister responses (binary comparison)
+  if (len >= 4) {
+    // Check for negative acknowledgment (MSTNAK)
+    if (memcmp(packet, "MSTNAK", 6) == 0 && len >= 6) {
+      // Log which stage failed
+      String stageMsg = "BrandMeister NAK at stage: ";
+      switch (dmrState) {
+        case DMR_STATE::WAITING_LOGIN: stageMsg += "LOGIN"; break;
+        case DMR_STATE::WAITING_AUTH: stageMsg += "AUTH"; break;
+        case DMR_STATE::WAITING_CONFIG: stageMsg += "CONFIG"; break;
+        case DMR_STATE::CONNECTED: stageMsg += "CONNECTED (session unknown to master)"; break;
+        default: stageMsg += "UNKNOWN";
+      }
+      logSerial(stageMsg);
+      if (dmrState == DMR_STATE::WAITING_AUTH) {
+        logSerial("Password refused - please check configuration");
+      }
+
+      // Log in again later; a refused password waits the longest backoff to prevent a ban
+      if (dmrState != DMR_STATE::DISCONNECTED) {
+        dropDMRSession(DMR_SESSION_EVENT::MASTER_NAK);
+      }
+    }
+    // Master closing the session (MSTCL)
+    else if (memcmp(packet, "MSTCL", 5) == 0 && len >= 5) {
+      if (dmrState != DMR_STATE::DISCONNECTED) {
+        dropDMRSession(DMR_SESSION_EVENT::MASTER_CLOSE);
+      }
+    }
+    // Check for login acknowledgment (RPTACK)
+    else if (memcmp(packet, "RPTACK", 6) == 0 && len >= 10) {
+      // RPTACK response includes salt for password authentication
+      memcpy(dmrSalt, packet + 6, 4);
+
+      // Debug: Show salt
+      String saltHex = "Salt: ";
+      for (int i = 0; i < 4; i++) {
+        if (dmrSalt[i] < 0x10) saltHex += "0";
+        saltHex += String(dmrSalt[i], HEX);
+      }
+      logSerial(saltHex);
+
+      switch (dmrState) {
+        case DMR_STATE::WAITING_LOGIN:
+          logSerial("Login ACK received (state: WAITING_LOGIN), sending auth...");
+          dmrState = DMR_STATE::WAITING_AUTH;
+          sendDMRAuth();
+          break;
+        case DMR_STATE::WAITING_AUTH:
+          logSerial("Auth ACK received (state: WAITING_AUTH), sending config...");
+          dmrState = DMR_STATE::WAITING_CONFIG;
+          sendDMRConfig();
+          break;
+        case DMR_STATE::WAITING_CONFIG:
+          logSerial("Config ACK - CONNECTED!");
+          dmrLoggedIn = true;
+          {
+            DMRStateLock lock;
+            dmrLoginStatus = "Connected";
           }
-        }
-        // Check for ping response (MSTPONG)
-        else if (memcmp(packet, "MSTPONG", 7) == 0 && len >= 7) {
-          logSerialVerbose("Keepalive ACK");
-        }
-        // DMR data packet
-        else if (memcmp(packet, "DMRD", 4) == 0 && len >= 55) {
-          // Parse DMR packet structure
-          uint8_t seqNo = packet[4];
-          uint32_t srcId = (packet[5] << 16) | (packet[6] << 8) | packet[7];
-          uint32_t dstId = (packet[8] << 16) | (packet[9] << 8) | packet[10];
-          uint32_t rptId = (packet[11] << 24) | (packet[12] << 16) | (packet[13] << 8) | packet[14];
-          
-          uint8_t controlByte = packet[15];
-          uint8_t slotNo = (controlByte & 0x80) ? 2 : 1;
-          bool isGroup = (controlByte & 0x40) == 0;  // 0=Group, 1=Private
-          bool dataSync = (controlByte & 0x20) != 0;
-          bool voiceSync = (controlByte & 0x10) != 0;
-          uint8_t dataType = controlByte & 0x0F;
-          
-          uint8_t ber = packet[53];
-          uint8_t rssi = packet[54];
-          
-          // Data type names
-          const char* dataTypeStr = "UNKNOWN";
-          switch (dataType) {
-            case 0x00: dataTypeStr = "PI_HEADER"; break;
-            case 0x01: dataTypeStr = "VOICE_LC_HDR"; break;
-            case 0x02: dataTypeStr = "TERM_LC"; break;
-            case 0x03: dataTypeStr = "CSBK"; break;
-            case 0x06: dataTypeStr = "DATA_HDR"; break;
-            case 0x07: dataTypeStr = "RATE_1/2_DATA"; break;
-            case 0x08: dataTypeStr = "RATE_3/4_DATA"; break;
-            case 0x09: dataTypeStr = "IDLE"; break;
-            case 0x0A: dataTypeStr = "RATE_1_DATA"; break;
+          dmrState = DMR_STATE::CONNECTED;
+          lastKeepalive = millis();
+          logSerial("DMR Network fully connected and operational!");
+          {
+            uint32_t recoverMs;
+            if (dmrSession.connected(millis(), recoverMs)) {
+              logSerial("DMR session recovered after " + String(recoverMs / 1000.0, 1) + " s");
+            }
           }
-          
-          // If it's a voice frame (no specific data type flag), show as VOICE
-          if (!dataSync && voiceSync) {
-            dataTypeStr = "VOICE";
-          } else if (!dataSync && !voiceSync) {
-            dataTypeStr = "VOICE_BURST";
+
+          // Redraw the OLED straight away to show connected status
+          oledRefreshPending = true;
+          break;
+        case DMR_STATE::DISCONNECTED:
+          // Late answer to an abandoned attempt: the next one runs on the backoff schedule
+          logSerial("RPTACK received but in DISCONNECTED state - ignoring");
+          break;
+        default:
+          logSerial("RPTACK received in unexpected state: " + String((int)dmrState));
+          break;
+      }
+    }
+    // Check for ping response (MSTPONG)
+    else if (memcmp(packet, "MSTPONG", 7) == 0 && len >= 7) {
+      dmrSession.pong(millis());
+      logSerialVerbose("Keepalive ACK");
+    }
+    // DMR data packet
+    else if (DmrdView::valid(packet, len)) {
+      // Fields are read from the receive buffer in place
+      DmrdView dmrd(packet);
+      uint8_t seqNo = dmrd.seq();
+      uint32_t srcId = dmrd.srcId();
+      uint32_t dstId = dmrd.dstId();
+
+      uint8_t controlByte = dmrd.flags();
+      uint8_t slotNo = dmrd.slotNo();
+      bool isGroup = dmrd.isGroup();
+      bool dataSync = dmrd.dataSync();
+      bool voiceSync = dmrd.voiceSync();
+      uint8_t dataType = dmrd.dataType();
+
+      uint8_t ber = dmrd.ber();
+      uint8_t rssi = dmrd.rssi();
+
+      // Frame type as shown on the dashboard (named by the readers)
+      DMR_FRAME_TYPE frameType = dmrdFrameType(controlByte);
+
+      // Check if this is a TERM_LC (transmission end marker)
+      bool isTermLC = dmrdIsTerminator(controlByte);  // Not voice burst C, which has the same low bits
+
+      uint32_t streamId = dmrd.streamId();
+
+      // Calls are tracked by stream ID: a new ID is a new call, even back-to-back with the same src/dst
+      int txIndex = slotNo - 1;
+      DMRTransmission &tx = currentTx[txIndex];
+      DMRActivity &activity = dmrActivity[txIndex];
+      unsigned long now = millis();
+
+      // Late or repeated frames of a call that already ended with TERM_LC
+      bool endedStream = (streamId == tx.endedStreamId) && !(tx.active && tx.streamId == streamId);
+      bool synthesizeHeader = false;
+
+      // Steady frames of a running call allocate nothing; frames that start, end or
+      // identify a call log it and are counted separately
+      uint32_t allocsBefore = allocationCounter.count();
+      bool callEvent = false;
+
+      if (!endedStream) {
+        DMRStateLock lock;  // Call state shown by the dashboard; the modem enqueue below runs unlocked
+        bool isNewTransmission = !tx.active || tx.streamId != streamId;
+        if (isNewTransmission) {
+          if (tx.active) {
+            endDMRTransmission(txIndex, "NEW STREAM");  // Previous call's terminator was lost
           }
-          
-          // Check if this is a TERM_LC (transmission end marker)
-          bool isTermLC = (dataType == 0x02); // TERM_LC
-          
-          // Build readable log message with consolidated transmission tracking
-          int txIndex = slotNo - 1;
-          DMRTransmission &tx = currentTx[txIndex];
-          
-          // Check if this is a new transmission (different source/dest or was inactive)
-          bool isNewTransmission = !tx.active || tx.srcId != srcId || tx.dstId != dstId;
-          
-          // TERM_LC within the same transmission is just a superframe marker, not the actual end
-          // Only end transmission if we haven't seen frames for a while or source/dest changed
-          if (isNewTransmission) {
-            // Log the previous transmission summary if it was active
-            if (tx.active && tx.lastSeq > tx.startSeq) {
-              String txSummary = "[SERVER] DMR: Slot" + String(tx.slotNo) + " Seq=" + String(tx.startSeq) + "-" + String(tx.lastSeq) + 
-                                " " + String(tx.srcId) + "->" + (tx.isGroup ? "TG" : "") + String(tx.dstId) +
-                                " [END]";
-              logSerial(txSummary);
-            }
-            
-            // Start new transmission tracking
-            tx.srcId = srcId;
-            tx.dstId = dstId;
-            tx.slotNo = slotNo;
-            tx.isGroup = isGroup;
-            tx.startSeq = seqNo;
-            tx.lastSeq = seqNo;
-            tx.active = true;
-            tx.frameType = String(dataTypeStr);
-            
-            // Log the start of transmission
-            String dmrInfo = "[SERVER] DMR: Slot" + String(slotNo) + " Seq=" + String(seqNo) + 
-                            " " + String(srcId) + "->" + (isGroup ? "TG" : "") + String(dstId) +
-                            " [START] Type=" + String(dataTypeStr);
-            if (ber > 0 || rssi > 0) {
-              dmrInfo += " BER=" + String(ber) + " RSSI=" + String(rssi);
-            }
-            logSerial(dmrInfo);
-          } else {
-            // Continue existing transmission - just update sequence
-            tx.lastSeq = seqNo;
-            // Update frame type if it changed (VOICE -> VOICE_BURST -> TERM_LC are all part of same transmission)
-            if (tx.frameType != String(dataTypeStr)) {
-              tx.frameType = String(dataTypeStr);
-            }
-            // Don't log individual frames within a transmission
+
+          // Start new transmission tracking
+          tx.srcId = srcId;
+          tx.dstId = dstId;
+          tx.slotNo = slotNo;
+          tx.isGroup = isGroup;
+          tx.startSeq = seqNo;
+          tx.lastSeq = seqNo;
+          tx.active = true;
+          tx.frameType = frameType;
+          tx.streamId = streamId;
+          tx.startTime = now;
+          tx.frames = 0;
+          tx.lateEntry = !(dataSync && dataType == DMR_DT_VOICE_LC_HEADER);
+          synthesizeHeader = !dataSync;  // Starts with a voice burst
+          netEmbeddedLC[txIndex].reset();
+          netTalkerAlias[txIndex].reset();
+          callEvent = true;
+
+          // Log the start of transmission
+          String dmrInfo = "[SERVER] DMR: Slot" + String(slotNo) + " Seq=" + String(seqNo) +
+                          " " + String(srcId) + "->" + (isGroup ? "TG" : "") + String(dstId) +
+                          " [START] Type=" + String(dmrFrameTypeName(frameType)) + " Stream=" + String(streamId, HEX);
+          if (ber > 0 || rssi > 0) {
+            dmrInfo += " BER=" + String(ber) + " RSSI=" + String(rssi);
           }
-          
-          // Update DMR activity tracking
-          int activityIndex = slotNo - 1;  // Slot 1 = index 0, Slot 2 = index 1
-          
-          // Check if we need to add previous transmission to history (DMR ID changed)
-          if (dmrActivity[activityIndex].active && dmrActivity[activityIndex].srcId > 0 && dmrActivity[activityIndex].srcId != srcId) {
-            // Previous transmission ended, add it to history
-            uint32_t duration = (millis() - dmrActivity[activityIndex].startTime) / 1000;
-            String location = "";
-            if (dmrActivity[activityIndex].srcCity.length() > 0 || dmrActivity[activityIndex].srcCountry.length() > 0) {
-              if (dmrActivity[activityIndex].srcCity.length() > 0) location += dmrActivity[activityIndex].srcCity;
-              if (dmrActivity[activityIndex].srcCity.length() > 0 && dmrActivity[activityIndex].srcCountry.length() > 0) location += ", ";
-              if (dmrActivity[activityIndex].srcCountry.length() > 0) location += dmrActivity[activityIndex].srcCountry;
-            }
-            addDMRHistory(dmrActivity[activityIndex].srcId, dmrActivity[activityIndex].srcCallsign, 
-                         dmrActivity[activityIndex].srcName, location, dmrActivity[activityIndex].dstId, 
-                         dmrActivity[activityIndex].isGroup, duration, 0, 0, dmrActivity[activityIndex].slotNo);
+          logSerial(dmrInfo);
+
+          activity.srcId = srcId;
+          activity.dstId = dstId;
+          activity.slotNo = slotNo;
+          activity.isGroup = isGroup;
+          activity.startTime = now;  // Actual transmission start time
+          activity.active = true;
+
+          // Use cached user info; on a miss queue a background lookup (filled in by processUserLookups)
+          String userInfo = getCachedUserInfo(srcId);
+          if (userInfo.length() == 0) {
+            userLookup.request(srcId);
           }
-          
-          // Only set start time and lookup user info if this is a new transmission (not just another frame)
-          if (!dmrActivity[activityIndex].active || 
-              dmrActivity[activityIndex].srcId != srcId || 
-              dmrActivity[activityIndex].dstId != dstId) {
-            dmrActivity[activityIndex].startTime = millis();   // Actual transmission start time
-            dmrActivity[activityIndex].lastUpdate = millis();  // Keep for timeout detection
-            
-            // Lookup detailed user information (async, will use cache if available)
-            String userInfo = lookupUserInfo(srcId);
-            // userInfo format: "callsign|name|city|country" or just "callsign" for basic lookup
-            int pipe1 = userInfo.indexOf('|');
-            if (pipe1 > 0) {
-              dmrActivity[activityIndex].srcCallsign = userInfo.substring(0, pipe1);
-              int pipe2 = userInfo.indexOf('|', pipe1 + 1);
-              if (pipe2 > pipe1) {
-                dmrActivity[activityIndex].srcName = userInfo.substring(pipe1 + 1, pipe2);
-                int pipe3 = userInfo.indexOf('|', pipe2 + 1);
-                if (pipe3 > pipe2) {
-                  dmrActivity[activityIndex].srcCity = userInfo.substring(pipe2 + 1, pipe3);
-                  dmrActivity[activityIndex].srcCountry = userInfo.substring(pipe3 + 1);
-                } else {
-                  dmrActivity[activityIndex].srcCity = userInfo.substring(pipe2 + 1);
-                }
-              } else {
-                dmrActivity[activityIndex].srcName = userInfo.substring(pipe1 + 1);
-              }
-            } else {
-              dmrActivity[activityIndex].srcCallsign = userInfo;
-            }
-            
-            // Log with enhanced info if found
-            if (dmrActivity[activityIndex].srcCallsign.length() > 0 && isNewTransmission) {
-              String logMsg = "[INFO] Station: " + dmrActivity[activityIndex].srcCallsign + " (" + String(srcId) + ")";
-              if (dmrActivity[activityIndex].srcName.length() > 0) {
-                logMsg += " - " + dmrActivity[activityIndex].srcName;
-              }
-              if (dmrActivity[activityIndex].srcCity.length() > 0) {
-                logMsg += " from " + dmrActivity[activityIndex].srcCity;
-                if (dmrActivity[activityIndex].srcCountry.length() > 0) {
-                  logMsg += ", " + dmrActivity[activityIndex].srcCountry;
-                }
-              }
-              logSerial(logMsg);
-            }
-          } else {
-            // Update lastUpdate for timeout detection but keep startTime unchanged
-            dmrActivity[activityIndex].lastUpdate = millis();
+          applyUserInfo(activity, userInfo);
+
+          // Log with enhanced info if found
+          if (activity.srcCallsign[0] != '\0') {
+            logStationInfo(activity, srcId);
           }
-          
-          dmrActivity[activityIndex].srcId = srcId;
-          dmrActivity[activityIndex].dstId = dstId;
-          dmrActivity[activityIndex].slotNo = slotNo;
-          dmrActivity[activityIndex].isGroup = isGroup;
-          dmrActivity[activityIndex].frameType = String(dataTypeStr);
-          dmrActivity[activityIndex].active = true;
-          
-          // Update current talkgroup for quick status
-          if (isGroup) {
-            currentTalkgroup = dstId;
+        } else {
+          // Continue existing transmission - don't log individual frames
+          tx.lastSeq = seqNo;
+          tx.frameType = frameType;
+        }
+        tx.lastTime = now;
+        tx.frames++;
+        activity.lastUpdate = now;
+        activity.frameType = frameType;
+
+        // Embedded LC of voice bursts B-F (four fragments per superframe)
+        if (dataSync) {
+          netEmbeddedLC[txIndex].reset();
+        } else if (!voiceSync) {
+          uint8_t lc[9];
+          if (netEmbeddedLC[txIndex].add(dmrd.payload(), lc) && applyEmbeddedLC(txIndex, lc)) {
+            callEvent = true;
           }
-          
-          // Mark that we've seen TERM_LC for this transmission (but don't add to history yet)
-          // History will be added when the transmission times out and becomes inactive
-
-          // Parse and forward to MMDVM (RECEIVING from network)
-          if (mmdvmReady) {
-            // Extract DMR frame from network packet
-            // BrandMeister DMRD packet structure (55 bytes):
-            //   Bytes 0-3: "DMRD" magic
-            //   Byte 4: Sequence number
-            //   Bytes 5-7: Source ID
-            //   Bytes 8-10: Destination ID
-            //   Bytes 11-14: Repeater ID
-            //   Byte 15: Control flags (slot, group/private, sync flags, data type)
-            //   Bytes 16-19: Stream ID
-            //   Bytes 20-52: DMR frame data (33 bytes) <-- THIS IS WHAT WE NEED
-            //   Byte 53: BER
-            //   Byte 54: RSSI
-
-            // MMDVM modem expects (34 bytes):
-            //   Byte 0: Control byte (usually 0x00)
-            //   Bytes 1-33: DMR frame data (33 bytes from network packet bytes 20-52)
-            //
-            // Note: MMDVMHost uses TAG_DATA/TAG_EOT internally but does NOT send it to the modem
-            // The TAG is stripped before transmission (see Modem.cpp line 1253)
-
-            uint8_t dmrModemData[34];
-            dmrModemData[0] = 0x00;  // Control byte
-            memcpy(&dmrModemData[1], &packet[20], 33);  // Copy 33-byte DMR frame
+        }
+
+        // Update current talkgroup for quick status
+        if (isGroup) {
+          currentTalkgroup = dstId;
+        }
+      }
+
+      // Parse and forward to MMDVM (RECEIVING from network)
+      if (mmdvmReady && !endedStream) {
+        // BrandMeister DMRD packet structure (55 bytes, offsets in DmrdView):
+        //   Bytes 0-3: "DMRD" magic
+        //   Byte 4: Sequence number
+        //   Bytes 5-7: Source ID
+        //   Bytes 8-10: Destination ID
+        //   Bytes 11-14: Repeater ID
+        //   Byte 15: Control flags (slot, group/private, sync flags, data type)
+        //   Bytes 16-19: Stream ID
+        //   Bytes 20-52: DMR frame data (33 bytes) <-- THIS IS WHAT WE NEED
+        //   Byte 53: BER
+        //   Byte 54: RSSI
+
+        // MMDVM modem expects (34 bytes):
+        //   Byte 0: Control byte (usually 0x00)
+        //   Bytes 1-33: DMR frame data (33 bytes from network packet bytes 20-52)
+        //
+        // Note: MMDVMHost uses TAG_DATA/TAG_EOT internally but does NOT send it to the modem
+        // The TAG is stripped before transmission (see Modem.cpp line 1253)
+        // The jitter buffer copies the burst out of the receive buffer; when it is released,
+        // ModemTxQueue has it written straight behind the E0 header in its ring.
 
 if (debug_mmdvm) {
-            // Debug logging
-            String debugMsg = "TX->Modem: Slot" + String(slotNo) + " Len=" + String(34) +
-                             " Ctrl=" + String(dmrModemData[0], HEX) +
-                             " Frame[0-3]=" + String(dmrModemData[1], HEX) + " " +
-                             String(dmrModemData[2], HEX) + " " +
-                             String(dmrModemData[3], HEX) + " " +
-                             String(dmrModemData[4], HEX);
-            logSerial(debugMsg);
-}
-
-            // Only send DMR START once at beginning of transmission
-            if (!dmrTxActive) {
-              writeDMRStart(true, dmrActivity[activityIndex].srcCallsign);
-              dmrTxActive = true;
-            }
-            lastDMRFrameTime = millis();
-            
-            uint8_t cmd = (slotNo == 1) ? CMD_DMR_DATA1 : CMD_DMR_DATA2;
-            sendMMDVMCommand(cmd, dmrModemData, 34);
-            
-            // DMR frames are transmitted every 60ms - add delay to prevent buffer overflow
-            delay(55);
-            
+        // Debug logging
+        String debugMsg = "TX->Modem: Slot" + String(slotNo) + " Seq=" + String(seqNo) + " Len=" + String(34) +
+                         " Frame[0-3]=" + String(dmrd.payload()[0], HEX) + " " +
+                         String(dmrd.payload()[1], HEX) + " " +
+                         String(dmrd.payload()[2], HEX) + " " +
+                         String(dmrd.payload()[3], HEX);
+        logSerial(debugMsg);
+}
+
+        // Slot goes on air with its first frame (DMR START once for the modem)
+        if (slotTx[txIndex].state != SLOT_TX::ACTIVE) {
+          startSlotTx(slotNo, dstId, isGroup, activity.srcCallsign);
+        }
+        slotTx[txIndex].lastFrameTime = now;
+
+        // Stream starts mid-call (its header was lost upstream): radios stay muted until they
+        // see a voice LC header, so play ones built from the DMRD fields before the first burst.
+        // They take the sequence numbers just below it; a real header arriving late is a duplicate.
+        if (synthesizeHeader) {
+          uint8_t lc[9] = { (uint8_t)(isGroup ? DMR_FLCO_GROUP : DMR_FLCO_USER_USER), 0x00, 0x00,
+                            (uint8_t)(dstId >> 16), (uint8_t)(dstId >> 8), (uint8_t)dstId,
+                            (uint8_t)(srcId >> 16), (uint8_t)(srcId >> 8), (uint8_t)srcId };
+          uint8_t header[DMR_PAYLOAD_LENGTH];
+          dmrVoiceLCHeaderBuild(lc, dmr_color_code, MMDVM_DUPLEX, header);  // BS-sourced sync in duplex, MS in simplex
+          uint8_t headerFlags = (controlByte & (DMRD_FLAG_SLOT2 | DMRD_FLAG_PRIVATE)) | DMRD_FRAME_DATA_SYNC | DMR_DT_VOICE_LC_HEADER;
+          for (uint8_t h = DMR_LATE_ENTRY_HEADERS; h > 0; h--) {
+            modemTxQueue.enqueueDMR(slotNo, (uint8_t)(seqNo - h), streamId, headerFlags, header, true);
+          }
+          dmrHeadersSynthesized++;
+          callEvent = true;
+          logSerial("[SERVER] DMR: Slot" + String(slotNo) + " [LATE ENTRY] No voice LC header, " +
+                    String(DMR_LATE_ENTRY_HEADERS) + " synthesized");
+        }
+
+        // Jitter buffer puts frames back in sequence order, then the TX queue
+        // writes one frame per slot every 60ms
+        modemTxQueue.enqueueDMR(dmrd);
+
 #if ENABLE_RGB_LED
-            rgbLed.setStatus(RGBLedStatus::RECEIVING);
-            delay(5);
-            rgbLed.setStatus(RGBLedStatus::IDLE_CONNECTED);
+        rgbLed.setStatus(RGBLedStatus::RECEIVING);  // Back to idle when TX mode ends (endSlotTx)
 #endif
-          }
+      }
+
+      // TERM_LC ends the call now (after it was queued for the modem)
+      if (isTermLC && !endedStream && tx.active) {
+        tx.endedStreamId = streamId;
+        endDMRTransmission(txIndex, "TERM_LC");
+        if (slotTx[txIndex].state == SLOT_TX::ACTIVE) {
+          slotTx[txIndex].state = SLOT_TX::ENDING;
         }
+        callEvent = true;
       }
+
+      allocationCounter.recordFrame(callEvent, allocationCounter.count() - allocsBefore);
     }
   }
 }
 
+// Close the call on a slot: log the summary, add it to the history and clear the dashboard entry
+void endDMRTransmission(int slotIndex, const char* reason) {
+  DMRTransmission &tx = currentTx[slotIndex];
+  if (!tx.active) {
+    return;
+  }
+  uint32_t durationMs = tx.lastTime - tx.startTime;
+
+  String txSummary = "[SERVER] DMR: Slot" + String(tx.slotNo) + " Seq=" + String(tx.startSeq) + "-" + String(tx.lastSeq) +
+                    " " + String(tx.srcId) + "->" + (tx.isGroup ? "TG" : "") + String(tx.dstId) +
+                    " [END " + String(reason) + "] " + String(tx.frames) + " frames, " + String(durationMs) + " ms";
+  logSerial(txSummary);
+
+  {
+    DMRStateLock lock;
+    DMRActivity &activity = dmrActivity[slotIndex];
+    if (activity.active && activity.srcId > 0) {
+      String location = getActivityLocation(activity);
+      addDMRHistory(activity.srcId, activity.srcCallsign, activity.srcName, location,
+                    activity.dstId, activity.isGroup, durationMs, 0, 0, activity.slotNo);
+    }
+    activity.active = false;
+  }
+  tx.active = false;
+}
+
+// Embedded LC of a network stream. Talker alias blocks go to the slot's alias assembler.
+// On late entry the group / private LC names the talker as the radios will show it; the
+// DMRD fields are replaced if they disagree (e.g. zero after the stream's first packets
+// were lost upstream). Returns true when it identified the call (logged).
+bool applyEmbeddedLC(int slotIndex, const uint8_t* lc) {
+  DMRTransmission &tx = currentTx[slotIndex];
+  uint8_t flco = lc[0] & 0x3F;
+  if (tx.active && netTalkerAlias[slotIndex].add(lc)) {
+    applyTalkerAlias(slotIndex);
+    return true;
+  }
+  if (!tx.active || !tx.lateEntry || (flco != DMR_FLCO_GROUP && flco != DMR_FLCO_USER_USER)) {
+    return false;
+  }
+  uint32_t dstId = ((uint32_t)lc[3] << 16) | ((uint32_t)lc[4] << 8) | lc[5];
+  uint32_t srcId = ((uint32_t)lc[6] << 16) | ((uint32_t)lc[7] << 8) | lc[8];
+  bool isGroup = (flco == DMR_FLCO_GROUP);
+  tx.lateEntry = false;
+
+  logSerial("[SERVER] DMR: Slot" + String(tx.slotNo) + " " + String(srcId) + "->" + (isGroup ? "TG" : "") + String(dstId) +
+            " [LATE ENTRY] Embedded LC after " + String(tx.lastTime - tx.startTime) + " ms");
+  if (srcId == tx.srcId && dstId == tx.dstId && isGroup == tx.isGroup) {
+    return true;
+  }
+
+  tx.srcId = srcId;
+  tx.dstId = dstId;
+  tx.isGroup = isGroup;
+  DMRActivity &activity = dmrActivity[slotIndex];
+  activity.srcId = srcId;
+  activity.dstId = dstId;
+  activity.isGroup = isGroup;
+  String userInfo = getCachedUserInfo(srcId);
+  if (userInfo.length() == 0) {
+    userLookup.request(srcId);
+  }
+  applyUserInfo(activity, userInfo);
+  if (isGroup) {
+    currentTalkgroup = dstId;
+  }
+  return true;
+}
+
+// Talker alias completed: names the station in-band, usually before the radioid.net lookup
+// returns. Known stations (cache / SD database / earlier lookup) keep their full details.
+void applyTalkerAlias(int slotIndex) {
+  DMRTransmission &tx = currentTx[slotIndex];
+  DMRActivity &activity = dmrActivity[slotIndex];
+  String alias = String(netTalkerAlias[slotIndex].getText());
+  alias.trim();
+  if (alias.length() == 0) {
+    return;
+  }
+  talkerAliasDecoded++;
+  logSerial("[SERVER] DMR: Slot" + String(tx.slotNo) + " " + String(tx.srcId) + " [TALKER ALIAS] \"" + alias +
+            "\" after " + String(tx.lastTime - tx.startTime) + " ms");
+  if (!activity.active || activity.srcCallsign[0] != '\0') {
+    return;
+  }
+
+  // "CALLSIGN Name ..." is the usual layout
+  int space = alias.indexOf(' ');
+  if (space > 0) {
+    copyStationField(activity.srcCallsign, sizeof(activity.srcCallsign), alias, 0, space);
+    int name = space + 1;
+    while (alias[name] == ' ') name++;
+    copyStationField(activity.srcName, sizeof(activity.srcName), alias, name, alias.length());
+  } else {
+    copyStationField(activity.srcCallsign, sizeof(activity.srcCallsign), alias, 0, alias.length());
+    activity.srcName[0] = '\0';
+  }
+  talkerAliasLookupsSaved++;
+  userLookup.cancel(activity.srcId);  // Still queued: not needed any more
+}
+
 void connectToDMRNetwork() {
-  dmrLoginStatus = "Connecting...";
+  {
+    DMRStateLock lock;  // Settings may be reassigned by a web handler meanwhile
+    dmrLoginStatus = "Connecting...";
+    strlcpy(dmrLogin.server, dmr_server.c_str(), sizeof(dmrLogin.server));
+    strlcpy(dmrLogin.callsign, dmr_callsign.c_str(), sizeof(dmrLogin.callsign));
+    strlcpy(dmrLogin.password, dmr_password.c_str(), sizeof(dmrLogin.password));
+    strlcpy(dmrLogin.location, dmr_location.c_str(), sizeof(dmrLogin.location));
+    strlcpy(dmrLogin.description, dmr_description.c_str(), sizeof(dmrLogin.description));
+    strlcpy(dmrLogin.url, dmr_url.c_str(), sizeof(dmrLogin.url));
+  }
   dmrLoggedIn = false;
   dmrState = DMR_STATE::WAITING_LOGIN;
   lastLoginAttempt = millis(); // Start timeout timer
+  dmrSession.attemptStarted();
 
   logSerial("Connecting to DMR Network...");
-  logSerial("Server: " + dmr_server + ":" + String(dmr_port));
-  logSerial("Callsign: " + dmr_callsign + " ID: " + String(dmr_id));
+  logSerial("Server: " + String(dmrLogin.server) + ":" + String(dmr_port));
+  logSerial("Callsign: " + String(dmrLogin.callsign) + " ID: " + String(dmr_id));
   if (dmr_essid > 0) {
     logSerial("ESSID: " + String(dmr_essid));
   }
@@ -1863,23 +2274,40 @@ void connectToDMRNetwork() {
   loginPacket[6] = (id_to_send >> 8) & 0xFF;
   loginPacket[7] = id_to_send & 0xFF;  // Least significant byte
 
-  udp.beginPacket(dmr_server.c_str(), dmr_port);
-  udp.write(loginPacket, 8);
-  udp.endPacket();
+  if (!sendToMaster(loginPacket, 8)) {
+    logSerial("DMR server address not resolved yet - login will be retried");
+    return;
+  }
 
   logSerial("Login packet sent, ID: " + String(id_to_send));
 }
 
+// Session lost or login step failed: schedule the next login with backoff
+void dropDMRSession(DMR_SESSION_EVENT event) {
+  bool passwordRefused = (event == DMR_SESSION_EVENT::MASTER_NAK && dmrState == DMR_STATE::WAITING_AUTH);
+  uint32_t wait = dmrSession.lost(event, millis(), passwordRefused);
+  dmrLoggedIn = false;
+  dmrState = DMR_STATE::DISCONNECTED;
+  String status = String(dmrSessionEventName(event)) + " - retry in " + String((wait + 999) / 1000) + " s";
+  {
+    DMRStateLock lock;
+    dmrLoginStatus = status;
+  }
+  logSerial("DMR " + status);
+  oledRefreshPending = true;  // Show the disconnected status
+}
+
 void sendDMRAuth() {
 // Send RPTK (authorization) packet with SHA256(salt + password)
 // Format: "RPTK" + DMR_ID (4 bytes binary) + SHA256 hash (32 bytes binary)
 // SHA256 input: salt (4 binary bytes) + password (ASCII string)
 
 // Debug: Show password being used (with more detail)
+size_t passLen = strlen(dmrLogin.password);
 if (debug_password) {
-  String passDebug = "Using password: length=" + String(dmr_password.length());
-  if (dmr_password.length() > 0) {
-    passDebug += ", last4=" + dmr_password.substring(max(0, (int)dmr_password.length() - 4));
+  String passDebug = "Using password: length=" + String(passLen);
+  if (passLen > 0) {
+    passDebug += ", last4=" + String(dmrLogin.password + (passLen > 4 ? passLen - 4 : 0));
   } else {
     passDebug += " [EMPTY!]";
   }
@@ -1887,13 +2315,12 @@ if (debug_password) {
 }
 
   // Calculate SHA256 hash of (salt + password)
-  size_t passLen = dmr_password.length();
   size_t inputLen = 4 + passLen;
   uint8_t* input = new uint8_t[inputLen];
 
   // Salt is 4 binary bytes, not hex string
   memcpy(input, dmrSalt, 4);
-  memcpy(input + 4, dmr_password.c_str(), passLen);
+  memcpy(input + 4, dmrLogin.password, passLen);
 
   // Calculate SHA256 hash (binary output, not hex)
   uint8_t hash[32];
@@ -1921,9 +2348,7 @@ if (debug_password) {
   authPacket[7] = id_to_send & 0xFF;
   memcpy(authPacket + 8, hash, 32);  // SHA256 hash as 32 binary bytes
 
-  udp.beginPacket(dmr_server.c_str(), dmr_port);
-  udp.write(authPacket, 40);
-  udp.endPacket();
+  if (!sendToMaster(authPacket, 40)) return;
 
   logSerial("Auth packet sent (40 bytes)");
 }
@@ -1958,7 +2383,7 @@ void sendDMRConfig() {
 
   snprintf(configString, sizeof(configString),
            "%-8.8s%09u%09u%02u%02u%8.8s%9.9s%03d%-20.20s%-19.19s%c%-124.124s%-40.40s%-40.40s",
-           dmr_callsign.c_str(),     // Callsign (8 chars, left-aligned)
+           dmrLogin.callsign,        // Callsign (8 chars, left-aligned)
            dmr_rx_freq,              // RX Frequency (9 digits)
            dmr_tx_freq,              // TX Frequency (9 digits)
            power,                    // Power (2 digits)
@@ -1966,10 +2391,10 @@ void sendDMRConfig() {
            latitude,                 // Latitude (8 chars)
            longitude,                // Longitude (9 chars)
            height,                   // Height (3 digits)
-           dmr_location.c_str(),     // Location (20 chars)
-           dmr_description.c_str(),  // Description (19 chars)
-           '4',                      // Slots (1 char: '4' = simplex)
-           dmr_url.c_str(),          // URL (124 chars)
+           dmrLogin.location,        // Location (20 chars)
+           dmrLogin.description,     // Description (19 chars)
+           MMDVM_DUPLEX ? '3' : '4', // Slots (1 char: '3' = TS1 + TS2 duplex, '4' = simplex)
+           dmrLogin.url,             // URL (124 chars)
            firmwareVersion.c_str(),  // Version (40 chars) - from firmware variable
            "MMDVM_MMDVM_HS");        // Software (40 chars)
 
@@ -1996,13 +2421,21 @@ void sendDMRConfig() {
   configPacket[7] = id_to_send & 0xFF;
   memcpy(configPacket + 8, configString, 294);  // Copy exactly 294 bytes
 
-  udp.beginPacket(dmr_server.c_str(), dmr_port);
-  udp.write(configPacket, 302);
-  udp.endPacket();
+  if (!sendToMaster(configPacket, 302)) return;
 
   logSerial("Config packet sent (302 bytes)");
 }
 
+// Send a datagram to the DMR master using the cached address (no DNS on the send path)
+bool sendToMaster(const uint8_t* data, size_t length) {
+  dmrResolver.setHost(dmrLogin.server);
+  IPAddress masterIP;
+  if (!dmrResolver.getAddress(masterIP)) {
+    return false;
+  }
+  return dmrSocket.sendTo(masterIP, dmr_port, data, length);
+}
+
 void sendDMRKeepalive() {
   // Send keepalive/ping packet to DMR network
   // Format: "RPTPING" (7 bytes) + DMR_ID (4 bytes binary) = 11 bytes
@@ -2019,9 +2452,7 @@ void sendDMRKeepalive() {
   keepalive[9] = (id_to_send >> 8) & 0xFF;
   keepalive[10] = id_to_send & 0xFF;
 
-  udp.beginPacket(dmr_server.c_str(), dmr_port);
-  udp.write(keepalive, 11);
-  udp.endPacket();
+  if (!sendToMaster(keepalive, 11)) return;
 
   logSerialVerbose("Keepalive sent");
 }
@@ -2029,27 +2460,50 @@ void sendDMRKeepalive() {
 // ===== Serial Logging Functions =====
 // Log to both USB serial and web buffer
 void logSerial(String message) {
-  Serial.println(message);
-
-  // Store in circular buffer for web monitor
-  serialLog[serialLogIndex] = message;
-  serialLogIndex = (serialLogIndex + 1) % SERIAL_LOG_SIZE;
+  appendLog(message, true, true);
 }
 
 // Log with verbose flag - always to USB serial, conditionally to web buffer
 void logSerialVerbose(String message) {
-  // Only log network debug messages if debug_network is enabled
-  if (debug_network) {
+  // Only log network debug messages if debug_network is enabled;
+  // also store in web buffer if verbose logging is enabled
+  if (debug_network || verbose_logging) {
+    appendLog(message, debug_network, verbose_logging);
+  }
+}
+
+// loop() (and setup()) write straight away; other tasks queue the line for loop()
+void appendLog(const String &message, bool toSerial, bool toWeb) {
+  if (logQueue != NULL && xTaskGetCurrentTaskHandle() != uiTaskHandle) {
+    LogLine line;
+    line.toSerial = toSerial;
+    line.toWeb = toWeb;
+    strlcpy(line.text, message.c_str(), sizeof(line.text));
+    if (xQueueSend(logQueue, &line, 0) != pdTRUE) {
+      logLinesDropped++;
+    }
+    return;
+  }
+
+  if (toSerial) {
     Serial.println(message);
   }
-  
-  // Also store in web buffer if verbose logging is enabled
-  if (verbose_logging) {
+
+  // Store in circular buffer for web monitor
+  if (toWeb) {
     serialLog[serialLogIndex] = message;
     serialLogIndex = (serialLogIndex + 1) % SERIAL_LOG_SIZE;
   }
 }
 
+void drainLogQueue() {
+  if (logQueue == NULL) return;
+  LogLine line;
+  while (xQueueReceive(logQueue, &line, 0) == pdTRUE) {
+    appendLog(String(line.text), line.toSerial, line.toWeb);
+  }
+}
+
 #ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
 // ===== SD Card Helper Functions =====
 bool writeSDFile(const char* path, const char* data) {
@@ -2303,6 +2757,7 @@ void setupWebServer() {
   // Data endpoints
   server.on("/logs", handleGetLogs);
   server.on("/statusdata", handleStatusData);     // Status page data
+  server.on("/modem-status", handleModemStatus);  // Modem status + TX queue counters (JSON)
   server.on("/wifiscan", handleWifiScan);
   server.on("/dmr-activity", handleDMRActivity);  // Live DMR activity for home page
   server.on("/dmr-slot1", handleDMRSlot1);        // DMR Slot 1 activity
@@ -2388,7 +2843,7 @@ void updateStatusLED() {
 
 // ===== DMR User Information Lookup Functions =====
 
-// Enhanced user info lookup - checks cache first, then API
+// Enhanced user info lookup - checks cache first, then the SD card database, then API
 String lookupUserInfo(uint32_t dmrId) {
   if (dmrId == 0) return "";
   
@@ -2398,8 +2853,16 @@ String lookupUserInfo(uint32_t dmrId) {
     return cached;
   }
   
-  // Not in cache, try API lookup
-  String userInfo = lookupUserInfoAPI(dmrId);
+  String userInfo = "";
+#ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
+  // Offline binary-index lookup
+  userDatabase.lookup(dmrId, userInfo);
+#endif
+
+  // Not in cache or database, try API lookup
+  if (userInfo.length() == 0) {
+    userInfo = lookupUserInfoAPI(dmrId);
+  }
   
   // Cache the result (even if empty to avoid repeated failed lookups)
   if (userInfo.length() > 0) {
@@ -2413,68 +2876,47 @@ String lookupUserInfo(uint32_t dmrId) {
 String lookupCallsign(uint32_t dmrId) {
   if (dmrId == 0) return "";
   
-  // Try enhanced lookup first
+  // The user cache holds the callsign with the rest of the user info
   String userInfo = lookupUserInfo(dmrId);
-  if (userInfo.length() > 0) {
-    int pipeIndex = userInfo.indexOf('|');
-    return (pipeIndex > 0) ? userInfo.substring(0, pipeIndex) : userInfo;
-  }
-  
-  // Fallback to legacy cache
-  String cached = getCachedCallsign(dmrId);
-  if (cached.length() > 0) {
-    return cached;
-  }
-  
-  // Not in cache, try API lookup
-  String callsign = lookupCallsignAPI(dmrId);
-  
-  // Cache the result (even if empty to avoid repeated failed lookups)
-  if (callsign.length() > 0) {
-    cacheCallsign(dmrId, callsign);
-  }
-  
-  return callsign;
+  int pipeIndex = userInfo.indexOf('|');
+  return (pipeIndex > 0) ? userInfo.substring(0, pipeIndex) : userInfo;
 }
 
 // Check if user info is in cache
 String getCachedUserInfo(uint32_t dmrId) {
-  for (int i = 0; i < DMR_USER_CACHE_SIZE; i++) {
-    if (userCache[i].dmrId == dmrId && userCache[i].userInfo.length() > 0) {
-      return userCache[i].userInfo;
-    }
-  }
-  return "";
+  return userCache.get(dmrId);
 }
 
-// Add user info to cache (circular buffer)
+// Add user info to cache (CLOCK eviction when full)
 void cacheUserInfo(uint32_t dmrId, String userInfo) {
-  userCache[userCacheIndex].dmrId = dmrId;
-  userCache[userCacheIndex].userInfo = userInfo;
-  userCache[userCacheIndex].timestamp = millis();
-  userCacheIndex = (userCacheIndex + 1) % DMR_USER_CACHE_SIZE;
+  userCache.put(dmrId, userInfo);
 }
 
-// Check if callsign is in legacy cache
-String getCachedCallsign(uint32_t dmrId) {
-  for (int i = 0; i < DMR_CALLSIGN_CACHE_SIZE; i++) {
-    if (callsignCache[i].dmrId == dmrId && callsignCache[i].callsign.length() > 0) {
-      return callsignCache[i].callsign;
-    }
+// Enhanced user info lookup via RadioID.net API
+String lookupUserInfoAPI(uint32_t dmrId) {
+  int httpCode = 0;
+  String userInfo = fetchUserInfoAPI(dmrId, httpCode);
+  if (httpCode > 0 && httpCode != 200) {
+    logSerial("User info lookup failed: HTTP " + String(httpCode));
   }
-  return "";
+  return userInfo;
 }
 
-// Add callsign to legacy cache (circular buffer)
-void cacheCallsign(uint32_t dmrId, String callsign) {
-  callsignCache[callsignCacheIndex].dmrId = dmrId;
-  callsignCache[callsignCacheIndex].callsign = callsign;
-  callsignCache[callsignCacheIndex].timestamp = millis();
-  callsignCacheIndex = (callsignCacheIndex + 1) % DMR_CALLSIGN_CACHE_SIZE;
+// User lookup task backend: SD card database first (offline), then RadioID.net
+String fetchUserInfo(uint32_t dmrId, int &httpCode) {
+  httpCode = 0;
+#ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
+  String userInfo;
+  if (userDatabase.lookup(dmrId, userInfo)) {
+    return userInfo;
+  }
+#endif
+  return fetchUserInfoAPI(dmrId, httpCode);
 }
 
-// Enhanced user info lookup via RadioID.net API
-String lookupUserInfoAPI(uint32_t dmrId) {
+// RadioID.net request and parsing only (no logging), so it can run in the user lookup task
+String fetchUserInfoAPI(uint32_t dmrId, int &httpCode) {
+  httpCode = 0;
   if (!wifiConnected) {
     return "";
   }
@@ -2485,7 +2927,7 @@ String lookupUserInfoAPI(uint32_t dmrId) {
   http.begin(url);
   http.setTimeout(DMR_API_TIMEOUT);  // API timeout from config.h
   
-  int httpCode = http.GET();
+  httpCode = http.GET();
   String userInfo = "";
   
   if (httpCode == 200) {
@@ -2558,14 +3000,138 @@ String lookupUserInfoAPI(uint32_t dmrId) {
         userInfo += "|" + name + "|" + city + "|" + country;
       }
     }
-  } else if (httpCode > 0) {
-    logSerial("User info lookup failed: HTTP " + String(httpCode));
   }
   
   http.end();
   return userInfo;
 }
 
+// Apply finished background lookups to live activity and to history entries
+// of transmissions that ended before the answer arrived
+void processUserLookups() {
+  UserLookupResult result;
+  while (userLookup.poll(result)) {
+    if (result.info[0] == '\0') {
+      if (result.httpCode > 0 && result.httpCode != 200) {
+        logSerial("User info lookup failed: HTTP " + String(result.httpCode));
+      }
+      continue;
+    }
+
+    String userInfo = String(result.info);
+    cacheUserInfo(result.dmrId, userInfo);
+
+    DMRStateLock lock;
+    for (int i = 0; i < 2; i++) {
+      if (dmrActivity[i].active && dmrActivity[i].srcId == result.dmrId && dmrActivity[i].srcCallsign[0] == '\0') {
+        applyUserInfo(dmrActivity[i], userInfo);
+        logStationInfo(dmrActivity[i], result.dmrId);
+      }
+    }
+
+    DMRActivity station;
+    applyUserInfo(station, userInfo);
+    for (int i = 0; i < DMR_HISTORY_SIZE; i++) {
+      if (dmrHistory[i].srcId == result.dmrId && dmrHistory[i].srcCallsign.length() == 0) {
+        dmrHistory[i].srcCallsign = station.srcCallsign;
+        dmrHistory[i].srcName = station.srcName;
+        dmrHistory[i].srcLocation = getActivityLocation(station);
+      }
+    }
+  }
+}
+
+// Copy text[from, to) into a fixed-size station field, truncated to fit
+void copyStationField(char* field, size_t size, const String &text, int from, int to) {
+  size_t length = (to > from) ? (size_t)(to - from) : 0;
+  if (length >= size) length = size - 1;
+  memcpy(field, text.c_str() + from, length);
+  field[length] = '\0';
+}
+
+// Fill station fields from a "callsign|name|city|country" (or plain callsign) string
+void applyUserInfo(DMRActivity &activity, const String &userInfo) {
+  activity.srcCallsign[0] = '\0';
+  activity.srcName[0] = '\0';
+  activity.srcCity[0] = '\0';
+  activity.srcCountry[0] = '\0';
+
+  int end = userInfo.length();
+  int pipe1 = userInfo.indexOf('|');
+  if (pipe1 > 0) {
+    copyStationField(activity.srcCallsign, sizeof(activity.srcCallsign), userInfo, 0, pipe1);
+    int pipe2 = userInfo.indexOf('|', pipe1 + 1);
+    if (pipe2 > pipe1) {
+      copyStationField(activity.srcName, sizeof(activity.srcName), userInfo, pipe1 + 1, pipe2);
+      int pipe3 = userInfo.indexOf('|', pipe2 + 1);
+      if (pipe3 > pipe2) {
+        copyStationField(activity.srcCity, sizeof(activity.srcCity), userInfo, pipe2 + 1, pipe3);
+        copyStationField(activity.srcCountry, sizeof(activity.srcCountry), userInfo, pipe3 + 1, end);
+      } else {
+        copyStationField(activity.srcCity, sizeof(activity.srcCity), userInfo, pipe2 + 1, end);
+      }
+    } else {
+      copyStationField(activity.srcName, sizeof(activity.srcName), userInfo, pipe1 + 1, end);
+    }
+  } else {
+    copyStationField(activity.srcCallsign, sizeof(activity.srcCallsign), userInfo, 0, end);
+  }
+}
+
+// "City, Country" for history entries
+String getActivityLocation(const DMRActivity &activity) {
+  String location = activity.srcCity;
+  if (activity.srcCity[0] != '\0' && activity.srcCountry[0] != '\0') location += ", ";
+  location += activity.srcCountry;
+  return location;
+}
+
+void logStationInfo(const DMRActivity &activity, uint32_t srcId) {
+  String logMsg = "[INFO] Station: " + String(activity.srcCallsign) + " (" + String(srcId) + ")";
+  if (activity.srcName[0] != '\0') {
+    logMsg += " - " + String(activity.srcName);
+  }
+  if (activity.srcCity[0] != '\0') {
+    logMsg += " from " + String(activity.srcCity);
+    if (activity.srcCountry[0] != '\0') {
+      logMsg += ", " + String(activity.srcCountry);
+    }
+  }
+  logSerial(logMsg);
+}
+
+#ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
+// Log user database state changes made by its background task
+void reportUserDatabase() {
+  static SDUserDatabaseState reported = DMR_DB_IDLE;
+  SDUserDatabaseStats db = userDatabase.getStats();
+  if (db.state == reported) return;
+  reported = db.state;
+
+  switch (db.state) {
+    case DMR_DB_NO_CSV:
+      logSerial("User database: no " DMR_DB_COMPACT_PATH " or " DMR_DB_CSV_PATH " on SD card, using RadioID.net only");
+      break;
+    case DMR_DB_BUILDING:
+      logSerial("User database: building index for " DMR_DB_CSV_PATH "...");
+      break;
+    case DMR_DB_READY:
+      if (db.compact) {
+        logSerial("User database ready: " + String(db.entries) + " IDs from " DMR_DB_COMPACT_PATH ", loaded in " + String(db.loadMs) + " ms");
+      } else {
+        logSerial("User database ready: " + String(db.entries) + " IDs, index " +
+                  (db.built ? "built in " + String(db.buildMs) + " ms" : "loaded in " + String(db.loadMs) + " ms"));
+      }
+      break;
+    case DMR_DB_FAILED:
+      logSerial("ERROR: User database index could not be built");
+      break;
+    default:
+      break;
+  }
+}
+#endif
+
 // Legacy callsign lookup via RadioID.net API
 String lookupCallsignAPI(uint32_t dmrId) {
   // Use enhanced lookup and extract just the callsign
@@ -2604,9 +3170,9 @@ String getCurrentTimestamp() {
 }
 
 // Add DMR transmission to history
-void addDMRHistory(uint32_t srcId, String srcCallsign, String srcName, String srcLocation, uint32_t dstId, bool isGroup, uint32_t duration, uint8_t ber, uint8_t rssi, uint8_t slotNo) {
+void addDMRHistory(uint32_t srcId, String srcCallsign, String srcName, String srcLocation, uint32_t dstId, bool isGroup, uint32_t durationMs, uint8_t ber, uint8_t rssi, uint8_t slotNo) {
   // Debug log
-  logSerial("[HISTORY] Adding to history: " + srcCallsign + " (" + String(srcId) + ") -> " + (isGroup ? "TG" : "") + String(dstId) + " Duration: " + String(duration) + "s");
+  logSerial("[HISTORY] Adding to history: " + srcCallsign + " (" + String(srcId) + ") -> " + (isGroup ? "TG" : "") + String(dstId) + " Duration: " + String(durationMs / 1000.0, 1) + "s");
 
   // Get current timestamp (NTP time or fallback to uptime)
   String timestamp = getCurrentTimestamp();
@@ -2619,7 +3185,7 @@ void addDMRHistory(uint32_t srcId, String srcCallsign, String srcName, String sr
   dmrHistory[dmrHistoryIndex].srcLocation = srcLocation;
   dmrHistory[dmrHistoryIndex].dstId = dstId;
   dmrHistory[dmrHistoryIndex].isGroup = isGroup;
-  dmrHistory[dmrHistoryIndex].duration = duration;
+  dmrHistory[dmrHistoryIndex].durationMs = durationMs;
   dmrHistory[dmrHistoryIndex].ber = ber;
   dmrHistory[dmrHistoryIndex].rssi = rssi;
   dmrHistory[dmrHistoryIndex].slotNo = slotNo;
@@ -2813,6 +3379,16 @@ void updateBootStatus(String status) {
 
 void updateOLEDStatus() {
   if (!enable_oled) return;
+
+  // Copy what is shown from the core task's state; drawing and the I2C transfer run without the lock
+  DMRActivity activity[2];
+  String loginStatus;
+  {
+    DMRStateLock lock;
+    activity[0] = dmrActivity[0];
+    activity[1] = dmrActivity[1];
+    loginStatus = dmrLoginStatus;
+  }
   
   // Try to acquire mutex to prevent SPI conflicts with Ethernet
   if (displayMutex != NULL) {
@@ -2898,7 +3474,7 @@ void updateOLEDStatus() {
   bool activityDisplayed = false;
 
   // Check if both slots are active
-  bool bothSlotsActive = dmrActivity[0].active && dmrActivity[1].active;
+  bool bothSlotsActive = activity[0].active && activity[1].active;
 
   // Determine which slot to display
   int slotToDisplay = -1;
@@ -2906,10 +3482,10 @@ void updateOLEDStatus() {
     // Both active - alternate between them
     slotToDisplay = oledActiveSlot;
     oledActiveSlot = (oledActiveSlot == 0) ? 1 : 0; // Toggle for next update
-  } else if (dmrActivity[1].active) {
+  } else if (activity[1].active) {
     // Only Slot 2 active (prioritize Slot 2)
     slotToDisplay = 1;
-  } else if (dmrActivity[0].active) {
+  } else if (activity[0].active) {
     // Only Slot 1 active
     slotToDisplay = 0;
   }
@@ -2920,7 +3496,7 @@ void updateOLEDStatus() {
 
     // Callsign - LARGE and prominent (2x size, centered)
     display.setTextSize(2);
-    String callsign = (dmrActivity[i].srcCallsign.length() > 0) ? dmrActivity[i].srcCallsign : "Unknown";
+    String callsign = (activity[i].srcCallsign[0] != '\0') ? activity[i].srcCallsign : "Unknown";
     int16_t x1, y1;
     uint16_t w, h;
     display.getTextBounds(callsign, 0, 0, &x1, &y1, &w, &h);
@@ -2931,18 +3507,18 @@ void updateOLEDStatus() {
     // Duration (small text, below callsign)
     display.setTextSize(1);
     display.setCursor(0, 32);
-    unsigned long duration = (millis() - dmrActivity[i].startTime) / 1000;
+    unsigned long duration = (millis() - activity[i].startTime) / 1000;
     display.print("Duration: ");
     display.print(duration);
     display.println("s");
 
     // DMR ID -> Talkgroup with slot indicator at the end (small text)
     display.setCursor(0, 42);
-    display.print(dmrActivity[i].srcId);
+    display.print(activity[i].srcId);
     display.print(" -> TG ");
-    display.print(dmrActivity[i].dstId);
+    display.print(activity[i].dstId);
     display.print(" [S");
-    display.print(dmrActivity[i].slotNo);
+    display.print(activity[i].slotNo);
     display.print("]");
 
     activityDisplayed = true;
@@ -2992,9 +3568,9 @@ void updateOLEDStatus() {
         unsigned long mostRecentTime = 0;
 
         for (int i = 0; i < 2; i++) {
-          if (dmrActivity[i].srcCallsign.length() > 0 && dmrActivity[i].lastUpdate > mostRecentTime) {
-            lastCaller = dmrActivity[i].srcCallsign;
-            mostRecentTime = dmrActivity[i].lastUpdate;
+          if (activity[i].srcCallsign[0] != '\0' && activity[i].lastUpdate > mostRecentTime) {
+            lastCaller = activity[i].srcCallsign;
+            mostRecentTime = activity[i].lastUpdate;
           }
         }
 
@@ -3008,7 +3584,7 @@ void updateOLEDStatus() {
         display.println("DMR Mode Active");
         display.setCursor(0, 30);
         display.print("Status: ");
-        display.println(dmrLoginStatus);
+        display.println(loginStatus);
       }
     } else {
       // Other mode is enabled (D-Star, YSF, P25, NXDN, POCSAG)
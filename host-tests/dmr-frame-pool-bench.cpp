@@ -0,0 +1,74 @@
+/*
+ * dmr-frame-pool-bench.cpp - Host benchmark for DMRFramePool
+ *
+ * ns per alloc() + release() pair: uncontended from one thread, with 4 threads
+ * sharing the pool, and the producer/consumer handoff DMRNetworkSocket uses
+ * (allocate, queue the index through an SpscQueue, release in the other thread).
+ *
+ * Build and run: ./make-host-tests.sh bench
+ */
+
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "../DMRFramePool.h"
+#include "../SpscQueue.h"
+
+#define BENCH_OPS 10000000
+
+struct BenchFrame {
+  uint8_t data[64];
+};
+
+static DMRFramePool<BenchFrame, 18> pool;
+
+static double seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void allocRelease(uint32_t ops) {
+  for (uint32_t i = 0; i < ops; i++) {
+    uint8_t index = pool.alloc();
+    if (index != DMR_FRAME_NONE) pool.release(index);
+  }
+}
+
+int main() {
+  auto start = std::chrono::steady_clock::now();
+  allocRelease(BENCH_OPS);
+  printf("alloc+release, 1 thread     %6.1f ns/op\n", seconds(start) * 1e9 / BENCH_OPS);
+
+  const uint32_t threadCount = 4;
+  std::vector<std::thread> threads;
+  start = std::chrono::steady_clock::now();
+  for (uint32_t t = 0; t < threadCount; t++) threads.emplace_back(allocRelease, BENCH_OPS / threadCount);
+  for (std::thread &t : threads) t.join();
+  printf("alloc+release, %u threads    %6.1f ns/op (wall time / total ops)\n", (unsigned)threadCount,
+         seconds(start) * 1e9 / BENCH_OPS);
+
+  static SpscQueue<uint8_t, 16> queue;
+  start = std::chrono::steady_clock::now();
+  std::thread consumer([]() {
+    for (uint32_t n = 0; n < BENCH_OPS; n++) {
+      uint8_t* index;
+      while ((index = queue.front()) == NULL) std::this_thread::yield();
+      uint8_t slot = *index;
+      queue.pop();
+      pool.release(slot);
+    }
+  });
+  for (uint32_t n = 0; n < BENCH_OPS; n++) {
+    uint8_t index;
+    while ((index = pool.alloc()) == DMR_FRAME_NONE) std::this_thread::yield();
+    pool.get(index).data[0] = (uint8_t)n;
+    while (!queue.push(index)) std::this_thread::yield();
+  }
+  consumer.join();
+  printf("alloc+queue+release handoff %6.1f ns/frame\n", seconds(start) * 1e9 / BENCH_OPS);
+
+  DMRFramePoolStats stats = pool.getStats();
+  printf("allocs %u, exhausted %u, peak in use %u of %u\n", (unsigned)stats.allocs, (unsigned)stats.exhausted,
+         (unsigned)stats.peakInUse, (unsigned)stats.capacity);
+  return 0;
+}
@@ -0,0 +1,117 @@
+/*
+ * dmr-frame-pool-test.cpp - Host stress test for DMRFramePool
+ *
+ * - Several threads alloc(), fill, check and release() slots at once: a slot is
+ *   never handed to two owners, and nothing leaks
+ * - Producer/consumer handoff as DMRNetworkSocket uses it: one thread allocates
+ *   and queues indexes through an SpscQueue, another checks and releases them
+ *
+ * Build and run: ./make-host-tests.sh
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "../DMRFramePool.h"
+#include "../SpscQueue.h"
+#include "check.h"
+
+#define STRESS_THREADS 4
+#define STRESS_ROUNDS 200000
+#define POOL_SIZE 8  // Fewer slots than threads x 2, so alloc() contends and runs dry
+
+struct TestFrame {
+  uint32_t owner;
+  uint32_t round;
+  uint8_t data[56];
+};
+
+static DMRFramePool<TestFrame, POOL_SIZE> pool;
+static std::atomic<uint32_t> corrupted(0);
+static std::atomic<uint32_t> allocated(0);
+
+// Each thread holds up to two slots at once and checks its pattern survives
+static void stress(uint32_t id) {
+  uint8_t held[2];
+  for (uint32_t round = 0; round < STRESS_ROUNDS; round++) {
+    uint8_t count = 0;
+    for (int i = 0; i < 2; i++) {
+      uint8_t index = pool.alloc();
+      if (index == DMR_FRAME_NONE) continue;
+      TestFrame &frame = pool.get(index);
+      frame.owner = id;
+      frame.round = round;
+      memset(frame.data, (uint8_t)(id + round), sizeof(frame.data));
+      held[count++] = index;
+      allocated.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::this_thread::yield();
+    for (uint8_t i = 0; i < count; i++) {
+      TestFrame &frame = pool.get(held[i]);
+      bool ok = frame.owner == id && frame.round == round;
+      for (size_t b = 0; ok && b < sizeof(frame.data); b++) ok = frame.data[b] == (uint8_t)(id + round);
+      if (!ok) corrupted.fetch_add(1, std::memory_order_relaxed);
+      pool.release(held[i]);
+    }
+  }
+}
+
+static void concurrentOwners() {
+  std::vector<std::thread> threads;
+  for (uint32_t id = 0; id < STRESS_THREADS; id++) threads.emplace_back(stress, id);
+  for (std::thread &t : threads) t.join();
+
+  DMRFramePoolStats stats = pool.getStats();
+  CHECK(corrupted.load() == 0, "%u slots were written by a second owner", (unsigned)corrupted.load());
+  CHECK(stats.inUse == 0, "%u slots leaked", (unsigned)stats.inUse);
+  CHECK(stats.allocs == allocated.load(), "allocs %u, threads counted %u", (unsigned)stats.allocs, (unsigned)allocated.load());
+  CHECK(stats.peakInUse <= POOL_SIZE, "peak %u over the pool size", (unsigned)stats.peakInUse);
+  for (uint8_t i = 0; i < POOL_SIZE; i++) CHECK(!pool.isOwned(i), "slot %u still owned", i);
+}
+
+// One producer queues slot indexes, one consumer checks and releases them
+static void handoff() {
+  static DMRFramePool<TestFrame, 18> handoffPool;
+  static SpscQueue<uint8_t, 16> queue;
+  const uint32_t frames = 1000000;
+  std::atomic<uint32_t> bad(0);
+
+  std::thread consumer([&]() {
+    uint32_t expected = 0;
+    while (expected < frames) {
+      uint8_t* index = queue.front();
+      if (index == NULL) {
+        std::this_thread::yield();
+        continue;
+      }
+      TestFrame &frame = handoffPool.get(*index);
+      if (frame.round != expected || frame.data[0] != (uint8_t)expected) bad.fetch_add(1);
+      uint8_t slot = *index;
+      queue.pop();
+      handoffPool.release(slot);
+      expected++;
+    }
+  });
+
+  for (uint32_t round = 0; round < frames; round++) {
+    uint8_t index;
+    while ((index = handoffPool.alloc()) == DMR_FRAME_NONE) std::this_thread::yield();
+    TestFrame &frame = handoffPool.get(index);
+    frame.round = round;
+    frame.data[0] = (uint8_t)round;
+    while (!queue.push(index)) std::this_thread::yield();
+  }
+  consumer.join();
+
+  DMRFramePoolStats stats = handoffPool.getStats();
+  CHECK(bad.load() == 0, "%u frames arrived out of order or overwritten", (unsigned)bad.load());
+  CHECK(stats.inUse == 0, "%u slots leaked after the handoff", (unsigned)stats.inUse);
+  CHECK(stats.allocs == frames, "allocs %u, expected %u", (unsigned)stats.allocs, (unsigned)frames);
+}
+
+int main() {
+  concurrentOwners();
+  handoff();
+
+  return checkResult();
+}
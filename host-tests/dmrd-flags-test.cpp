@@ -0,0 +1,43 @@
+/*
+ * dmrd-flags-test.cpp - Host test for the DMRD flags byte (packet[15])
+ *
+ * Only a data-sync burst with data type 2 is a terminator with LC. Voice
+ * bursts A-F carry their position in the same low bits, so burst C (2) must
+ * not end a stream.
+ *
+ * Build and run: ./make-host-tests.sh
+ */
+
+#include "../DMRJitterBuffer.h"
+#include "check.h"
+
+int main() {
+  // Voice bursts A-F, with and without voice sync, both slots, group and private
+  for (uint8_t position = 0; position < 6; position++) {
+    for (uint8_t high = 0; high < 4; high++) {
+      uint8_t slotBits = high << 6;
+      uint8_t voice = slotBits | DMRD_FRAME_VOICE | position;
+      uint8_t voiceSync = slotBits | DMRD_FRAME_VOICE_SYNC | position;
+      CHECK(!dmrdIsTerminator(voice), "voice burst %c (flags 0x%02X) ends the stream", 'A' + position, voice);
+      CHECK(!dmrdIsTerminator(voiceSync), "voice sync burst %c (flags 0x%02X) ends the stream", 'A' + position, voiceSync);
+    }
+  }
+
+  // Exactly the data-sync frames with data type 2 are terminators
+  int terminators = 0;
+  for (int flags = 0; flags < 256; flags++) {
+    bool expected = (flags & DMRD_FRAME_TYPE_MASK) == DMRD_FRAME_DATA_SYNC && (flags & DMRD_DTYPE_MASK) == 0x02;
+    CHECK(dmrdIsTerminator(flags) == expected, "flags 0x%02X", flags);
+    if (dmrdIsTerminator(flags)) terminators++;
+  }
+  CHECK(terminators == 4, "%d terminator flag values, expected 4 (slot x group/private)", terminators);
+
+  // The jitter buffer's view agrees
+  DMRJitterFrame frame = {};
+  frame.flags = DMRD_FRAME_VOICE | 2;
+  CHECK(!frame.isTerminator(), "DMRJitterFrame: voice burst C is a terminator");
+  frame.flags = DMRD_FLAG_SLOT2 | DMRD_FRAME_DATA_SYNC | DMRD_DTYPE_TERMINATOR;
+  CHECK(frame.isTerminator(), "DMRJitterFrame: TERM_LC on slot 2 is not a terminator");
+
+  return checkResult();
+}
@@ -0,0 +1,82 @@
+/*
+ * Arduino.h - Host stand-in for the few Arduino / ESP32 core pieces the
+ * header-only modules use, so they build and run under g++ (make-host-tests.sh)
+ * - millis() / micros() follow hostMillis(), which the tests set
+ * - portENTER_CRITICAL / portEXIT_CRITICAL are a spinlock, as on the ESP32
+ * - String is std::string plus the members the modules call
+ */
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+
+inline unsigned long &hostMillis() {
+  static unsigned long now = 0;
+  return now;
+}
+
+inline unsigned long millis() {
+  return hostMillis();
+}
+
+inline unsigned long micros() {
+  return hostMillis() * 1000;
+}
+
+inline bool psramFound() {
+  return false;
+}
+
+struct portMUX_TYPE {
+  std::atomic_flag flag = ATOMIC_FLAG_INIT;
+};
+
+#define portMUX_INITIALIZER_UNLOCKED portMUX_TYPE{}
+
+inline void portENTER_CRITICAL(portMUX_TYPE* mux) {
+  while (mux->flag.test_and_set(std::memory_order_acquire)) {
+  }
+}
+
+inline void portEXIT_CRITICAL(portMUX_TYPE* mux) {
+  mux->flag.clear(std::memory_order_release);
+}
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size--) n += write(*buffer++);
+    return n;
+  }
+};
+
+class String : public std::string {
+public:
+  using std::string::string;
+  String() {}
+  String(const std::string &s) : std::string(s) {}
+
+  int indexOf(char c, unsigned int from = 0) const {
+    size_t pos = find(c, from);
+    return (pos == npos) ? -1 : (int)pos;
+  }
+
+  String substring(unsigned int from) const {
+    return (from < size()) ? String(substr(from)) : String();
+  }
+
+  String substring(unsigned int from, unsigned int to) const {
+    return (from < to && from < size()) ? String(substr(from, to - from)) : String();
+  }
+};
+
+#endif // HOST_ARDUINO_H
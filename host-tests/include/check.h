@@ -0,0 +1,27 @@
+/*
+ * check.h - Assertions shared by the host tests (make-host-tests.sh)
+ *
+ * CHECK(cond, format, ...) prints "FAIL: ..." and counts the failure without
+ * stopping the test; main() ends with return checkResult(), which prints "OK"
+ * or the failure count and returns the exit code.
+ */
+
+#ifndef HOST_CHECK_H
+#define HOST_CHECK_H
+
+#include <stdio.h>
+
+inline int checkFailures = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { checkFailures++; printf("FAIL: " __VA_ARGS__); printf("\n"); } } while (0)
+
+inline int checkResult() {
+  if (checkFailures > 0) {
+    printf("%d failure(s)\n", checkFailures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
+
+#endif // HOST_CHECK_H
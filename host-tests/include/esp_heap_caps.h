@@ -0,0 +1,22 @@
+/*
+ * esp_heap_caps.h - Host stand-in for the ESP-IDF capability allocator (plain malloc)
+ */
+
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+
+inline void* heap_caps_malloc(size_t size, uint32_t) {
+  return malloc(size);
+}
+
+inline void heap_caps_free(void* p) {
+  free(p);
+}
+
+#endif // HOST_ESP_HEAP_CAPS_H
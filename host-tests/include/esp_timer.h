@@ -0,0 +1,71 @@
+/*
+ * esp_timer.h - Host stand-in for the ESP-IDF high resolution timer
+ * Timers never fire on their own: hostTimerFire(arg) runs the callback of every
+ * started timer created with that arg once, so a test steps a periodic clock by hand.
+ * A new timer for an arg replaces the old one (its owner is gone and the address reused).
+ */
+
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <stdint.h>
+#include <chrono>
+#include <vector>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef enum { ESP_TIMER_TASK, ESP_TIMER_ISR } esp_timer_dispatch_t;
+
+typedef struct {
+  void (*callback)(void* arg);
+  void* arg;
+  esp_timer_dispatch_t dispatch_method;
+  const char* name;
+  bool skip_unhandled_events;
+} esp_timer_create_args_t;
+
+struct HostTimer {
+  esp_timer_create_args_t args;
+  bool started;
+};
+
+typedef HostTimer* esp_timer_handle_t;
+
+inline std::vector<HostTimer*> &hostTimers() {
+  static std::vector<HostTimer*> timers;
+  return timers;
+}
+
+inline esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle) {
+  for (HostTimer* timer : hostTimers()) {
+    if (timer->args.arg == args->arg) timer->started = false;
+  }
+  *handle = new HostTimer{*args, false};
+  hostTimers().push_back(*handle);
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t) {
+  timer->started = true;
+  return ESP_OK;
+}
+
+inline esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  timer->started = false;
+  return ESP_OK;
+}
+
+inline int64_t esp_timer_get_time() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline void hostTimerFire(void* arg) {
+  for (HostTimer* timer : hostTimers()) {
+    if (timer->started && timer->args.arg == arg) timer->args.callback(arg);
+  }
+}
+
+#endif // HOST_ESP_TIMER_H
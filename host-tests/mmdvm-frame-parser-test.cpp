@@ -0,0 +1,210 @@
+/*
+ * mmdvm-frame-parser-test.cpp - Host test for MMDVMFrameParser
+ *
+ * Resync after garbage and bogus lengths, E1 (16-bit length) frames, frames
+ * split over several reads and over the ring end, a full frame queue and the
+ * quiet-line resync the serial reader uses.
+ *
+ * Build and run: ./make-host-tests.sh
+ */
+
+#include "../MMDVMFrameParser.h"
+#include "check.h"
+
+// Short (E0) frame with cmd and a payload pattern derived from seed; returns its length
+static size_t shortFrame(uint8_t* out, uint8_t cmd, uint8_t payloadLength, uint8_t seed) {
+  for (uint8_t i = 0; i < payloadLength; i++) out[MMDVM_FRAME_HEADROOM + i] = (uint8_t)(seed + i * 7);
+  return mmdvmFrameBuild(out, cmd, payloadLength);
+}
+
+// Long (E1) frame
+static size_t longFrame(uint8_t* out, uint8_t cmd, uint16_t payloadLength, uint8_t seed) {
+  uint16_t length = payloadLength + 4;
+  out[0] = MMDVM_LONG_FRAME_START;
+  out[1] = length >> 8;
+  out[2] = length & 0xFF;
+  out[3] = cmd;
+  for (uint16_t i = 0; i < payloadLength; i++) out[4 + i] = (uint8_t)(seed + i * 7);
+  return length;
+}
+
+static bool payloadMatches(const MMDVMFrameView* frame, uint8_t seed) {
+  for (uint16_t i = 0; i < frame->payloadLength(); i++) {
+    if (frame->payload()[i] != (uint8_t)(seed + i * 7)) return false;
+  }
+  return true;
+}
+
+static void garbageThenFrame() {
+  MMDVMFrameParser parser;
+  uint8_t garbage[] = { 0x00, 0x55, 0xAA, 0xFF, 0x12, 0x34 };
+  uint8_t frame[64];
+  size_t length = shortFrame(frame, 0x18, 34, 1);
+
+  parser.write(garbage, sizeof(garbage), 0);
+  CHECK(parser.front() == NULL, "garbage produced a frame");
+  parser.write(frame, length, 0);
+  const MMDVMFrameView* view = parser.front();
+  CHECK(view != NULL && view->command() == 0x18 && view->length == length && payloadMatches(view, 1),
+        "frame after garbage not parsed");
+  CHECK(parser.getStats().skippedBytes == sizeof(garbage), "skipped %u bytes, expected %u",
+        (unsigned)parser.getStats().skippedBytes, (unsigned)sizeof(garbage));
+}
+
+static void bogusLengths() {
+  MMDVMFrameParser parser;
+  // E0 with lengths 0, 1, 2 (shorter than E0 LEN CMD), E1 with 0x0000, 0x0003 and one over the maximum
+  uint8_t bogus[] = { 0xE0, 0x00, 0xE0, 0x01, 0xE0, 0x02,
+                      0xE1, 0x00, 0x00, 0xE1, 0x00, 0x03, 0xE1, (MMDVM_RX_FRAME_MAX + 1) >> 8, (MMDVM_RX_FRAME_MAX + 1) & 0xFF };
+  uint8_t frame[64];
+  size_t length = shortFrame(frame, 0x1A, 34, 2);
+
+  parser.write(bogus, sizeof(bogus), 0);
+  parser.write(frame, length, 0);
+  const MMDVMFrameView* view = parser.front();
+  CHECK(view != NULL && view->command() == 0x1A && payloadMatches(view, 2), "frame after bogus lengths not parsed");
+  CHECK(parser.getStats().invalid == 6, "%u start bytes dropped, expected 6", (unsigned)parser.getStats().invalid);
+  CHECK(parser.pending() == 1, "%u frames pending, expected 1", (unsigned)parser.pending());
+
+  // Shortest valid frames: E0 03 CMD and E1 00 04 CMD
+  parser.pop();
+  uint8_t minimal[] = { 0xE0, 0x03, 0x01, 0xE1, 0x00, 0x04, 0x02 };
+  parser.write(minimal, sizeof(minimal), 0);
+  view = parser.front();
+  CHECK(view != NULL && view->command() == 0x01 && view->payloadLength() == 0, "E0 03 CMD not parsed");
+  parser.pop();
+  view = parser.front();
+  CHECK(view != NULL && view->command() == 0x02 && view->isLong() && view->payloadLength() == 0, "E1 00 04 CMD not parsed");
+}
+
+static void longFrames() {
+  MMDVMFrameParser parser;
+  uint8_t frame[MMDVM_RX_FRAME_MAX];
+  size_t length = longFrame(frame, 0x80, 296, 3);  // Longer than any E0 frame
+
+  // Header split from the body
+  parser.write(frame, 2, 0);
+  CHECK(parser.front() == NULL, "E1 frame published from its header");
+  parser.write(frame + 2, length - 2, 0);
+  const MMDVMFrameView* view = parser.front();
+  CHECK(view != NULL && view->isLong() && view->length == length && view->command() == 0x80 &&
+        view->payloadLength() == 296 && payloadMatches(view, 3), "E1 frame not parsed");
+  CHECK(parser.getStats().longFrames == 1, "longFrames %u, expected 1", (unsigned)parser.getStats().longFrames);
+  parser.pop();
+
+  // Longest accepted frame
+  length = longFrame(frame, 0x81, MMDVM_RX_FRAME_MAX - 4, 4);
+  parser.write(frame, length, 0);
+  view = parser.front();
+  CHECK(view != NULL && view->length == MMDVM_RX_FRAME_MAX && payloadMatches(view, 4), "E1 frame of MMDVM_RX_FRAME_MAX not parsed");
+}
+
+// Frames of odd sizes, fed in odd chunks, until the ring has wrapped several times;
+// every frame must come out contiguous and intact
+static void ringWrap() {
+  MMDVMFrameParser parser;
+  uint8_t stream[64 * 1024];
+  size_t streamLength = 0;
+  uint32_t expected = 0;
+  while (streamLength + MMDVM_RX_FRAME_MAX < sizeof(stream)) {
+    if (expected % 5 == 4) {
+      streamLength += longFrame(&stream[streamLength], 0x81, 250 + expected % 50, (uint8_t)expected);
+    } else {
+      streamLength += shortFrame(&stream[streamLength], 0x18, (uint8_t)(20 + expected % 200), (uint8_t)expected);
+    }
+    expected++;
+  }
+
+  size_t fed = 0;
+  uint32_t received = 0;
+  uint32_t chunk = 1;
+  while (received < expected) {
+    if (fed < streamLength) {
+      size_t n = (streamLength - fed < chunk) ? streamLength - fed : chunk;
+      fed += parser.write(&stream[fed], n, 0);
+      chunk = (chunk * 7 + 3) % 97 + 1;
+    }
+    const MMDVMFrameView* view = parser.front();
+    if (view == NULL) {
+      if (fed == streamLength) break;
+      continue;
+    }
+    bool ok = (view->command() == ((received % 5 == 4) ? 0x81 : 0x18)) && payloadMatches(view, (uint8_t)received);
+    CHECK(ok, "frame %u corrupted after %u bytes", (unsigned)received, (unsigned)fed);
+    if (!ok) return;
+    parser.pop();
+    received++;
+  }
+  CHECK(received == expected, "%u of %u frames received", (unsigned)received, (unsigned)expected);
+  CHECK(streamLength > 8 * MMDVM_RX_RING_SIZE, "stream did not wrap the ring");
+  MMDVMFrameParserStats stats = parser.getStats();
+  CHECK(stats.invalid == 0 && stats.skippedBytes == 0, "clean stream dropped bytes");
+}
+
+// More frames than the queue holds: the rest are published once the consumer catches up
+static void queueFull() {
+  MMDVMFrameParser parser;
+  uint8_t stream[(MMDVM_RX_QUEUE_DEPTH + 4) * 16];
+  size_t streamLength = 0;
+  for (int i = 0; i < MMDVM_RX_QUEUE_DEPTH + 4; i++) {
+    streamLength += shortFrame(&stream[streamLength], 0x18, 10, (uint8_t)i);
+  }
+  CHECK(parser.write(stream, streamLength, 0) == streamLength, "bytes refused with room in the ring");
+  CHECK(parser.pending() == MMDVM_RX_QUEUE_DEPTH, "%u frames pending, expected a full queue", (unsigned)parser.pending());
+  CHECK(!parser.hasPartial(), "held-back frames reported as partial");
+
+  for (int i = 0; i < MMDVM_RX_QUEUE_DEPTH + 4; i++) {
+    parser.poll(0);
+    const MMDVMFrameView* view = parser.front();
+    CHECK(view != NULL && payloadMatches(view, (uint8_t)i), "frame %d lost behind a full queue", i);
+    if (view == NULL) return;
+    parser.pop();
+  }
+}
+
+// Unread frames hold their ring space: the producer is told there is no room
+static void ringFull() {
+  MMDVMFrameParser parser;
+  uint8_t frame[300];
+  size_t length = longFrame(frame, 0x81, 296, 5);
+  size_t taken = 0;
+  for (int i = 0; i < 8; i++) taken += parser.write(frame, length, 0);
+  CHECK(taken == MMDVM_RX_RING_SIZE, "%u bytes taken, expected the ring size", (unsigned)taken);
+  size_t space;
+  parser.writeBuffer(space);
+  CHECK(space == 0, "%u bytes free in a full ring", (unsigned)space);
+
+  // Releasing the frames frees the ring again
+  while (parser.front() != NULL) parser.pop();
+  parser.writeBuffer(space);
+  CHECK(space > 0, "no space after the frames were released");
+}
+
+// Line went quiet mid-frame: resync drops the partial frame's start byte only
+static void quietLineResync() {
+  MMDVMFrameParser parser;
+  uint8_t partial[] = { 0xE0, 0x25, 0x18, 0x00, 0x01 };
+  uint8_t frame[64];
+  size_t length = shortFrame(frame, 0x1A, 34, 6);
+
+  parser.write(partial, sizeof(partial), 0);
+  CHECK(parser.hasPartial(), "partial frame not reported");
+  parser.resync(0);
+  CHECK(!parser.hasPartial(), "partial frame still waiting after resync");
+  CHECK(parser.getStats().timeouts == 1, "timeouts %u, expected 1", (unsigned)parser.getStats().timeouts);
+  parser.write(frame, length, 0);
+  const MMDVMFrameView* view = parser.front();
+  CHECK(view != NULL && view->command() == 0x1A && payloadMatches(view, 6), "frame after resync not parsed");
+}
+
+int main() {
+  garbageThenFrame();
+  bogusLengths();
+  longFrames();
+  ringWrap();
+  queueFull();
+  ringFull();
+  quietLineResync();
+
+  return checkResult();
+}
@@ -0,0 +1,79 @@
+/*
+ * modem-tx-queue-test.cpp - Host test for ModemTxQueue flow control
+ *
+ * A duplex modem reports free space per slot. A simplex (DMO) modem reports a
+ * fixed 10 for slot 1 and its one DMO buffer as slot 2, so both slots must be
+ * gated on the slot 2 figure, and together.
+ *
+ * Build and run: ./make-host-tests.sh
+ */
+
+#include "../ModemTxQueue.h"
+#include "check.h"
+
+// Counts the DMR frames written per slot
+class ModemPort : public Print {
+public:
+  int frames[2] = { 0, 0 };
+
+  size_t write(uint8_t) override {
+    return 1;
+  }
+
+  size_t write(const uint8_t* buffer, size_t size) override {
+    if (size > 2 && buffer[2] == CMD_DMR_DATA1) frames[0]++;
+    if (size > 2 && buffer[2] == CMD_DMR_DATA2) frames[1]++;
+    return size;
+  }
+};
+
+// Queue frames on a slot, set the reported space and run one playout tick
+static void playout(ModemTxQueue &queue, uint8_t slot1Frames, uint8_t slot2Frames,
+                    uint8_t space1, uint8_t space2, bool duplex) {
+  uint8_t burst[DMR_PAYLOAD_LENGTH + 1] = {};
+  for (uint8_t i = 0; i < slot1Frames; i++) queue.enqueue(1, CMD_DMR_DATA1, burst, sizeof(burst));
+  for (uint8_t i = 0; i < slot2Frames; i++) queue.enqueue(2, CMD_DMR_DATA2, burst, sizeof(burst));
+  queue.setModemSpace(space1, space2, duplex);
+  hostTimerFire(&queue);  // The queue's playout clock
+}
+
+int main() {
+  // Duplex: each slot has its own buffer (one frame kept in reserve)
+  {
+    ModemPort port;
+    ModemTxQueue queue;
+    queue.begin(port);
+    playout(queue, 8, 8, 4, 6, true);
+    CHECK(port.frames[0] == 3, "duplex slot 1 wrote %d frames, expected 3", port.frames[0]);
+    CHECK(port.frames[1] == 5, "duplex slot 2 wrote %d frames, expected 5", port.frames[1]);
+    queue.flush(1);
+    queue.flush(2);
+  }
+
+  // Simplex: slot 1 reports 10 but the DMO buffer (slot 2 field) is nearly full
+  {
+    ModemPort port;
+    ModemTxQueue queue;
+    queue.begin(port);
+    playout(queue, 8, 0, 10, 3, false);
+    CHECK(port.frames[0] == 2, "simplex slot 1 wrote %d frames with DMO space 3, expected 2", port.frames[0]);
+    CHECK(queue.getStats(1).waitForSpace == 1, "simplex slot 1 waited %u times, expected 1", (unsigned)queue.getStats(1).waitForSpace);
+
+    // DMO buffer full: nothing more goes out on slot 1
+    playout(queue, 0, 0, 10, 1, false);
+    CHECK(port.frames[0] == 2, "simplex slot 1 wrote into a full DMO buffer");
+    queue.flush(1);
+  }
+
+  // Simplex: both slots draw on the same DMO space
+  {
+    ModemPort port;
+    ModemTxQueue queue;
+    queue.begin(port);
+    playout(queue, 4, 4, 10, 5, false);
+    int written = port.frames[0] + port.frames[1];
+    CHECK(written == 4, "simplex wrote %d frames over both slots with DMO space 5, expected 4", written);
+  }
+
+  return checkResult();
+}
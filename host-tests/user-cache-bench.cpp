@@ -0,0 +1,188 @@
+/*
+ * user-cache-bench.cpp - Host benchmark for UserCache against the old String caches
+ *
+ * The old cache was two round-robin arrays scanned linearly: UserInfoCache
+ * {dmrId, callsign, userInfo "callsign|name|city|country", timestamp} and the
+ * legacy CallsignCache {dmrId, callsign, timestamp}, both with Arduino Strings.
+ * They are rebuilt here on the host String stand-in and run against UserCache
+ * with the same users, for:
+ * - ns per lookup (hit and miss) and per insert (at capacity, so inserts evict)
+ * - bytes per entry: UserCache counts everything begin() allocates; for the old
+ *   caches the ESP32 layout is estimated (16-byte String with 11-byte SSO, heap
+ *   blocks rounded to 4 bytes plus 8 bytes of allocator header)
+ *
+ * Build and run: ./make-host-tests.sh bench
+ */
+
+#include <stdio.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "../UserCache.h"
+
+#define BENCH_USERS 4000       // Distinct users seen on the network
+#define BENCH_LOOKUPS 2000000
+
+// ESP32 sizes for the old layout
+#define ESP32_STRING_SIZE 16
+#define ESP32_STRING_SSO 11
+#define ESP32_HEAP_HEADER 8
+
+struct BenchUser {
+  uint32_t dmrId;
+  std::string callsign;
+  std::string name;
+  std::string city;
+  std::string country;
+  String info;  // "callsign|name|city|country", as the lookup service returns it
+};
+
+// The caches UserCache replaced (esp32_mmdvm_hotspot.ino before the switch)
+struct UserInfoCache {
+  uint32_t dmrId;
+  String callsign;
+  String userInfo;
+  unsigned long timestamp;
+};
+
+struct CallsignCache {
+  uint32_t dmrId;
+  String callsign;
+  unsigned long timestamp;
+};
+
+class OldCache {
+public:
+  std::vector<UserInfoCache> users;
+  std::vector<CallsignCache> callsigns;
+  int userIndex = 0;
+  int callsignIndex = 0;
+
+  explicit OldCache(int size) : users(size), callsigns(size) {}
+
+  String get(uint32_t dmrId) {
+    for (size_t i = 0; i < users.size(); i++) {
+      if (users[i].dmrId == dmrId && users[i].userInfo.length() > 0) return users[i].userInfo;
+    }
+    return "";
+  }
+
+  String getCallsign(uint32_t dmrId) {
+    for (size_t i = 0; i < callsigns.size(); i++) {
+      if (callsigns[i].dmrId == dmrId && callsigns[i].callsign.length() > 0) return callsigns[i].callsign;
+    }
+    return "";
+  }
+
+  void put(const BenchUser &user) {
+    users[userIndex].dmrId = user.dmrId;
+    users[userIndex].userInfo = user.info;
+    users[userIndex].timestamp = millis();
+    userIndex = (userIndex + 1) % users.size();
+    callsigns[callsignIndex].dmrId = user.dmrId;
+    callsigns[callsignIndex].callsign = user.callsign;
+    callsigns[callsignIndex].timestamp = millis();
+    callsignIndex = (callsignIndex + 1) % callsigns.size();
+  }
+};
+
+static size_t esp32StringHeap(size_t length) {
+  if (length <= ESP32_STRING_SSO) return 0;
+  return ((length + 1 + 3) & ~3u) + ESP32_HEAP_HEADER;
+}
+
+static std::vector<BenchUser> makeUsers() {
+  static const char* const firstNames[] = { "John", "Maria", "Peter", "Anna", "Michael", "Laura", "David", "Sofia", "Thomas", "Emma" };
+  static const char* const lastNames[] = { "Smith", "Mueller", "Rossi", "Dubois", "Novak", "Jensen", "Garcia", "Kowalski" };
+  static const char* const countries[] = { "United States", "Germany", "Italy", "France", "Czech Republic", "Denmark", "Spain", "Poland" };
+  std::mt19937 rng(12345);
+  std::vector<BenchUser> users(BENCH_USERS);
+  for (uint32_t i = 0; i < BENCH_USERS; i++) {
+    BenchUser &u = users[i];
+    u.dmrId = 2000000 + (rng() % 8000000);
+    char callsign[7] = { 0 };
+    for (int c = 0; c < 6; c++) callsign[c] = (c == 2) ? (char)('0' + rng() % 10) : (char)('A' + rng() % 26);
+    u.callsign = callsign;
+    u.name = std::string(firstNames[rng() % 10]) + " " + lastNames[rng() % 8];
+    u.country = countries[rng() % 8];
+    u.city = "City " + std::to_string(rng() % 150);  // Cities repeat, as on a real talkgroup
+    u.info = String(u.callsign + "|" + u.name + "|" + u.city + "|" + u.country);
+  }
+  return users;
+}
+
+static double nsPerOp(std::chrono::steady_clock::time_point start, uint32_t ops) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / ops;
+}
+
+static void run(uint16_t capacity, const std::vector<BenchUser> &users) {
+  std::mt19937 rng(capacity);
+  uint32_t check = 0;
+
+  // UserCache, filled to capacity
+  UserCache cache;
+  cache.begin(capacity, (uint32_t)capacity * 24, false);
+  for (uint16_t i = 0; i < capacity; i++) cache.put(users[i].dmrId, users[i].info);
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < BENCH_LOOKUPS; n++) {
+    char callsign[USER_CACHE_CALLSIGN_LEN + 1];
+    const char* name;
+    check += cache.find(users[rng() % capacity].dmrId, callsign, &name, NULL, NULL) ? (uint8_t)name[0] : 0;
+  }
+  double newHit = nsPerOp(start, BENCH_LOOKUPS);
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < BENCH_LOOKUPS; n++) check += cache.find(1000000 + n, NULL, NULL, NULL, NULL);
+  double newMiss = nsPerOp(start, BENCH_LOOKUPS);
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < BENCH_LOOKUPS; n++) check += cache.get(users[rng() % capacity].dmrId).length();
+  double newGet = nsPerOp(start, BENCH_LOOKUPS);
+
+  uint32_t inserts = BENCH_LOOKUPS / 10;
+  start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < inserts; n++) {
+    const BenchUser &u = users[rng() % BENCH_USERS];
+    cache.put(u.dmrId, u.callsign.c_str(), u.name.c_str(), u.city.c_str(), u.country.c_str());
+  }
+  double newPut = nsPerOp(start, inserts);
+  UserCacheStats stats = cache.getStats();
+
+  // Old caches, filled to capacity
+  OldCache old(capacity);
+  for (uint16_t i = 0; i < capacity; i++) old.put(users[i]);
+  uint32_t oldLookups = BENCH_LOOKUPS / 20;
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < oldLookups; n++) check += old.get(users[rng() % capacity].dmrId).length();
+  double oldHit = nsPerOp(start, oldLookups);
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < oldLookups; n++) check += old.get(1000000 + n).length() + old.getCallsign(1000000 + n).length();
+  double oldMiss = nsPerOp(start, oldLookups);
+
+  start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < inserts; n++) old.put(users[rng() % BENCH_USERS]);
+  double oldPut = nsPerOp(start, inserts);
+
+  size_t oldBytes = 0;
+  for (uint16_t i = 0; i < capacity; i++) {
+    oldBytes += 4 + 2 * ESP32_STRING_SIZE + 4 + esp32StringHeap(old.users[i].userInfo.length());
+    oldBytes += 4 + ESP32_STRING_SIZE + 4 + esp32StringHeap(old.callsigns[i].callsign.length());
+  }
+
+  printf("%u entries (check %u)\n", (unsigned)capacity, (unsigned)check);
+  printf("  lookup hit    UserCache find() %6.1f ns/op, get() %6.1f ns/op   old %8.1f ns/op\n", newHit, newGet, oldHit);
+  printf("  lookup miss   UserCache        %6.1f ns/op                     old %8.1f ns/op (both caches)\n", newMiss, oldMiss);
+  printf("  insert        UserCache        %6.1f ns/op (%u evictions)   old %8.1f ns/op\n", newPut, (unsigned)stats.evictions, oldPut);
+  printf("  memory        UserCache        %6.1f bytes/entry (pool %u of %u used)   old ~%.1f bytes/entry (ESP32 estimate)\n",
+         (double)stats.bytes / capacity, (unsigned)stats.poolUsed, (unsigned)stats.poolSize, (double)oldBytes / capacity);
+}
+
+int main() {
+  std::vector<BenchUser> users = makeUsers();
+  run(500, users);   // DMR_USER_CACHE_SIZE default
+  run(2500, users);  // LilyGO build (PSRAM)
+  return 0;
+}
@@ -0,0 +1,13 @@
+#!/bin/bash
+#
+# Build the host database converter and optionally convert a RadioID CSV
+# Usage: ./make-database.sh [database.csv] [database.udb]
+#
+
+set -e
+
+g++ -O2 -std=c++17 -Wall -o database-converter/database-converter database-converter/database-converter.cpp
+
+if [ -n "$1" ]; then
+  database-converter/database-converter convert "$1" "${2:-database.udb}"
+fi
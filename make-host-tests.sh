@@ -0,0 +1,28 @@
+#!/bin/bash
+#
+# Build and run the host tests for the header-only modules
+# Usage: ./make-host-tests.sh [bench]   (bench: also build and run the benchmarks)
+#
+
+set -e
+
+mkdir -p host-tests/build
+
+run() {
+  name=$(basename "$1" .cpp)
+  g++ -O2 -std=c++17 -Wall -Wextra -pthread -Ihost-tests/include -o "host-tests/build/$name" "$1"
+  echo "== $name"
+  "host-tests/build/$name"
+}
+
+for src in host-tests/*-test.cpp; do
+  run "$src"
+done
+
+if [ "$1" == "bench" ]; then
+  for src in host-tests/*-bench.cpp; do
+    [ -e "$src" ] && run "$src"
+  done
+fi
+
+exit 0
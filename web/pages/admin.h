@@ -12,6 +12,7 @@
 #include <Preferences.h>
 #include <HTTPClient.h>
 #include <Update.h>
+#include "../../DMRStateLock.h"
 
 // External variables and functions
 extern WebServer server;
@@ -1045,10 +1046,16 @@ void handleCleanupPreferences() {
 
   // Reload clean defaults from config.h and current variables
   // Reset to config.h defaults
-  dmr_callsign = DMR_CALLSIGN;
+  {
+    DMRStateLock lock;  // The DMR core task copies these when it logs in
+    dmr_callsign = DMR_CALLSIGN;
+    dmr_server = DMR_SERVER;
+    dmr_password = DMR_PASSWORD;
+    dmr_location = "ESP32 Hotspot";
+    dmr_description = "ESP32-MMDVM";
+    dmr_url = "";
+  }
   dmr_id = DMR_ID;
-  dmr_server = DMR_SERVER;
-  dmr_password = DMR_PASSWORD;
   dmr_essid = 0;
   dmr_rx_freq = 434000000;
   dmr_tx_freq = 434000000;
@@ -1057,9 +1064,6 @@ void handleCleanupPreferences() {
   dmr_latitude = 0.0;
   dmr_longitude = 0.0;
   dmr_height = 0;
-  dmr_location = "ESP32 Hotspot";
-  dmr_description = "ESP32-MMDVM";
-  dmr_url = "";
   // Clear all WiFi networks
   for (int i = 0; i < 5; i++) {
     wifiNetworks[i].label = (i == 0) ? "Home" : (i == 1) ? "Mobile" : (i == 2) ? "Work" : (i == 3) ? "Friends" : "Other";
@@ -1470,56 +1474,60 @@ void handleImportConfig() {
           String key = line.substring(0, equalPos);
           String value = line.substring(equalPos + 1);
 
-          // Apply configuration values
-          if (key == "DMR_CALLSIGN") dmr_callsign = value;
-          else if (key == "DMR_ID") dmr_id = value.toInt();
-          else if (key == "DMR_SERVER") dmr_server = value;
-          else if (key == "DMR_PASSWORD") dmr_password = value;
-          else if (key == "DMR_ESSID") dmr_essid = value.toInt();
-          else if (key == "DMR_RX_FREQ") dmr_rx_freq = value.toInt();
-          else if (key == "DMR_TX_FREQ") dmr_tx_freq = value.toInt();
-          else if (key == "DMR_POWER") dmr_power = value.toInt();
-          else if (key == "DMR_COLOR_CODE") dmr_color_code = value.toInt();
-          else if (key == "DMR_LATITUDE") dmr_latitude = value.toFloat();
-          else if (key == "DMR_LONGITUDE") dmr_longitude = value.toFloat();
-          else if (key == "DMR_HEIGHT") dmr_height = value.toInt();
-          else if (key == "DMR_LOCATION") dmr_location = value;
-          else if (key == "DMR_DESCRIPTION") dmr_description = value;
-          else if (key == "DMR_URL") dmr_url = value;
-          // WiFi networks (5 slots)
-          else if (key.startsWith("WIFI") && key.indexOf("_LABEL") > 0) {
-            int slot = key.substring(4, key.indexOf("_LABEL")).toInt();
-            if (slot >= 0 && slot < 5) wifiNetworks[slot].label = value;
-          }
-          else if (key.startsWith("WIFI") && key.indexOf("_SSID") > 0) {
-            int slot = key.substring(4, key.indexOf("_SSID")).toInt();
-            if (slot >= 0 && slot < 5) wifiNetworks[slot].ssid = value;
-          }
-          else if (key.startsWith("WIFI") && key.indexOf("_PASSWORD") > 0) {
-            int slot = key.substring(4, key.indexOf("_PASSWORD")).toInt();
-            if (slot >= 0 && slot < 5) wifiNetworks[slot].password = value;
+          {
+            DMRStateLock lock;  // The DMR core task copies the login settings when it logs in
+            // Apply configuration values
+            if (key == "DMR_CALLSIGN") dmr_callsign = value;
+            else if (key == "DMR_ID") dmr_id = value.toInt();
+            else if (key == "DMR_SERVER") dmr_server = value;
+            else if (key == "DMR_PASSWORD") dmr_password = value;
+            else if (key == "DMR_ESSID") dmr_essid = value.toInt();
+            else if (key == "DMR_RX_FREQ") dmr_rx_freq = value.toInt();
+            else if (key == "DMR_TX_FREQ") dmr_tx_freq = value.toInt();
+            else if (key == "DMR_POWER") dmr_power = value.toInt();
+            else if (key == "DMR_COLOR_CODE") dmr_color_code = value.toInt();
+            else if (key == "DMR_LATITUDE") dmr_latitude = value.toFloat();
+            else if (key == "DMR_LONGITUDE") dmr_longitude = value.toFloat();
+            else if (key == "DMR_HEIGHT") dmr_height = value.toInt();
+            else if (key == "DMR_LOCATION") dmr_location = value;
+            else if (key == "DMR_DESCRIPTION") dmr_description = value;
+            else if (key == "DMR_URL") dmr_url = value;
+            // WiFi networks (5 slots)
+            else if (key.startsWith("WIFI") && key.indexOf("_LABEL") > 0) {
+              int slot = key.substring(4, key.indexOf("_LABEL")).toInt();
+              if (slot >= 0 && slot < 5) wifiNetworks[slot].label = value;
+            }
+            else if (key.startsWith("WIFI") && key.indexOf("_SSID") > 0) {
+              int slot = key.substring(4, key.indexOf("_SSID")).toInt();
+              if (slot >= 0 && slot < 5) wifiNetworks[slot].ssid = value;
+            }
+            else if (key.startsWith("WIFI") && key.indexOf("_PASSWORD") > 0) {
+              int slot = key.substring(4, key.indexOf("_PASSWORD")).toInt();
+              if (slot >= 0 && slot < 5) wifiNetworks[slot].password = value;
+            }
+            else if (key == "ALT_SSID") wifiNetworks[0].ssid = value;  // Legacy support
+            else if (key == "ALT_PASSWORD") wifiNetworks[0].password = value;  // Legacy support
+            else if (key == "HOSTNAME") device_hostname = value;
+            else if (key == "VERBOSE_LOGGING") verbose_logging = (value == "1");
+            else if (key == "DEBUG_SERIAL") debug_serial = (value == "1");
+            else if (key == "DEBUG_MMDVM") debug_mmdvm = (value == "1");
+            else if (key == "DEBUG_NETWORK") debug_network = (value == "1");
+            else if (key == "DEBUG_DMR") debug_dmr = (value == "1");
+            else if (key == "DEBUG_PASSWORD") debug_password = (value == "1");
+            else if (key == "ENABLE_OLED") enable_oled = (value == "1");
+            else if (key == "NTP_TIMEZONE_OFFSET") ntp_timezone_offset = value.toInt();
+            else if (key == "NTP_DAYLIGHT_OFFSET") ntp_daylight_offset = value.toInt();
+            else if (key == "WEB_USERNAME") web_username = value;
+            else if (key == "WEB_PASSWORD") web_password = value;
+            else if (key == "MODEM_TYPE") modem_type = value;
+            else if (key == "MODE_DMR") mode_dmr_enabled = (value == "1");
+            else if (key == "MODE_DSTAR") mode_dstar_enabled = (value == "1");
+            else if (key == "MODE_YSF") mode_ysf_enabled = (value == "1");
+            else if (key == "MODE_P25") mode_p25_enabled = (value == "1");
+            else if (key == "MODE_NXDN") mode_nxdn_enabled = (value == "1");
+            else if (key == "MODE_POCSAG") mode_pocsag_enabled = (value == "1");
+
           }
-          else if (key == "ALT_SSID") wifiNetworks[0].ssid = value;  // Legacy support
-          else if (key == "ALT_PASSWORD") wifiNetworks[0].password = value;  // Legacy support
-          else if (key == "HOSTNAME") device_hostname = value;
-          else if (key == "VERBOSE_LOGGING") verbose_logging = (value == "1");
-          else if (key == "DEBUG_SERIAL") debug_serial = (value == "1");
-          else if (key == "DEBUG_MMDVM") debug_mmdvm = (value == "1");
-          else if (key == "DEBUG_NETWORK") debug_network = (value == "1");
-          else if (key == "DEBUG_DMR") debug_dmr = (value == "1");
-          else if (key == "DEBUG_PASSWORD") debug_password = (value == "1");
-          else if (key == "ENABLE_OLED") enable_oled = (value == "1");
-          else if (key == "NTP_TIMEZONE_OFFSET") ntp_timezone_offset = value.toInt();
-          else if (key == "NTP_DAYLIGHT_OFFSET") ntp_daylight_offset = value.toInt();
-          else if (key == "WEB_USERNAME") web_username = value;
-          else if (key == "WEB_PASSWORD") web_password = value;
-          else if (key == "MODEM_TYPE") modem_type = value;
-          else if (key == "MODE_DMR") mode_dmr_enabled = (value == "1");
-          else if (key == "MODE_DSTAR") mode_dstar_enabled = (value == "1");
-          else if (key == "MODE_YSF") mode_ysf_enabled = (value == "1");
-          else if (key == "MODE_P25") mode_p25_enabled = (value == "1");
-          else if (key == "MODE_NXDN") mode_nxdn_enabled = (value == "1");
-          else if (key == "MODE_POCSAG") mode_pocsag_enabled = (value == "1");
 
           logSerial("Imported: " + key + " = " + value);
         }
@@ -11,6 +11,8 @@
 #include "../common/css.h"
 #include "../common/navigation.h"
 #include "../common/utils.h"
+#include "../../DMRDefines.h"
+#include "../../DMRStateLock.h"
 
 // External variables
 extern WebServer server;
@@ -37,16 +39,20 @@ extern bool mode_nxdn_enabled;
 extern bool mode_pocsag_enabled;
 
 // DMR Activity structure
+// Plain fixed-size fields: updated per DMRD frame by the DMR core task without
+// heap allocation, copied out under DMRStateLock and formatted by the readers
+#define DMR_ACTIVITY_CALLSIGN_LEN 16  // Including terminator
+#define DMR_ACTIVITY_TEXT_LEN 32      // Name / city / country, including terminator
 struct DMRActivity {
   uint32_t srcId;
   uint32_t dstId;
   uint8_t slotNo;
   bool isGroup;
-  String frameType;
-  String srcCallsign;
-  String srcName;
-  String srcCity;
-  String srcCountry;
+  DMR_FRAME_TYPE frameType;
+  char srcCallsign[DMR_ACTIVITY_CALLSIGN_LEN];
+  char srcName[DMR_ACTIVITY_TEXT_LEN];
+  char srcCity[DMR_ACTIVITY_TEXT_LEN];
+  char srcCountry[DMR_ACTIVITY_TEXT_LEN];
   unsigned long lastUpdate;
   unsigned long startTime;  // Actual transmission start time
   bool active;
@@ -62,7 +68,7 @@ struct DMRHistory {
   String srcLocation;
   uint32_t dstId;
   bool isGroup;
-  uint32_t duration;
+  uint32_t durationMs;
   uint8_t ber;
   uint8_t rssi;
   uint8_t slotNo;
@@ -75,13 +81,18 @@ extern String lookupCallsign(uint32_t dmrId);
 
 // Helper function to generate DMR activity HTML
 String getDMRActivityHTML() {
+  DMRActivity slots[2];
+  {
+    DMRStateLock lock;  // dmrActivity is updated by the DMR core task
+    memcpy(slots, dmrActivity, sizeof(slots));
+  }
   String html = "<div class='activity-grid'>";
   
   bool anyActivity = false;
   
   // Check both slots
   for (int i = 0; i < 2; i++) {
-    DMRActivity &activity = dmrActivity[i];
+    DMRActivity &activity = slots[i];
     
     String cardClass = activity.active ? "activity-card" : "activity-idle";
     html += "<div class='" + cardClass + "'>";
@@ -92,7 +103,7 @@ String getDMRActivityHTML() {
       anyActivity = true;
       // Prominent callsign header
       html += "<div class='callsign-header'>";
-      if (activity.srcCallsign.length() > 0) {
+      if (activity.srcCallsign[0] != '\0') {
         html += "<a href='" + String(QRZ_LOOKUP_URL) + activity.srcCallsign + "' target='_blank' rel='noopener noreferrer'>" + activity.srcCallsign + "</a>";
       } else {
         html += "Unknown";
@@ -104,24 +115,24 @@ String getDMRActivityHTML() {
       html += "<span class='metric-value'>" + String(activity.srcId) + "</span>";
       html += "</div>";
 
-      if (activity.srcName.length() > 0) {
+      if (activity.srcName[0] != '\0') {
         html += "<div class='metric'>";
         html += "<span class='metric-label'>Name:</span>";
-        html += "<span class='metric-value'>" + activity.srcName + "</span>";
+        html += "<span class='metric-value'>" + String(activity.srcName) + "</span>";
         html += "</div>";
       }
 
-      if (activity.srcCity.length() > 0) {
+      if (activity.srcCity[0] != '\0') {
         html += "<div class='metric'>";
         html += "<span class='metric-label'>City:</span>";
-        html += "<span class='metric-value'>" + activity.srcCity + "</span>";
+        html += "<span class='metric-value'>" + String(activity.srcCity) + "</span>";
         html += "</div>";
       }
 
-      if (activity.srcCountry.length() > 0) {
+      if (activity.srcCountry[0] != '\0') {
         html += "<div class='metric'>";
         html += "<span class='metric-label'>Country:</span>";
-        html += "<span class='metric-value'>" + activity.srcCountry + "</span>";
+        html += "<span class='metric-value'>" + String(activity.srcCountry) + "</span>";
         html += "</div>";
       }
 
@@ -134,7 +145,7 @@ String getDMRActivityHTML() {
 
       html += "<div class='metric'>";
       html += "<span class='metric-label'>Type:</span>";
-      html += "<span class='metric-value'>" + activity.frameType + "</span>";
+      html += "<span class='metric-value'>" + String(dmrFrameTypeName(activity.frameType)) + "</span>";
       html += "</div>";
 
       // Calculate transmission duration from start time
@@ -158,7 +169,11 @@ String getDMRActivityHTML() {
 
 // Helper function to generate single slot DMR activity HTML
 String getDMRSlotHTML(int slotIndex) {
-  DMRActivity &activity = dmrActivity[slotIndex];
+  DMRActivity activity;
+  {
+    DMRStateLock lock;
+    activity = dmrActivity[slotIndex];
+  }
   String html = "";
   
   String cardClass = activity.active ? "activity-card" : "activity-idle";
@@ -168,31 +183,31 @@ String getDMRSlotHTML(int slotIndex) {
   if (activity.active) {
     // Prominent callsign header
     html += "<div class='callsign-header'>";
-    if (activity.srcCallsign.length() > 0) {
+    if (activity.srcCallsign[0] != '\0') {
       html += "<a href='" + String(QRZ_LOOKUP_URL) + activity.srcCallsign + "' target='_blank' rel='noopener noreferrer'>" + activity.srcCallsign + "</a>";
     } else {
       html += "Unknown";
     }
     html += "</div>";
 
-    if (activity.srcName.length() > 0) {
+    if (activity.srcName[0] != '\0') {
       html += "<div class='metric'>";
       html += "<span class='metric-label'>Name:</span>";
-      html += "<span class='metric-value'>" + activity.srcName + "</span>";
+      html += "<span class='metric-value'>" + String(activity.srcName) + "</span>";
       html += "</div>";
     }
 
-    if (activity.srcCity.length() > 0) {
+    if (activity.srcCity[0] != '\0') {
       html += "<div class='metric'>";
       html += "<span class='metric-label'>City:</span>";
-      html += "<span class='metric-value'>" + activity.srcCity + "</span>";
+      html += "<span class='metric-value'>" + String(activity.srcCity) + "</span>";
       html += "</div>";
     }
 
-    if (activity.srcCountry.length() > 0) {
+    if (activity.srcCountry[0] != '\0') {
       html += "<div class='metric'>";
       html += "<span class='metric-label'>Country:</span>";
-      html += "<span class='metric-value'>" + activity.srcCountry + "</span>";
+      html += "<span class='metric-value'>" + String(activity.srcCountry) + "</span>";
       html += "</div>";
     }
 
@@ -210,7 +225,7 @@ String getDMRSlotHTML(int slotIndex) {
 
     html += "<div class='metric'>";
     html += "<span class='metric-label'>Type:</span>";
-    html += "<span class='metric-value'>" + activity.frameType + "</span>";
+    html += "<span class='metric-value'>" + String(dmrFrameTypeName(activity.frameType)) + "</span>";
     html += "</div>";
 
     // Calculate transmission duration from start time
@@ -243,12 +258,22 @@ void handleDMRSlot2() {
 
 // Helper function to generate DMR History HTML
 String getDMRHistoryHTML() {
+  // dmrHistory is updated by the DMR core task: copy it, format the copy unlocked
+  DMRHistory history[15];
+  int historyIndex;
+  {
+    DMRStateLock lock;
+    for (int i = 0; i < 15; i++) {
+      history[i] = dmrHistory[i];
+    }
+    historyIndex = dmrHistoryIndex;
+  }
   String html = "<div class='history-container'>";
   
   // Count actual history entries
   int entryCount = 0;
   for (int i = 0; i < 15; i++) {
-    if (dmrHistory[i].srcId > 0) entryCount++;
+    if (history[i].srcId > 0) entryCount++;
   }
   
   if (entryCount == 0) {
@@ -264,38 +289,38 @@ String getDMRHistoryHTML() {
     
     // Show entries in reverse chronological order (newest first)
     for (int i = 0; i < 15; i++) {
-      int index = (dmrHistoryIndex - 1 - i + 15) % 15;
-      if (dmrHistory[index].srcId > 0) {
-        html += "<div class='history-row' data-duration='" + String(dmrHistory[index].duration) + "'>";
+      int index = (historyIndex - 1 - i + 15) % 15;
+      if (history[index].srcId > 0) {
+        html += "<div class='history-row' data-duration='" + String(history[index].durationMs / 1000.0, 1) + "'>";
         
         // Time
-        html += "<div class='col-time'>" + dmrHistory[index].timestamp + "</div>";
+        html += "<div class='col-time'>" + history[index].timestamp + "</div>";
         
         // Station info
         html += "<div class='col-station'>";
-        if (dmrHistory[index].srcCallsign.length() > 0) {
-          html += "<div class='callsign'><a href='" + String(QRZ_LOOKUP_URL) + dmrHistory[index].srcCallsign + "' target='_blank' rel='noopener noreferrer'>" + dmrHistory[index].srcCallsign + "</a></div>";
-          if (dmrHistory[index].srcName.length() > 0) {
-            html += "<div class='name'>" + dmrHistory[index].srcName + "</div>";
+        if (history[index].srcCallsign.length() > 0) {
+          html += "<div class='callsign'><a href='" + String(QRZ_LOOKUP_URL) + history[index].srcCallsign + "' target='_blank' rel='noopener noreferrer'>" + history[index].srcCallsign + "</a></div>";
+          if (history[index].srcName.length() > 0) {
+            html += "<div class='name'>" + history[index].srcName + "</div>";
           }
-          if (dmrHistory[index].srcLocation.length() > 0) {
-            html += "<div class='location'>" + dmrHistory[index].srcLocation + "</div>";
+          if (history[index].srcLocation.length() > 0) {
+            html += "<div class='location'>" + history[index].srcLocation + "</div>";
           }
         } else {
-          html += "<div class='callsign'>" + String(dmrHistory[index].srcId) + "</div>";
+          html += "<div class='callsign'>" + String(history[index].srcId) + "</div>";
         }
         html += "</div>";
         
         // Destination
         html += "<div class='col-destination'>";
-        if (dmrHistory[index].isGroup) html += "TG ";
-        html += String(dmrHistory[index].dstId) + "</div>";
+        if (history[index].isGroup) html += "TG ";
+        html += String(history[index].dstId) + "</div>";
         
         // Duration
-        html += "<div class='col-duration'>" + String(dmrHistory[index].duration) + "s</div>";
+        html += "<div class='col-duration'>" + String(history[index].durationMs / 1000.0, 1) + "s</div>";
         
         // Slot
-        html += "<div class='col-slot'>" + String(dmrHistory[index].slotNo) + "</div>";
+        html += "<div class='col-slot'>" + String(history[index].slotNo) + "</div>";
         
         html += "</div>";
       }
@@ -12,6 +12,7 @@
 #include "../common/navigation.h"
 #include "../common/utils.h"
 #include "../common/server_utils.h"
+#include "../../DMRStateLock.h"
 
 // External variables and functions
 extern WebServer server;
@@ -114,7 +115,12 @@ void handleDMRConfig() {
   html += "<div class='card'>";
   html += "<h3>Current DMR Settings</h3>";
   String bmStatusClass = dmrLoggedIn ? "connected" : "disconnected";
-  html += "<div class='status " + bmStatusClass + "'>Status: " + dmrLoginStatus + "</div>";
+  String loginStatus;
+  {
+    DMRStateLock lock;  // Updated by the DMR core task
+    loginStatus = dmrLoginStatus;
+  }
+  html += "<div class='status " + bmStatusClass + "'>Status: " + loginStatus + "</div>";
   html += "<div class='metric'><span class='metric-label'>Callsign:</span><span class='metric-value'>" + dmr_callsign + "</span></div>";
   html += "<div class='metric'><span class='metric-label'>DMR ID:</span><span class='metric-value'>" + String(dmr_id) + "</span></div>";
   html += "<div class='metric'><span class='metric-label'>Server:</span><span class='metric-value'>" + getServerDisplayName(dmr_server) + "</span></div>";
@@ -399,10 +405,16 @@ void handleSaveDMRConfig() {
   if (server.hasArg("callsign") && server.hasArg("dmr_id") &&
       server.hasArg("server") && server.hasArg("password") && server.hasArg("essid")) {
 
-    dmr_callsign = server.arg("callsign");
+    {
+      DMRStateLock lock;  // The DMR core task copies these when it logs in
+      dmr_callsign = server.arg("callsign");
+      dmr_server = server.arg("server");
+      dmr_password = server.arg("password");
+      if (server.hasArg("location")) dmr_location = server.arg("location");
+      if (server.hasArg("description")) dmr_description = server.arg("description");
+      if (server.hasArg("url")) dmr_url = server.arg("url");
+    }
     dmr_id = server.arg("dmr_id").toInt();
-    dmr_server = server.arg("server");
-    dmr_password = server.arg("password");
     dmr_essid = server.arg("essid").toInt();
 
     // Update DMR mode enable/disable status
@@ -416,9 +428,6 @@ void handleSaveDMRConfig() {
     if (server.hasArg("latitude")) dmr_latitude = server.arg("latitude").toFloat();
     if (server.hasArg("longitude")) dmr_longitude = server.arg("longitude").toFloat();
     if (server.hasArg("height")) dmr_height = server.arg("height").toInt();
-    if (server.hasArg("location")) dmr_location = server.arg("location");
-    if (server.hasArg("description")) dmr_description = server.arg("description");
-    if (server.hasArg("url")) dmr_url = server.arg("url");
     if (server.hasArg("modem_type")) modem_type = server.arg("modem_type");
 
     // Validate DMR ID
@@ -13,6 +13,21 @@
 #include "../common/navigation.h"
 #include "../common/utils.h"
 #include "../common/server_utils.h"
+#include "../../ModemTxQueue.h"
+#include "../../MMDVMStatus.h"
+#include "../../MMDVMSerialReader.h"
+#include "../../DMRServerResolver.h"
+#include "../../DMRUplink.h"
+#include "../../UserCache.h"
+#include "../../UDPDrainStats.h"
+#include "../../DMRNetworkSocket.h"
+#include "../../DMRSessionSupervisor.h"
+#include "../../DMRStateLock.h"
+#include "../../TaskMonitor.h"
+#include "../../AllocationCounter.h"
+#ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
+#include "../../SDUserDatabase.h"
+#endif
 
 // External variables
 extern WebServer server;
@@ -23,9 +38,13 @@ extern bool dmrLoggedIn;
 extern uint32_t currentTalkgroup;
 extern String dmrLoginStatus;
 extern String dmr_callsign;
+extern TaskMonitor taskMonitor;
+extern AllocationCounter allocationCounter;
+extern uint32_t logLinesDropped;
 #ifdef LILYGO_T_ETH_ELITE_ESP32S3_MMDVM
 extern bool eth_connected;
 extern bool sdCardAvailable;
+extern SDUserDatabase userDatabase;
 extern String getEthIPAddress();
 extern String getEthMACAddress();
 extern int getEthLinkSpeed();
@@ -43,6 +62,18 @@ extern uint32_t dmr_tx_freq;
 extern uint8_t dmr_color_code;
 extern uint8_t dmr_power;
 extern String dmr_location;
+extern ModemTxQueue modemTxQueue;
+extern MMDVMStatus modemStatus;
+extern MMDVMSerialReader modemReader;
+extern DMRUplink dmrUplink;
+extern uint32_t dmrHeadersSynthesized;
+extern UDPDrainStats udpDrainStats;
+extern DMRNetworkSocket dmrSocket;
+extern DMRSessionSupervisor dmrSession;
+extern uint32_t talkerAliasDecoded;
+extern uint32_t talkerAliasLookupsSaved;
+extern DMRServerResolver dmrResolver;
+extern UserCache userCache;
 
 // Forward declaration
 String getStatusContent();
@@ -160,6 +191,21 @@ String getStatusContent() {
     html += "<div class='metric'><span class='metric-label'>Total Size:</span><span class='metric-value'>" + String((uint32_t)cardSize) + " MB</span></div>";
     html += "<div class='metric'><span class='metric-label'>Used:</span><span class='metric-value'>" + String((uint32_t)usedSize) + " MB</span></div>";
     html += "<div class='metric'><span class='metric-label'>Free:</span><span class='metric-value'>" + String((uint32_t)(cardSize - usedSize)) + " MB</span></div>";
+    SDUserDatabaseStats db = userDatabase.getStats();
+    html += "<div class='metric'><span class='metric-label'>User Database:</span><span class='metric-value'>" + String(SDUserDatabase::stateName(db.state));
+    if (db.state == DMR_DB_READY) {
+      html += ", " + String(db.entries) + " IDs" + String(db.compact ? " (compact)" : "");
+    }
+    html += "</span></div>";
+    if (db.state == DMR_DB_READY) {
+      if (!db.compact) {
+        html += "<div class='metric'><span class='metric-label'>Index Build:</span><span class='metric-value'>" + String(db.buildMs) + " ms</span></div>";
+      }
+      if (db.lookups > 0) {
+        html += "<div class='metric'><span class='metric-label'>DB Lookup (p99/max):</span><span class='metric-value'>" + String(db.p99LookupUs / 1000.0, 1) +
+                " / " + String(db.maxLookupUs / 1000.0, 1) + " ms, " + String(db.blockReads / db.lookups) + " reads</span></div>";
+      }
+    }
   } else {
     html += "<div class='status disconnected'>Status: Not Available</div>";
     html += "<div class='metric'><span class='metric-label'>Info:</span><span class='metric-value'>No card inserted</span></div>";
@@ -171,8 +217,52 @@ String getStatusContent() {
   html += "<div class='card'>";
   html += "<h3>DMR Network Status</h3>";
   String bmStatusClass = dmrLoggedIn ? "connected" : "disconnected";
-  html += "<div class='status " + bmStatusClass + "'>Status: " + dmrLoginStatus + "</div>";
+  String loginStatus;
+  {
+    DMRStateLock lock;
+    loginStatus = dmrLoginStatus;
+  }
+  html += "<div class='status " + bmStatusClass + "'>Status: " + loginStatus + "</div>";
   html += "<div class='metric'><span class='metric-label'>Server:</span><span class='metric-value'>" + getServerDisplayName(dmr_server) + "</span></div>";
+  DMRSessionStats session = dmrSession.getStats();
+  if (session.connected) {
+    html += "<div class='metric'><span class='metric-label'>Keepalive:</span><span class='metric-value'>last pong " + String(session.lastPongAgeMs / 1000) +
+            " s ago, " + String(session.lastRttMs) + " ms RTT, " + String(session.missedPongs) + " missed</span></div>";
+  }
+  if (session.outages > 0) {
+    html += "<div class='metric'><span class='metric-label'>Outages (recover last/max):</span><span class='metric-value'>" + String(session.outages) + ", " +
+            String(session.lastRecoverMs / 1000.0, 1) + " / " + String(session.maxRecoverMs / 1000.0, 1) + " s (last: " +
+            dmrSessionEventName(session.lastEvent) + ")</span></div>";
+  }
+  DMRServerResolverStats dns = dmrResolver.getStats();
+  html += "<div class='metric'><span class='metric-label'>Server Address:</span><span class='metric-value'>" + dmrResolver.getAddressString() + "</span></div>";
+  if (!dns.numeric) {
+    html += "<div class='metric'><span class='metric-label'>DNS Lookup (last/max):</span><span class='metric-value'>" + String(dns.lastResolveMs) +
+            " / " + String(dns.maxResolveMs) + " ms, " + String(dns.failures) + " failed</span></div>";
+  }
+  html += "<div class='metric'><span class='metric-label'>UDP Drain (peak queued):</span><span class='metric-value'>" + String(udpDrainStats.peakPending) +
+          " pkts, " + String(udpDrainStats.maxPassUs) + " us max, " + String(udpDrainStats.budgetHits) + " over budget</span></div>";
+  String drainHistogram;
+  for (uint8_t b = 0; b < UDP_DRAIN_BUCKETS; b++) {
+    if (b > 0) drainHistogram += ", ";
+    drainHistogram += String(udpDrainBucketLabel(b)) + ": " + String(udpDrainStats.histogram[b]);
+  }
+  html += "<div class='metric'><span class='metric-label'>Queued at Pass Start:</span><span class='metric-value'>" + drainHistogram + "</span></div>";
+  DMRNetworkSocketStats net = dmrSocket.getStats();
+  html += "<div class='metric'><span class='metric-label'>Network RX Latency (avg/max):</span><span class='metric-value'>" +
+          String(net.avgLatencyUs / 1000.0, 1) + " / " + String(net.maxLatencyUs / 1000.0, 1) + " ms (" + (net.async ? "callback" : "polled") +
+          (net.queueFull + net.oversize + net.poolEmpty > 0 ? ", " + String(net.queueFull + net.oversize + net.poolEmpty) + " dropped" : "") + ")</span></div>";
+  AllocationStats allocs = allocationCounter.getStats();
+  if (allocs.available) {
+    html += "<div class='metric'><span class='metric-label'>Heap Allocs per Frame:</span><span class='metric-value'>" +
+            String(allocs.allocFrames) + " of " + String(allocs.frames) + " frames (" + String(allocs.allocs) + " allocs)</span></div>";
+  }
+  UserCacheStats cache = userCache.getStats();
+  uint32_t cacheLookups = cache.hits + cache.misses;
+  html += "<div class='metric'><span class='metric-label'>User Cache:</span><span class='metric-value'>" + String(cache.entries) + "/" + String(cache.capacity) +
+          " (" + String(cacheLookups > 0 ? cache.hits * 100 / cacheLookups : 0) + "% hits)</span></div>";
+  html += "<div class='metric'><span class='metric-label'>Talker Alias:</span><span class='metric-value'>" + String(talkerAliasDecoded) +
+          " decoded, " + String(talkerAliasLookupsSaved) + " before lookup</span></div>";
   html += "<div class='metric'><span class='metric-label'>Callsign:</span><span class='metric-value'>" + dmr_callsign + "</span></div>";
   html += "<div class='metric'><span class='metric-label'>DMR ID:</span><span class='metric-value'>" + String(dmr_id) + "</span></div>";
   if (dmr_essid > 0) {
@@ -193,7 +283,65 @@ String getStatusContent() {
   html += "<div class='metric'><span class='metric-label'>RX Frequency:</span><span class='metric-value'>" + String(dmr_rx_freq/1000000.0, 3) + " MHz</span></div>";
   html += "<div class='metric'><span class='metric-label'>TX Frequency:</span><span class='metric-value'>" + String(dmr_tx_freq/1000000.0, 3) + " MHz</span></div>";
   html += "<div class='metric'><span class='metric-label'>Color Code:</span><span class='metric-value'>" + String(dmr_color_code) + "</span></div>";
+  html += "<div class='metric'><span class='metric-label'>DMR Mode:</span><span class='metric-value'>" + String(MMDVM_DUPLEX ? "Duplex (TS1 + TS2)" : "Simplex") + "</span></div>";
   html += "<div class='metric'><span class='metric-label'>Power Level:</span><span class='metric-value'>" + String(dmr_power) + "</span></div>";
+  if (modemStatus.valid) {
+    html += "<div class='metric'><span class='metric-label'>Modem Mode:</span><span class='metric-value'>" + String(getMMDVMModeName(modemStatus.mode)) +
+            (modemStatus.tx ? " (TX)" : "") + "</span></div>";
+    html += "<div class='metric'><span class='metric-label'>DMR Buffer Space:</span><span class='metric-value'>TS1 " + String(modemStatus.dmrSpace1) +
+            " / TS2 " + String(modemStatus.dmrSpace2) + "</span></div>";
+    html += "<div class='metric'><span class='metric-label'>Overflows (RX/TX):</span><span class='metric-value'>" + String(modemStatus.rxOverflows) +
+            " / " + String(modemStatus.txOverflows) + "</span></div>";
+  } else {
+    html += "<div class='metric'><span class='metric-label'>Modem Status:</span><span class='metric-value'>No status reply</span></div>";
+  }
+  html += "<div class='metric'><span class='metric-label'>TX Pacing:</span><span class='metric-value'>" +
+          String(modemTxQueue.isFlowControlled() ? "Modem buffer space" : "Fixed 60 ms") + "</span></div>";
+  for (uint8_t slot = 1; slot <= 2; slot++) {
+    ModemTxQueueStats txq = modemTxQueue.getStats(slot);
+    html += "<div class='metric'><span class='metric-label'>TX Queue TS" + String(slot) + ":</span><span class='metric-value'>" +
+            String(txq.depth) + "/" + String(MODEM_TX_QUEUE_DEPTH) + " (peak " + String(txq.peakDepth) + ")</span></div>";
+    html += "<div class='metric'><span class='metric-label'>TS" + String(slot) + " Underruns / Overflows:</span><span class='metric-value'>" +
+            String(txq.underruns) + " / " + String(txq.overflows) + "</span></div>";
+    DMRJitterStats jit = modemTxQueue.getJitterStats(slot);
+    html += "<div class='metric'><span class='metric-label'>TS" + String(slot) + " Jitter Buffer:</span><span class='metric-value'>" +
+            String(jit.target) + " frames (" + String(jit.jitterMs) + " ms jitter)</span></div>";
+    html += "<div class='metric'><span class='metric-label'>TS" + String(slot) + " Reordered / Dup / Late:</span><span class='metric-value'>" +
+            String(jit.reordered) + " / " + String(jit.duplicates) + " / " + String(jit.late) + "</span></div>";
+    html += "<div class='metric'><span class='metric-label'>TS" + String(slot) + " Lost (concealed):</span><span class='metric-value'>" +
+            String(jit.lost) + " (" + String(jit.concealed) + ")</span></div>";
+  }
+  html += "<div class='metric'><span class='metric-label'>Headers Synthesized:</span><span class='metric-value'>" +
+          String(dmrHeadersSynthesized) + "</span></div>";
+  DMRUplinkStats up = dmrUplink.getStats();
+  html += "<div class='metric'><span class='metric-label'>RF Uplink (calls/frames):</span><span class='metric-value'>" + String(up.calls) +
+          " / " + String(up.packets) + (up.lateEntries > 0 ? " (" + String(up.lateEntries) + " late entry)" : "") + (up.noCall > 0 ? " (" + String(up.noCall) + " without header)" : "") +
+          (up.badHeaders > 0 ? " (" + String(up.badHeaders) + " bad headers)" : "") + "</span></div>";
+  html += "<div class='metric'><span class='metric-label'>RF Uplink Latency (avg/max):</span><span class='metric-value'>" +
+          String(up.avgLatencyUs / 1000.0, 1) + " / " + String(up.maxLatencyUs / 1000.0, 1) + " ms</span></div>";
+  MMDVMSerialReaderStats rxs = modemReader.getStats();
+  html += "<div class='metric'><span class='metric-label'>RX Frames (resyncs):</span><span class='metric-value'>" + String(rxs.frames) +
+          " (" + String(rxs.invalid + rxs.timeouts) + ")</span></div>";
+  html += "<div class='metric'><span class='metric-label'>RX Latency (avg/max):</span><span class='metric-value'>" +
+          String(rxs.avgLatencyUs / 1000.0, 1) + " / " + String(rxs.maxLatencyUs / 1000.0, 1) + " ms</span></div>";
+  html += "</div>";
+
+  // Tasks Card
+  html += "<div class='card'>";
+  html += "<h3>Tasks</h3>";
+  for (uint8_t i = 0; i < taskMonitor.size(); i++) {
+    TaskMonitorStats ts = taskMonitor.getStats(i);
+    if (!ts.running) continue;
+    String detail = "core " + String(ts.core < 0 ? "any" : String(ts.core)) + ", prio " + String(ts.priority) +
+                    ", " + String(ts.stackFree) + " B free";
+    if (ts.measured) {
+      detail = String(ts.cpuPercent) + "% (max " + String(ts.maxPassUs / 1000.0, 1) + " ms), " + detail;
+    }
+    html += "<div class='metric'><span class='metric-label'>" + String(ts.name) + ":</span><span class='metric-value'>" +
+            detail + "</span></div>";
+  }
+  html += "<div class='metric'><span class='metric-label'>Log Lines Dropped:</span><span class='metric-value'>" +
+          String(logLinesDropped) + "</span></div>";
   html += "</div>";
 
   // Station Information Card
@@ -218,4 +366,171 @@ void handleStatusData() {
   server.send(200, "text/html", getStatusContent());
 }
 
+// Modem status (last CMD_GET_STATUS reply) and TX queue counters as JSON
+void handleModemStatus() {
+  if (!checkAuthentication()) return;
+
+  String json = "{";
+  json += "\"ready\":" + String(mmdvmReady ? "true" : "false");
+  json += ",\"valid\":" + String(modemStatus.valid ? "true" : "false");
+  json += ",\"protocol\":" + String(modemStatus.protocolVersion);
+  json += ",\"mode\":" + String(modemStatus.mode);
+  json += ",\"modeName\":\"" + String(getMMDVMModeName(modemStatus.mode)) + "\"";
+  json += ",\"tx\":" + String(modemStatus.tx ? "true" : "false");
+  json += ",\"carrierDetect\":" + String(modemStatus.carrierDetect ? "true" : "false");
+  json += ",\"lockout\":" + String(modemStatus.lockout ? "true" : "false");
+  json += ",\"overflow\":{\"adc\":" + String(modemStatus.adcOverflow ? "true" : "false") +
+          ",\"dac\":" + String(modemStatus.dacOverflow ? "true" : "false") +
+          ",\"rx\":" + String(modemStatus.rxOverflow ? "true" : "false") +
+          ",\"tx\":" + String(modemStatus.txOverflow ? "true" : "false") + "}";
+  json += ",\"space\":{\"dstar\":" + String(modemStatus.dstarSpace) +
+          ",\"dmr1\":" + String(modemStatus.dmrSpace1) +
+          ",\"dmr2\":" + String(modemStatus.dmrSpace2) +
+          ",\"ysf\":" + String(modemStatus.ysfSpace) +
+          ",\"p25\":" + String(modemStatus.p25Space) +
+          ",\"nxdn\":" + String(modemStatus.nxdnSpace) +
+          ",\"pocsag\":" + String(modemStatus.pocsagSpace) + "}";
+  json += ",\"ageMs\":" + String(modemStatus.valid ? millis() - modemStatus.lastUpdate : 0);
+  json += ",\"polls\":" + String(modemStatus.polls);
+  json += ",\"replies\":" + String(modemStatus.replies);
+  json += ",\"rxOverflows\":" + String(modemStatus.rxOverflows);
+  json += ",\"txOverflows\":" + String(modemStatus.txOverflows);
+  json += ",\"nakNoSpace\":" + String(modemStatus.nakNoSpace);
+  json += ",\"flowControl\":" + String(modemTxQueue.isFlowControlled() ? "true" : "false");
+  json += ",\"txQueue\":[";
+  for (uint8_t slot = 1; slot <= 2; slot++) {
+    ModemTxQueueStats txq = modemTxQueue.getStats(slot);
+    if (slot > 1) json += ",";
+    json += "{\"slot\":" + String(slot) +
+            ",\"depth\":" + String(txq.depth) +
+            ",\"peakDepth\":" + String(txq.peakDepth) +
+            ",\"enqueued\":" + String(txq.enqueued) +
+            ",\"played\":" + String(txq.played) +
+            ",\"underruns\":" + String(txq.underruns) +
+            ",\"overflows\":" + String(txq.overflows) +
+            ",\"waitForSpace\":" + String(txq.waitForSpace) + "}";
+  }
+  json += "]";
+  json += ",\"jitter\":[";
+  for (uint8_t slot = 1; slot <= 2; slot++) {
+    DMRJitterStats jit = modemTxQueue.getJitterStats(slot);
+    if (slot > 1) json += ",";
+    json += "{\"slot\":" + String(slot) +
+            ",\"depth\":" + String(jit.depth) +
+            ",\"target\":" + String(jit.target) +
+            ",\"jitterMs\":" + String(jit.jitterMs) +
+            ",\"received\":" + String(jit.received) +
+            ",\"played\":" + String(jit.played) +
+            ",\"reordered\":" + String(jit.reordered) +
+            ",\"duplicates\":" + String(jit.duplicates) +
+            ",\"late\":" + String(jit.late) +
+            ",\"lost\":" + String(jit.lost) +
+            ",\"concealed\":" + String(jit.concealed) +
+            ",\"resyncs\":" + String(jit.resyncs) + "}";
+  }
+  json += "]";
+  json += ",\"duplex\":" + String(MMDVM_DUPLEX ? "true" : "false");
+  json += ",\"headersSynthesized\":" + String(dmrHeadersSynthesized);
+  json += ",\"udpDrain\":{\"passes\":" + String(udpDrainStats.passes) +
+          ",\"packets\":" + String(udpDrainStats.packets) +
+          ",\"budgetHits\":" + String(udpDrainStats.budgetHits) +
+          ",\"peakPending\":" + String(udpDrainStats.peakPending) +
+          ",\"lastPassUs\":" + String(udpDrainStats.lastPassUs) +
+          ",\"maxPassUs\":" + String(udpDrainStats.maxPassUs) +
+          ",\"histogram\":[";
+  for (uint8_t b = 0; b < UDP_DRAIN_BUCKETS; b++) {
+    if (b > 0) json += ",";
+    json += String(udpDrainStats.histogram[b]);
+  }
+  json += "]}";
+  DMRUplinkStats up = dmrUplink.getStats();
+  json += ",\"uplink\":{\"calls\":" + String(up.calls) +
+          ",\"lateEntries\":" + String(up.lateEntries) +
+          ",\"packets\":" + String(up.packets) +
+          ",\"sendErrors\":" + String(up.sendErrors) +
+          ",\"noCall\":" + String(up.noCall) +
+          ",\"badHeaders\":" + String(up.badHeaders) +
+          ",\"unsupported\":" + String(up.unsupported) +
+          ",\"lastLatencyUs\":" + String(up.lastLatencyUs) +
+          ",\"avgLatencyUs\":" + String(up.avgLatencyUs) +
+          ",\"maxLatencyUs\":" + String(up.maxLatencyUs) + "}";
+  DMRNetworkSocketStats net = dmrSocket.getStats();
+  json += ",\"networkRx\":{\"async\":" + String(net.async ? "true" : "false") +
+          ",\"frames\":" + String(net.frames) +
+          ",\"dmrd\":" + String(net.dmrd) +
+          ",\"control\":" + String(net.control) +
+          ",\"oversize\":" + String(net.oversize) +
+          ",\"queueFull\":" + String(net.queueFull) +
+          ",\"poolEmpty\":" + String(net.poolEmpty) +
+          ",\"poolInUse\":" + String(net.poolInUse) +
+          ",\"poolPeak\":" + String(net.poolPeak) +
+          ",\"queueDepth\":" + String(net.queueDepth) +
+          ",\"peakQueueDepth\":" + String(net.peakQueueDepth) +
+          ",\"lastLatencyUs\":" + String(net.lastLatencyUs) +
+          ",\"avgLatencyUs\":" + String(net.avgLatencyUs) +
+          ",\"maxLatencyUs\":" + String(net.maxLatencyUs) + "}";
+  DMRSessionStats session = dmrSession.getStats();
+  json += ",\"session\":{\"connected\":" + String(session.connected ? "true" : "false") +
+          ",\"outage\":" + String(session.outage ? "true" : "false") +
+          ",\"pings\":" + String(session.pings) +
+          ",\"pongs\":" + String(session.pongs) +
+          ",\"missedPongs\":" + String(session.missedPongs) +
+          ",\"lastRttMs\":" + String(session.lastRttMs) +
+          ",\"lastPongAgeMs\":" + String(session.lastPongAgeMs) +
+          ",\"attempts\":" + String(session.attempts) +
+          ",\"failures\":" + String(session.failures) +
+          ",\"closes\":" + String(session.closes) +
+          ",\"naks\":" + String(session.naks) +
+          ",\"outages\":" + String(session.outages) +
+          ",\"recoveries\":" + String(session.recoveries) +
+          ",\"lastRecoverMs\":" + String(session.lastRecoverMs) +
+          ",\"maxRecoverMs\":" + String(session.maxRecoverMs) +
+          ",\"avgRecoverMs\":" + String(session.recoveries > 0 ? session.totalRecoverMs / session.recoveries : 0) +
+          ",\"backoffStep\":" + String(session.backoffStep) +
+          ",\"retryInMs\":" + String(session.retryInMs) +
+          ",\"lastEvent\":\"" + dmrSessionEventName(session.lastEvent) + "\"}";
+  AllocationStats allocs = allocationCounter.getStats();
+  json += ",\"frameAllocs\":{\"available\":" + String(allocs.available ? "true" : "false") +
+          ",\"frames\":" + String(allocs.frames) +
+          ",\"allocFrames\":" + String(allocs.allocFrames) +
+          ",\"allocs\":" + String(allocs.allocs) +
+          ",\"eventFrames\":" + String(allocs.eventFrames) +
+          ",\"eventAllocs\":" + String(allocs.eventAllocs) + "}";
+  MMDVMSerialReaderStats rxs = modemReader.getStats();
+  json += ",\"rxReader\":{\"running\":" + String(modemReader.isRunning() ? "true" : "false") +
+          ",\"frames\":" + String(rxs.frames) +
+          ",\"longFrames\":" + String(rxs.longFrames) +
+          ",\"invalid\":" + String(rxs.invalid) +
+          ",\"skippedBytes\":" + String(rxs.skippedBytes) +
+          ",\"timeouts\":" + String(rxs.timeouts) +
+          ",\"ringFull\":" + String(rxs.ringFull) +
+          ",\"bytes\":" + String(rxs.bytes) +
+          ",\"queueDepth\":" + String(rxs.queueDepth) +
+          ",\"peakQueueDepth\":" + String(rxs.peakQueueDepth) +
+          ",\"lastLatencyUs\":" + String(rxs.lastLatencyUs) +
+          ",\"avgLatencyUs\":" + String(rxs.avgLatencyUs) +
+          ",\"maxLatencyUs\":" + String(rxs.maxLatencyUs) + "}";
+  json += ",\"tasks\":[";
+  bool firstTask = true;
+  for (uint8_t i = 0; i < taskMonitor.size(); i++) {
+    TaskMonitorStats ts = taskMonitor.getStats(i);
+    if (!ts.running) continue;
+    if (!firstTask) json += ",";
+    firstTask = false;
+    json += "{\"name\":\"" + String(ts.name) + "\"" +
+            ",\"core\":" + String(ts.core) +
+            ",\"priority\":" + String(ts.priority) +
+            ",\"stackFree\":" + String(ts.stackFree);
+    if (ts.measured) {
+      json += ",\"cpuPercent\":" + String(ts.cpuPercent) +
+              ",\"maxPassUs\":" + String(ts.maxPassUs);
+    }
+    json += "}";
+  }
+  json += "]";
+  json += ",\"logLinesDropped\":" + String(logLinesDropped);
+  json += "}";
+  server.send(200, "application/json", json);
+}
+
 #endif // WEB_PAGES_STATUS_H